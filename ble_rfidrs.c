@@ -70,6 +70,9 @@
 #define BLE_UUID_RFIDRS_PCKT_DATA2_CHAR     0x0007        //The UUID of the packet data - section 2 Characteristic.
 #define BLE_UUID_RFIDRS_WAVFM_DATA_CHAR     0x0008        //The UUID of the waveform data characteristic.
 #define BLE_UUID_RFIDRS_LOG_MESSGE_CHAR     0x0009        //The UUID of the log message characteristic.
+#define BLE_UUID_RFIDRS_SPI_STATS_CHAR      0x000A        //The UUID of the SPI link statistics characteristic.
+#define BLE_UUID_RFIDRS_CHAN_PLAN_CHAR      0x000B        //The UUID of the regional channel plan characteristic.
+#define BLE_UUID_RFIDRS_PLL_STATS_CHAR      0x000C        //The UUID of the PLL lock statistics characteristic.
 
 #define RFIDRS_BASE_UUID                    {{0x15, 0x59, 0x3B, 0x84, 0xE5, 0x26, 0x46, 0xAD, 0xB5, 0x8D, 0x1D, 0xFC, 0x00, 0x00, 0x56, 0xE7}}
 
@@ -147,6 +150,14 @@ static void on_write(ble_rfidrs_t * p_rfidrs, ble_evt_t * p_ble_evt)
         }
 
     }
+    else if (
+         (p_evt_write->handle == p_rfidrs->chan_plan_handles.value_handle)
+         &&
+         (p_rfidrs->chan_plan_handler != NULL)
+       )
+    {
+        p_rfidrs->chan_plan_handler(p_rfidrs, p_evt_write->data, p_evt_write->len);
+    }
     else if (
          (p_evt_write->handle == p_rfidrs->program_epc_handles.value_handle)
          &&
@@ -784,6 +795,160 @@ static uint32_t log_messge_char_add(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_in
                                            &p_rfidrs->log_messge_handles);
 }
 
+//Function and comments template from Nordic SDK v8.0, built the same way as the characteristics above.
+
+//The SPI link statistics characteristic is read-only and is not notified. The firmware updates its value and the iDevice reads it when it wants.
+
+static uint32_t spi_stats_char_add(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_init_t * p_rfidrs_init)
+{
+    //Adding proprietary characteristic to S110 SoftDevice
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_t    attr_char_value;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_attr_md_t attr_md;
+    uint8_t             initial_value[BLE_RFIDRS_SPI_STATS_CHAR_LEN]    =    {0};
+
+    memset(&char_md, 0, sizeof(char_md));
+
+    char_md.char_props.read   = 1;
+    char_md.p_char_user_desc  = NULL;
+    char_md.p_char_pf         = NULL;
+    char_md.p_user_desc_md    = NULL;
+    char_md.p_cccd_md         = NULL;
+    char_md.p_sccd_md         = NULL;
+
+    ble_uuid.type = p_rfidrs->uuid_type;
+    ble_uuid.uuid = BLE_UUID_RFIDRS_SPI_STATS_CHAR;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.write_perm);
+
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    attr_md.rd_auth = 0;
+    attr_md.wr_auth = 0;
+    attr_md.vlen    = 0;
+
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = BLE_RFIDRS_SPI_STATS_CHAR_LEN;
+    attr_char_value.init_offs = 0;
+    attr_char_value.max_len   = BLE_RFIDRS_SPI_STATS_CHAR_LEN;
+    attr_char_value.p_value   = initial_value;
+
+    return sd_ble_gatts_characteristic_add(p_rfidrs->service_handle,
+                                           &char_md,
+                                           &attr_char_value,
+                                           &p_rfidrs->spi_stats_handles);
+}
+
+//Function and comments template from Nordic SDK v8.0, built the same way as the characteristics above.
+
+//The PLL lock statistics characteristic works the same way as the SPI link statistics one.
+
+static uint32_t pll_stats_char_add(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_init_t * p_rfidrs_init)
+{
+    //Adding proprietary characteristic to S110 SoftDevice
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_t    attr_char_value;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_attr_md_t attr_md;
+    uint8_t             initial_value[BLE_RFIDRS_PLL_STATS_CHAR_LEN]    =    {0};
+
+    memset(&char_md, 0, sizeof(char_md));
+
+    char_md.char_props.read   = 1;
+    char_md.p_char_user_desc  = NULL;
+    char_md.p_char_pf         = NULL;
+    char_md.p_user_desc_md    = NULL;
+    char_md.p_cccd_md         = NULL;
+    char_md.p_sccd_md         = NULL;
+
+    ble_uuid.type = p_rfidrs->uuid_type;
+    ble_uuid.uuid = BLE_UUID_RFIDRS_PLL_STATS_CHAR;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr_md.write_perm);
+
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    attr_md.rd_auth = 0;
+    attr_md.wr_auth = 0;
+    attr_md.vlen    = 0;
+
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = BLE_RFIDRS_PLL_STATS_CHAR_LEN;
+    attr_char_value.init_offs = 0;
+    attr_char_value.max_len   = BLE_RFIDRS_PLL_STATS_CHAR_LEN;
+    attr_char_value.p_value   = initial_value;
+
+    return sd_ble_gatts_characteristic_add(p_rfidrs->service_handle,
+                                           &char_md,
+                                           &attr_char_value,
+                                           &p_rfidrs->pll_stats_handles);
+}
+
+//Function and comments template from Nordic SDK v8.0, built the same way as the characteristics above.
+
+//The channel plan characteristic is written by the iDevice to select the regional channel plan and hop seed.
+//It is readable so that the iDevice can confirm which plan is in use. main.c keeps the value up to date, including after a plan is restored from flash.
+//The new plan takes effect at the next hop.
+
+static uint32_t chan_plan_char_add(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_init_t * p_rfidrs_init)
+{
+    //Adding proprietary characteristic to S110 SoftDevice
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_t    attr_char_value;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_attr_md_t attr_md;
+    uint8_t             initial_value[BLE_RFIDRS_CHAN_PLAN_CHAR_LEN]    =    {0};
+
+    memset(&char_md, 0, sizeof(char_md));
+
+    char_md.char_props.read          = 1;
+    char_md.char_props.write         = 1;
+    char_md.char_props.write_wo_resp = 1;
+    char_md.p_char_user_desc         = NULL;
+    char_md.p_char_pf                = NULL;
+    char_md.p_user_desc_md           = NULL;
+    char_md.p_cccd_md                = NULL;
+    char_md.p_sccd_md                = NULL;
+
+    ble_uuid.type = p_rfidrs->uuid_type;
+    ble_uuid.uuid = BLE_UUID_RFIDRS_CHAN_PLAN_CHAR;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.write_perm);
+
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    attr_md.rd_auth = 0;
+    attr_md.wr_auth = 0;
+    attr_md.vlen    = 1;
+
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = BLE_RFIDRS_CHAN_PLAN_CHAR_LEN;
+    attr_char_value.init_offs = 0;
+    attr_char_value.max_len   = BLE_RFIDRS_CHAN_PLAN_CHAR_LEN;
+    attr_char_value.p_value   = initial_value;
+
+    return sd_ble_gatts_characteristic_add(p_rfidrs->service_handle,
+                                           &char_md,
+                                           &attr_char_value,
+                                           &p_rfidrs->chan_plan_handles);
+}
+
 //Superlative Semiconductor note: Function and comments template from Nordic SDK v8.0.
 //Function modified by Superlative Semiconductor to fit the UHF RFID reader project.
 
@@ -839,6 +1004,7 @@ uint32_t ble_rfidrs_init(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_init_t * p_rf
     p_rfidrs->program_epc_handler                 = p_rfidrs_init->program_epc_handler;
     p_rfidrs->read_state_handler                  = p_rfidrs_init->read_state_handler;
     p_rfidrs->pckt_data1_handler                  = p_rfidrs_init->pckt_data1_handler;
+    p_rfidrs->chan_plan_handler                   = p_rfidrs_init->chan_plan_handler;
     p_rfidrs->is_target_epc_indication_enabled    = false;
     p_rfidrs->is_program_epc_indication_enabled   = false;
     p_rfidrs->is_read_state_indication_enabled    = false;
@@ -922,6 +1088,27 @@ uint32_t ble_rfidrs_init(ble_rfidrs_t * p_rfidrs, const ble_rfidrs_init_t * p_rf
         return err_code;
     }
 
+    // Add the SPI link statistics Characteristic.
+    err_code = spi_stats_char_add(p_rfidrs, p_rfidrs_init);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    // Add the channel plan Characteristic.
+    err_code = chan_plan_char_add(p_rfidrs, p_rfidrs_init);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    // Add the PLL lock statistics Characteristic.
+    err_code = pll_stats_char_add(p_rfidrs, p_rfidrs_init);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
     return NRF_SUCCESS;
 }
 
@@ -1162,3 +1349,81 @@ uint32_t ble_rfidrs_log_messge_send(ble_rfidrs_t * p_rfidrs, uint8_t * p_string,
 
     return sd_ble_gatts_hvx(p_rfidrs->conn_handle, &hvx_params);
 }
+
+//Function call to update the value of the "SPI link statistics" characteristic. There is no notification; the iDevice reads the value when it wants it.
+//This works whether or not a connection is up.
+
+uint32_t ble_rfidrs_spi_stats_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_string, uint16_t length)
+{
+    ble_gatts_value_t gatts_value;
+
+    if (p_rfidrs == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (length > BLE_RFIDRS_SPI_STATS_CHAR_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&gatts_value, 0, sizeof(gatts_value));
+
+    gatts_value.len     = length;
+    gatts_value.offset  = 0;
+    gatts_value.p_value = p_string;
+
+    return sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, p_rfidrs->spi_stats_handles.value_handle, &gatts_value);
+}
+
+//Function call to update the value of the "PLL lock statistics" characteristic. There is no notification; the iDevice reads the value when it wants it.
+//This works whether or not a connection is up.
+
+uint32_t ble_rfidrs_pll_stats_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_string, uint16_t length)
+{
+    ble_gatts_value_t gatts_value;
+
+    if (p_rfidrs == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (length > BLE_RFIDRS_PLL_STATS_CHAR_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&gatts_value, 0, sizeof(gatts_value));
+
+    gatts_value.len     = length;
+    gatts_value.offset  = 0;
+    gatts_value.p_value = p_string;
+
+    return sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, p_rfidrs->pll_stats_handles.value_handle, &gatts_value);
+}
+
+//Function call to update the value of the "channel plan" characteristic. There is no notification; the iDevice reads the value when it wants it.
+//This works whether or not a connection is up.
+
+uint32_t ble_rfidrs_chan_plan_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_string, uint16_t length)
+{
+    ble_gatts_value_t gatts_value;
+
+    if (p_rfidrs == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (length > BLE_RFIDRS_CHAN_PLAN_CHAR_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&gatts_value, 0, sizeof(gatts_value));
+
+    gatts_value.len     = length;
+    gatts_value.offset  = 0;
+    gatts_value.p_value = p_string;
+
+    return sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, p_rfidrs->chan_plan_handles.value_handle, &gatts_value);
+}
@@ -71,6 +71,10 @@
 #define BLE_RFIDRS_MAX_DATA_LEN (GATT_MTU_SIZE_DEFAULT - 3) //Maximum length of data (in bytes) that can be transmitted to the peer by the RFIDR service module.
 
 #define BLE_RFIDRS_WRTE_STATE_CHAR_LEN    1                 //There will be less than 16 states so we need 1 byte only to cover this
+#define BLE_RFIDRS_WRTE_STATE_MASK        0x0F              //The requested state lives in the low nibble of the write state byte
+#define BLE_RFIDRS_WRTE_STATE_PACKED_REPORTS 0x80           //Set by the iDevice to receive inventory results in the packed multi-tag format
+#define BLE_RFIDRS_WRTE_STATE_DEDUP_REPORTS  0x40           //Set by the iDevice to only hear about new tags, or tags whose magnitude has changed, during inventory
+#define BLE_RFIDRS_WRTE_STATE_RANGE_REPORTS  0x20           //Set by the iDevice to receive on-reader PDOA ranges instead of raw hop/skip magnitudes during tracking
 #define BLE_RFIDRS_TARGET_EPC_CHAR_LEN    12                //We will use a maximum of 12 EPC bytes (96b) here
 #define BLE_RFIDRS_PROGRAM_EPC_CHAR_LEN   12                //We will strictly use 12 EPC bytes (96b) here
 #define BLE_RFIDRS_READ_STATE_CHAR_LEN    1                 //There will be less than 16 states so we need 1 byte only to cover this
@@ -78,6 +82,9 @@
 #define BLE_RFIDRS_PCKT_DATA2_CHAR_LEN    16                //See rfidr_radio.c for new definitions
 #define BLE_RFIDRS_WAVFM_DATA_CHAR_LEN    20                //Send over the maximum number of data bits in a BTLE packet
 #define BLE_RFIDRS_LOG_MESSGE_CHAR_LEN    20                //Send over the maximum number of data bits in a BTLE packet
+#define BLE_RFIDRS_SPI_STATS_CHAR_LEN     18                //SPI clock in kHz, then retry and failure counts for each of the 4 FPGA memories, all 16b LSB first
+#define BLE_RFIDRS_CHAN_PLAN_CHAR_LEN     2                 //Regional channel plan (see rfidr_chplan.h), then hop sequence seed
+#define BLE_RFIDRS_PLL_STATS_CHAR_LEN     18                //SX1257 PLL settle time histogram (see rfidr_sx1257.h), then lock timeouts, all 16b LSB first
 
 //Forward declaration of the ble_rfidrs_t type.
 typedef struct ble_rfidrs_s ble_rfidrs_t;
@@ -113,6 +120,9 @@ typedef void (*ble_rfidrs_read_state_handler_t) (ble_rfidrs_t * p_rfidrs, ble_rf
 //RFIDR Service event handler type (hvc).
 typedef void (*ble_rfidrs_pckt_data1_handler_t) (ble_rfidrs_t * p_rfidrs, ble_rfidrs_hvc_evt_t * p_evt);
 
+//RFIDR Service event handler type (data).
+typedef void (*ble_rfidrs_chan_plan_handler_t) (ble_rfidrs_t * p_rfidrs, uint8_t * p_data, uint16_t length);
+
 //Superlative Semiconductor note: Declaration and comments template from Nordic SDK v8.0.
 //Function modified by Superlative Semiconductor to fit the UHF RFID reader project.
 
@@ -128,6 +138,7 @@ typedef struct
     ble_rfidrs_program_epc_handler_t       program_epc_handler;
     ble_rfidrs_read_state_handler_t        read_state_handler;
     ble_rfidrs_pckt_data1_handler_t        pckt_data1_handler;
+    ble_rfidrs_chan_plan_handler_t         chan_plan_handler;
 } ble_rfidrs_init_t;
 
 //Superlative Semiconductor note: Declaration and comments template from Nordic SDK v8.0.
@@ -148,6 +159,9 @@ struct ble_rfidrs_s
     ble_gatts_char_handles_t           pckt_data2_handles;                  //Handles related to the pckt_data2 characteristic (as provided by the S110 SoftDevice).
     ble_gatts_char_handles_t           wavfm_data_handles;                  //Handles related to the wavfm_data characteristic (as provided by the S110 SoftDevice).
     ble_gatts_char_handles_t           log_messge_handles;                  //Handles related to the log message characteristic (as provided by the S110 SoftDevice). 
+    ble_gatts_char_handles_t           spi_stats_handles;                   //Handles related to the SPI link statistics characteristic (as provided by the S110 SoftDevice).
+    ble_gatts_char_handles_t           chan_plan_handles;                   //Handles related to the channel plan characteristic (as provided by the S110 SoftDevice).
+    ble_gatts_char_handles_t           pll_stats_handles;                   //Handles related to the PLL lock statistics characteristic (as provided by the S110 SoftDevice).
     uint16_t                           conn_handle;                         //Handle of the current connection (as provided by the S110 SoftDevice). BLE_CONN_HANDLE_INVALID if not in a connection.
     bool                               is_target_epc_indication_enabled;    //Variable to indicate if the peer has enabled indication of the target epc characteristic.
     bool                               is_program_epc_indication_enabled;   //Variable to indicate if the peer has enabled indication of the program epc characteristic.
@@ -161,6 +175,7 @@ struct ble_rfidrs_s
     ble_rfidrs_program_epc_handler_t   program_epc_handler;                 //Event handler to be called for handling received app-specified program epc information.
     ble_rfidrs_read_state_handler_t    read_state_handler;                  //Event handler to be called for handling a received indication confirmation for read state.
     ble_rfidrs_pckt_data1_handler_t    pckt_data1_handler;                  //Event handler to be called for handling a received indication confirmation for read state.
+    ble_rfidrs_chan_plan_handler_t     chan_plan_handler;                   //Event handler to be called for handling a received channel plan selection.
 };
 
 //Superlative Semiconductor note: Declaration and comments template from Nordic SDK v8.0.
@@ -215,4 +230,34 @@ uint32_t ble_rfidrs_pckt_data2_send(ble_rfidrs_t * p_rfidrs, uint8_t * p_data2,
 uint32_t ble_rfidrs_wavfm_data_send(ble_rfidrs_t * p_rfidrs, uint8_t * p_wdata, uint16_t length);
 uint32_t ble_rfidrs_log_messge_send(ble_rfidrs_t * p_rfidrs, uint8_t * p_ldata, uint16_t length);
 
+// Function for updating the value of the read-only SPI link statistics characteristic.
+//
+// input parameter: p_rfidrs       Pointer to the RFIDR Service structure.
+// input parameter: p_string    New characteristic value.
+// input parameter: length      Length of the value.
+//
+// returns NRF_SUCCESS If the value was set successfully. Otherwise, an error code is returned.
+//
+uint32_t ble_rfidrs_spi_stats_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_sdata, uint16_t length);
+
+// Function for updating the value of the read-only PLL lock statistics characteristic.
+//
+// input parameter: p_rfidrs       Pointer to the RFIDR Service structure.
+// input parameter: p_string    New characteristic value.
+// input parameter: length      Length of the value.
+//
+// returns NRF_SUCCESS If the value was set successfully. Otherwise, an error code is returned.
+//
+uint32_t ble_rfidrs_pll_stats_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_sdata, uint16_t length);
+
+// Function for updating the value of the channel plan characteristic, so that the iDevice reads back the plan the reader will actually use.
+//
+// input parameter: p_rfidrs       Pointer to the RFIDR Service structure.
+// input parameter: p_string    New characteristic value.
+// input parameter: length      Length of the value.
+//
+// returns NRF_SUCCESS If the value was set successfully. Otherwise, an error code is returned.
+//
+uint32_t ble_rfidrs_chan_plan_set(ble_rfidrs_t * p_rfidrs, uint8_t * p_cdata, uint16_t length);
+
 #endif // BLE_RFIDRS_H__
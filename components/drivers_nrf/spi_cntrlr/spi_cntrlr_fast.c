@@ -16,10 +16,30 @@
 #include <string.h>
 #include "nrf_gpio.h"
 #include "nrf_delay.h"
+#include "app_util_platform.h"
+
+/* The READY interrupt has to preempt any application context that waits on a transfer, including BLE event handlers. */
+#define SPI_CNTRLR_IRQ_PRIORITY APP_IRQ_PRIORITY_HIGH
+
+/* State of an interrupt-driven frame transfer. */
+typedef struct
+{
+    const uint8_t                *tx_data;          /* next byte to load into TXD */
+    uint8_t                      *rx_data;          /* next location to store RXD into */
+    uint16_t                     frame_size;        /* bytes per chip select assertion */
+    uint16_t                     frames_left;       /* frames not yet completed, including the current one */
+    uint16_t                     tx_left;           /* bytes of the current frame not yet loaded into TXD */
+    uint16_t                     rx_left;           /* bytes of the current frame not yet received */
+    spi_cntrlr_frames_handler_t  handler;           /* called from the interrupt once the last frame completes */
+    void                         *p_context;
+    volatile bool                busy;
+} spi_async_t;
 
 static SPI_config_t spi_config_table[2];
 static NRF_SPI_Type *spi_base[2] = {NRF_SPI0, NRF_SPI1};
+static const IRQn_Type spi_irq[2] = {SPI0_TWI0_IRQn, SPI1_TWI1_IRQn};
 static NRF_SPI_Type *SPI;
+static spi_async_t spi_async[2];
 
 uint32_t* spi_cntrlr_init_fast(SPI_module_number_t spi_num, SPI_config_t *spi_config)
 {
@@ -52,6 +72,20 @@ uint32_t* spi_cntrlr_init_fast(SPI_module_number_t spi_num, SPI_config_t *spi_co
     return (uint32_t *)spi_base[spi_num];
 }
 
+void spi_cntrlr_set_frequency(SPI_module_number_t spi_num, SPI_frequency_t frequency)
+{
+    if(spi_num > 1)
+    {
+        return;
+    }
+    spi_config_table[spi_num].frequency = (uint8_t)frequency;
+
+    /* Only change the clock with the peripheral disabled so that no transfer sees a mix of both rates */
+    spi_base[spi_num]->ENABLE = (SPI_ENABLE_ENABLE_Disabled << SPI_ENABLE_ENABLE_Pos);
+    spi_base[spi_num]->FREQUENCY = (uint32_t)frequency << 24;
+    spi_base[spi_num]->ENABLE = (SPI_ENABLE_ENABLE_Enabled << SPI_ENABLE_ENABLE_Pos);
+}
+
 bool spi_cntrlr_tx_rx(SPI_module_number_t spi_num, uint16_t transfer_size, const uint8_t *tx_data, uint8_t *rx_data)
 {
     volatile uint32_t *SPI_DATA_READY;
@@ -94,3 +128,163 @@ bool spi_cntrlr_tx_rx(SPI_module_number_t spi_num, uint16_t transfer_size, const
 
     return true;
 }
+
+bool spi_cntrlr_tx_rx_frames(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data)
+{
+    volatile uint32_t *SPI_DATA_READY;
+    uint16_t bytes_left;
+    uint8_t pin_CSN;
+
+    if(tx_data == 0 || rx_data == 0 || frame_size == 0)
+    {
+        return false;
+    }
+
+    SPI = spi_base[spi_num];
+    SPI_DATA_READY = &SPI->EVENTS_READY;
+    pin_CSN = spi_config_table[spi_num].pin_CSN;
+
+    while(num_frames--)
+    {
+        /* enable peripheral (peripheral select active low) */
+        nrf_gpio_pin_clear(pin_CSN);
+
+        *SPI_DATA_READY = 0;
+
+        SPI->TXD = (uint32_t)*tx_data++;
+        bytes_left = frame_size;
+        while(--bytes_left)
+        {
+            /* queue the next byte while the previous one is still being shifted out */
+            SPI->TXD = (uint32_t)*tx_data++;
+
+            while (*SPI_DATA_READY == 0);
+
+            *SPI_DATA_READY = 0;
+
+            *rx_data++ = SPI->RXD;
+        }
+
+        /* Wait for the last byte of the frame */
+        while (*SPI_DATA_READY == 0);
+
+        *SPI_DATA_READY = 0;
+
+        *rx_data++ = SPI->RXD;
+
+        /* disable peripheral so the frame is latched (peripheral select active low) */
+        nrf_gpio_pin_set(pin_CSN);
+    }
+
+    return true;
+}
+
+/* Begin the next frame of an interrupt-driven transfer: assert chip select and fill both TXD buffers. */
+static void spi_async_start_frame(SPI_module_number_t spi_num)
+{
+    spi_async_t *p_async = &spi_async[spi_num];
+    NRF_SPI_Type *p_spi = spi_base[spi_num];
+
+    p_async->tx_left = p_async->frame_size;
+    p_async->rx_left = p_async->frame_size;
+
+    /* enable peripheral (peripheral select active low) */
+    nrf_gpio_pin_clear(spi_config_table[spi_num].pin_CSN);
+
+    p_spi->TXD = (uint32_t)*p_async->tx_data++;
+    p_async->tx_left--;
+    if(p_async->tx_left)
+    {
+        p_spi->TXD = (uint32_t)*p_async->tx_data++;
+        p_async->tx_left--;
+    }
+}
+
+bool spi_cntrlr_tx_rx_frames_async(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data,
+                                   spi_cntrlr_frames_handler_t handler, void *p_context)
+{
+    spi_async_t *p_async;
+
+    if(spi_num > 1 || tx_data == 0 || rx_data == 0 || frame_size == 0 || num_frames == 0)
+    {
+        return false;
+    }
+
+    p_async = &spi_async[spi_num];
+    if(p_async->busy)
+    {
+        return false;
+    }
+
+    p_async->tx_data     = tx_data;
+    p_async->rx_data     = rx_data;
+    p_async->frame_size  = frame_size;
+    p_async->frames_left = num_frames;
+    p_async->handler     = handler;
+    p_async->p_context   = p_context;
+    p_async->busy        = true;
+
+    spi_base[spi_num]->EVENTS_READY = 0;
+    NVIC_ClearPendingIRQ(spi_irq[spi_num]);
+    NVIC_SetPriority(spi_irq[spi_num], SPI_CNTRLR_IRQ_PRIORITY);
+    NVIC_EnableIRQ(spi_irq[spi_num]);
+    spi_base[spi_num]->INTENSET = SPI_INTENSET_READY_Msk;
+
+    spi_async_start_frame(spi_num);
+
+    return true;
+}
+
+/* READY interrupt: store the received byte, keep TXD topped up, and move on to the next frame or finish. */
+static void spi_async_irq_handler(SPI_module_number_t spi_num)
+{
+    spi_async_t *p_async = &spi_async[spi_num];
+    NRF_SPI_Type *p_spi = spi_base[spi_num];
+
+    if(p_spi->EVENTS_READY == 0 || !p_async->busy)
+    {
+        return;
+    }
+
+    p_spi->EVENTS_READY = 0;
+    *p_async->rx_data++ = p_spi->RXD;
+    p_async->rx_left--;
+
+    if(p_async->tx_left)
+    {
+        p_spi->TXD = (uint32_t)*p_async->tx_data++;
+        p_async->tx_left--;
+    }
+
+    if(p_async->rx_left)
+    {
+        return;
+    }
+
+    /* disable peripheral so the frame is latched (peripheral select active low) */
+    nrf_gpio_pin_set(spi_config_table[spi_num].pin_CSN);
+
+    if(--p_async->frames_left)
+    {
+        spi_async_start_frame(spi_num);
+        return;
+    }
+
+    p_spi->INTENCLR = SPI_INTENCLR_READY_Msk;
+    p_async->busy = false;
+
+    if(p_async->handler)
+    {
+        p_async->handler(p_async->p_context);
+    }
+}
+
+void SPI0_TWI0_IRQHandler(void)
+{
+    spi_async_irq_handler(SPI0);
+}
+
+void SPI1_TWI1_IRQHandler(void)
+{
+    spi_async_irq_handler(SPI1);
+}
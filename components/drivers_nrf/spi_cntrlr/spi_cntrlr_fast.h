@@ -88,6 +88,11 @@ typedef struct
     uint8_t pin_CSN;                /*!< SPI master chip select pin */
 } SPI_config_t;
 
+/**
+ *  Handler called from the SPI interrupt when an asynchronous frame transfer has completed
+ */
+typedef void (*spi_cntrlr_frames_handler_t)(void *p_context);
+
 /**
  * Initializes given SPI master with given configuration.
  *
@@ -103,6 +108,16 @@ typedef struct
  */
 uint32_t* spi_cntrlr_init_fast(SPI_module_number_t spi_num, SPI_config_t *spi_config);
 
+/**
+ * Change the clock frequency of an initialized SPI master.
+ *
+ * @note Must not be called while a transfer is in progress on this SPI master.
+ *
+ * @param spi_num SPI master number (SPIModuleNumber)
+ * @param frequency new SPI master frequency
+ */
+void spi_cntrlr_set_frequency(SPI_module_number_t spi_num, SPI_frequency_t frequency);
+
 /**
  * Transmit/receive data over SPI bus.
  *
@@ -118,5 +133,49 @@ uint32_t* spi_cntrlr_init_fast(SPI_module_number_t spi_num, SPI_config_t *spi_co
  */
 bool spi_cntrlr_tx_rx(SPI_module_number_t spi_num, uint16_t transfer_size, const uint8_t *tx_data, uint8_t *rx_data);
 
+/**
+ * Transmit/receive a stream of fixed-size frames over SPI bus.
+ *
+ * Each frame is clocked out under its own chip select assertion, since the peripheral latches one
+ * command per assertion. Within a frame the TXD register is double-buffered so that the bus never
+ * idles between bytes, and the whole stream runs without returning to the caller between frames.
+ *
+ * @note Make sure at least frame_size*num_frames number of bytes is allocated in tx_data/rx_data.
+ *
+ * @param spi_num SPI master number (SPIModuleNumber)
+ * @param frame_size  number of bytes in each frame (bytes per chip select assertion)
+ * @param num_frames  number of frames to transmit/receive over SPI master
+ * @param tx_data pointer to the frames that need to be transmitted, packed back to back
+ * @param rx_data pointer to the buffer that receives the frames, packed back to back
+ * @return
+ * @retval true if transmit/reveive of all frames were completed.
+ * @retval false if transmit/reveive was not started and tx_data/rx_data points to invalid data.
+ */
+bool spi_cntrlr_tx_rx_frames(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data);
+
+/**
+ * Start an interrupt-driven transmit/receive of a stream of fixed-size frames over SPI bus.
+ *
+ * Framing is the same as for @ref spi_cntrlr_tx_rx_frames, but the function returns as soon as the
+ * first frame has been started. The rest of the transfer is driven from the SPI READY interrupt, so the
+ * CPU is free to sleep or handle other events in the meantime. Only one transfer per SPI master may be
+ * in flight at a time.
+ *
+ * @note tx_data/rx_data must remain valid until the transfer has completed.
+ *
+ * @param spi_num SPI master number (SPIModuleNumber)
+ * @param frame_size  number of bytes in each frame (bytes per chip select assertion)
+ * @param num_frames  number of frames to transmit/receive over SPI master
+ * @param tx_data pointer to the frames that need to be transmitted, packed back to back
+ * @param rx_data pointer to the buffer that receives the frames, packed back to back
+ * @param handler function called from the SPI interrupt once the last frame has completed (may be 0)
+ * @param p_context pointer passed back to handler
+ * @return
+ * @retval true if the transfer was started.
+ * @retval false if the arguments were invalid or a transfer is already in flight on this SPI master.
+ */
+bool spi_cntrlr_tx_rx_frames_async(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data,
+                                   spi_cntrlr_frames_handler_t handler, void *p_context);
+
  
 #endif
@@ -68,10 +68,15 @@
 #include "softdevice_handler.h"
 #include "app_timer.h"
 #include "app_button.h"
+#include "pstorage.h"
 #include "ble_rfidrs.h"
 #include "app_util_platform.h"
+#include "rfidr_chplan.h"
+#include "rfidr_config.h"
+#include "rfidr_dwell.h"
 #include "rfidr_spi.h"
 #include "rfidr_gpio.h"
+#include "rfidr_rxradio.h"
 #include "rfidr_state.h"
 #include "rfidr_txradio.h"
 
@@ -215,12 +220,13 @@ static void gap_params_init(void)
 //Event handler for the write state characteristic.
 //This function calls the write_rfidr_state_next() function in rfidr_state.c to ensure that a proper state transition is being requested,
 //then sets a flag so run the actual state machine code on the next iteration of the main while(1) loop.
+//The three high bits of the request opt in to packed and deduplicated inventory reports and to on-reader PDOA ranges while tracking; apps that predate them never set them.
 
 static void rfidrs_wrte_state_handler(ble_rfidrs_t * p_rfidrs, uint8_t * p_data, uint16_t length)
 {
     rfidr_state_t    request_rfidr_state_t;
 
-    switch(p_data[0])
+    switch(p_data[0] & BLE_RFIDRS_WRTE_STATE_MASK)
     {
         case(0):    request_rfidr_state_t    =    IDLE_UNCONFIGURED;          break;
         case(1):    request_rfidr_state_t    =    IDLE_CONFIGURED;            break;
@@ -240,6 +246,9 @@ static void rfidrs_wrte_state_handler(ble_rfidrs_t * p_rfidrs, uint8_t * p_data,
         default:    request_rfidr_state_t    =    IDLE_UNCONFIGURED;          break;
     }
 
+    rfidr_state_set_packed_reports((p_data[0] & BLE_RFIDRS_WRTE_STATE_PACKED_REPORTS) != 0);
+    rfidr_state_set_dedup_reports((p_data[0] & BLE_RFIDRS_WRTE_STATE_DEDUP_REPORTS) != 0);
+    rfidr_state_set_range_reports((p_data[0] & BLE_RFIDRS_WRTE_STATE_RANGE_REPORTS) != 0);
     write_rfidr_state_next(p_rfidrs, request_rfidr_state_t);
     received_write_state_event    =    true;
     //One question to ask here is why didn't we just call run_rfidr_state_machine right here instead using a flag to trigger it to run in the main loop.
@@ -314,14 +323,14 @@ static void rfidrs_read_state_handler(ble_rfidrs_t * p_rfidrs, ble_rfidrs_hvc_ev
 //The function below was written by Superlative Semiconductor LLC
 
 //Event handler for the data1 characteristic, i.e. when the MCU pushes a tag EPC to the iDevice.
-//This handler is for the indication ACK; the action is to get the indication confirmation flag state variable
-//in the rfidr_state.c module.
+//This handler is for the indication ACK; the action is to send the next queued tag report
+//in the rfidr_rxradio.c module.
 static void rfidrs_pckt_data1_handler(ble_rfidrs_t * p_rfidrs, ble_rfidrs_hvc_evt_t * p_evt)
 {
     switch (p_evt->evt_type)
     {
         case BLE_HVC_EVT_INDICATION_CONFIRMED:
-            rfidr_state_received_pckt_data1_confirmation();
+            rfidr_report_queue_on_data1_confirmation(p_rfidrs);
             break;
 
         default:
@@ -331,6 +340,24 @@ static void rfidrs_pckt_data1_handler(ble_rfidrs_t * p_rfidrs, ble_rfidrs_hvc_ev
 }
 
 
+//Set the channel plan characteristic to the plan and seed the reader will hop with, whether they came from the iDevice, from flash or are the defaults.
+static void rfidrs_chan_plan_update(ble_rfidrs_t * p_rfidrs)
+{
+    uint8_t    chan_plan[BLE_RFIDRS_CHAN_PLAN_CHAR_LEN]    =    {rfidr_chplan_requested(), rfidr_chplan_requested_seed()};
+
+    ble_rfidrs_chan_plan_set(p_rfidrs, chan_plan, BLE_RFIDRS_CHAN_PLAN_CHAR_LEN);    //Only fails if the service is not up yet.
+}
+
+//Event handler for the regional channel plan characteristic.
+//The first byte selects the plan and the optional second byte seeds the hop sequence.
+//The request is only latched here; the radio picks it up at its next hop so that we never retune mid-packet.
+static void rfidrs_chan_plan_handler(ble_rfidrs_t * p_rfidrs, uint8_t * p_data, uint16_t length)
+{
+    if(length != 0){rfidr_chplan_request(p_data[0], (length > 1) ? p_data[1] : 0);}
+
+    rfidrs_chan_plan_update(p_rfidrs);    //A plan that doesn't exist is not taken, so put back the one that will be used.
+}
+
 //Superlative Semiconductor Note: Function template unchanged from Nordic SDK v8.0.
 //Function internals modified by Superlative Semiconductor to meet RFID reader project requirements.
 //Comments originally from Nordic
@@ -348,6 +375,7 @@ static void services_init(void)
     rfidrs_init.program_epc_handler                = rfidrs_program_epc_handler; //App-specified program EPC
     rfidrs_init.read_state_handler                 = rfidrs_read_state_handler;
     rfidrs_init.pckt_data1_handler                 = rfidrs_pckt_data1_handler;
+    rfidrs_init.chan_plan_handler                  = rfidrs_chan_plan_handler;
     
     err_code = ble_rfidrs_init(&m_rfidrs, &rfidrs_init);
     APP_ERROR_CHECK(err_code);
@@ -425,7 +453,8 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
     //Do nothing for now
 }
 
-//Superlative Semiconductor Note: Function unchanged from Nordic SDK v8.0.
+//Superlative Semiconductor Note: Function template unchanged from Nordic SDK v8.0.
+//Also drives the tag report queue in rfidr_rxradio.c: TX complete frees up buffers, and a disconnect drops whatever is still queued.
 //Comments originally from Nordic
 /**@brief Function for the Application's S110 SoftDevice event handler.
  *
@@ -446,6 +475,11 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
             rfidr_disable_led0();
             APP_ERROR_CHECK(err_code);
             m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            rfidr_report_queue_reset();
+            break;
+
+        case BLE_EVT_TX_COMPLETE:
+            rfidr_report_queue_on_tx_complete(&m_rfidrs);
             break;
 
         case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
@@ -486,7 +520,14 @@ static void ble_evt_dispatch(ble_evt_t * p_ble_evt)
     
 }
 
-//Superlative Semiconductor Note: Function unchanged from Nordic SDK v8.0.
+//Pass SoftDevice system events on to pstorage, which needs to hear when its flash operations complete.
+static void sys_evt_dispatch(uint32_t sys_evt)
+{
+    pstorage_sys_event_handler(sys_evt);
+}
+
+//Superlative Semiconductor Note: Function template unchanged from Nordic SDK v8.0.
+//Also subscribes to SoftDevice system events, which pstorage needs to hear when its flash operations complete.
 //Comments originally from Nordic
 /**@brief Function for the S110 SoftDevice initialization.
  *
@@ -512,6 +553,10 @@ static void ble_stack_init(void)
     // Subscribe for BLE events.
     err_code = softdevice_ble_evt_handler_set(ble_evt_dispatch);
     APP_ERROR_CHECK(err_code);
+
+    // Subscribe for system events.
+    err_code = softdevice_sys_evt_handler_set(sys_evt_dispatch);
+    APP_ERROR_CHECK(err_code);
 }
 
 //Superlative Semiconductor Note: Function unchanged from Nordic SDK v8.0.
@@ -572,8 +617,15 @@ int main(void)
     //Initialize the Bluetooth LE aspects of the MCU and the SoftDevice
     APP_TIMER_INIT(APP_TIMER_PRESCALER, APP_TIMER_OP_QUEUE_SIZE, false);
     ble_stack_init();
+    //Read back the configuration kept in flash, if any, before anything that depends on it. A bad or missing record just means a cold start.
+    err_code = pstorage_init();
+    APP_ERROR_CHECK(err_code);
+    rfidr_config_init();
+    rfidr_report_queue_init();
+    rfidr_dwell_init();
     gap_params_init();
     services_init();
+    rfidrs_chan_plan_update(&m_rfidrs);    //The characteristic starts out as zeros, so show the plan restored from flash.
     advertising_init();
     conn_params_init();
 
@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Receive AGC                                          //
+//                                                                              //
+// Filename: rfidr_agc.c                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the firmware receive gain control. During a query round//
+//    it keeps the strongest read and counts good and failed decodes. Between   //
+//    rounds it steps the channel's receive gain by one notch: down if the      //
+//    strongest read is near saturation, up if reads are weak or failing while  //
+//    weak. A round with no reads at all sweeps the gain up and back down, since//
+//    both a tag too weak to decode and TX leakage swamping the receiver look   //
+//    like that. The ladder steps the LNA gain first and then the BBA gain. Each//
+//    channel of the plan remembers its own gain, since the tag population's    //
+//    path loss and the TX leakage both vary across the band.                   //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_agc.h"
+#include "rfidr_chplan.h"
+#include "rfidr_math.h"
+#include <string.h>
+
+typedef struct
+{
+    uint8_t        lna_gain;                            //SX1257 register 0x0C: LNA gain code in bits 7:5, BBA gain in bits 4:1.
+    uint8_t        gain_db;                             //Gain above the lowest step.
+} rfidr_agc_step_t;
+
+//The SX1257 LNA gain codes 1-3 are 6dB apart and 3-6 are 12dB apart. Past LNA gain code 1, the BBA gain code goes up from 10, 2dB per code.
+static const rfidr_agc_step_t m_agc_steps[RFIDR_AGC_NUM_STEPS] =
+{
+    {0xD4,  0},
+    {0xB4, 12},
+    {0x94, 24},
+    {0x74, 36},
+    {0x54, 42},
+    {0x34, 48},
+    {0x38, 52},
+    {0x3C, 56}
+};
+
+static uint8_t     m_agc_step[RFIDR_CHPLAN_MAX_CHANNELS];    //Gain memory, as an index into m_agc_steps. Zero (0xD4) is the historical fixed gain.
+static uint8_t     m_agc_search_down[(RFIDR_CHPLAN_MAX_CHANNELS+7)/8];    //Bit set means the channel's next empty round steps the gain down, clear means up.
+static uint16_t    m_agc_round_peak_db       =    0;         //Strongest read of the round, good or bad, Q8.8.
+static uint16_t    m_agc_round_good          =    0;
+static uint16_t    m_agc_round_failed        =    0;
+
+void rfidr_agc_reset(void)
+{
+    memset(m_agc_step,0,sizeof(m_agc_step));
+    memset(m_agc_search_down,0,sizeof(m_agc_search_down));
+    m_agc_round_peak_db    =    0;
+    m_agc_round_good       =    0;
+    m_agc_round_failed     =    0;
+}
+
+uint8_t rfidr_agc_gain(uint8_t channel)
+{
+    if(channel >= RFIDR_CHPLAN_MAX_CHANNELS){return m_agc_steps[0].lna_gain;}
+
+    return m_agc_steps[m_agc_step[channel]].lna_gain;
+}
+
+void rfidr_agc_observe(const rfidr_tag_record_t * p_record)
+{
+    uint32_t    magnitude    =    0;
+    uint16_t    phase        =    0;
+    uint16_t    db           =    0;
+
+    rfidr_math_cordic_vector(p_record->main_mag,p_record->alt_mag,&magnitude,&phase);
+    db=rfidr_math_db20(magnitude);
+
+    if(db > m_agc_round_peak_db){m_agc_round_peak_db=db;}
+
+    if(p_record->crc_pass)
+    {
+        if(m_agc_round_good < 0xFFFF){m_agc_round_good++;}
+    }
+    else
+    {
+        if(m_agc_round_failed < 0xFFFF){m_agc_round_failed++;}
+    }
+}
+
+bool rfidr_agc_end_round(uint8_t channel)
+{
+    uint8_t     step          =    0;
+    uint8_t     search_bit    =    0;
+    bool        step_down     =    false;
+    bool        step_up       =    false;
+
+    if(channel < RFIDR_CHPLAN_MAX_CHANNELS)
+    {
+        step          =    m_agc_step[channel];
+        search_bit    =    (uint8_t)(1 << (channel & 7));
+
+        if(m_agc_round_good == 0 && m_agc_round_failed == 0)
+        {
+            //Nothing to measure: either every tag is too weak to decode or we are swamped. Keep sweeping, turning around at either end of the ladder.
+            if(step == 0){m_agc_search_down[channel >> 3]&=~search_bit;}
+            if(step == RFIDR_AGC_NUM_STEPS-1){m_agc_search_down[channel >> 3]|=search_bit;}
+            step_down    =    (m_agc_search_down[channel >> 3] & search_bit) != 0;
+            step_up      =    !step_down;
+        }
+        else if(m_agc_round_peak_db > RFIDR_AGC_HIGH_DB)
+        {
+            step_down    =    true;                                        //Close to saturating on the strongest tag.
+            m_agc_search_down[channel >> 3]|=search_bit;                   //If the reads stop, we most likely went further into saturation.
+        }
+        else if(m_agc_round_failed > m_agc_round_good || m_agc_round_peak_db < RFIDR_AGC_LOW_DB)
+        {
+            step_up      =    true;                                        //Weak, or mostly failing without too much signal.
+            m_agc_search_down[channel >> 3]&=~search_bit;                  //If the reads stop, the weakest tags most likely dropped out.
+        }
+
+        if(step_down && step > 0){m_agc_step[channel]=step-1;}
+        if(step_up && step < RFIDR_AGC_NUM_STEPS-1){m_agc_step[channel]=step+1;}
+    }
+
+    m_agc_round_peak_db    =    0;
+    m_agc_round_good       =    0;
+    m_agc_round_failed     =    0;
+
+    return channel < RFIDR_CHPLAN_MAX_CHANNELS && m_agc_step[channel] != step;
+}
+
+void rfidr_agc_export(uint8_t * p_steps)
+{
+    memcpy(p_steps,m_agc_step,sizeof(m_agc_step));
+}
+
+void rfidr_agc_import(const uint8_t * p_steps)
+{
+    uint8_t    loop_channel    =    0;
+
+    for(loop_channel=0;loop_channel < RFIDR_CHPLAN_MAX_CHANNELS;loop_channel++)
+        m_agc_step[loop_channel]=(p_steps[loop_channel] < RFIDR_AGC_NUM_STEPS) ? p_steps[loop_channel] : 0;
+}
+
+uint16_t rfidr_agc_gain_above_default_db(uint8_t lna_gain)
+{
+    uint8_t    loop_step    =    0;
+
+    for(loop_step=0;loop_step < RFIDR_AGC_NUM_STEPS;loop_step++)
+    {
+        if(m_agc_steps[loop_step].lna_gain == lna_gain){return (uint16_t)m_agc_steps[loop_step].gain_db << 8;}
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Receive AGC                                          //
+//                                                                              //
+// Filename: rfidr_agc.h                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the prototypes for the firmware receive gain control,  //
+//    which picks the SX1257 LNA and BBA gain for each query round from how tags//
+//    on the same channel decoded in the rounds before it.                      //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR receive AGC functions
+//This file provides a per-channel receive gain memory driven by tag read magnitudes and failed decodes
+
+#ifndef RFIDR_AGC_H__
+#define RFIDR_AGC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_rxradio.h"
+
+#define RFIDR_AGC_NUM_STEPS        8               //LNA gain codes 6 (lowest) to 1 (highest) at the BBA gain of the 0xD4/0x94/0x34 presets, then two BBA steps on top.
+#define RFIDR_AGC_HIGH_DB          (72 << 8)       //Step the gain down if the strongest read of a round is above this (dB of integrator magnitude, Q8.8)...
+#define RFIDR_AGC_LOW_DB           (54 << 8)       //...and up if it is below this. The gap is wider than any gain step, so a step can't bounce straight back.
+
+//function for sending every channel back to the lowest gain (0xD4), e.g. when the channel plan changes
+
+void rfidr_agc_reset(void);
+
+//function for reading the gain to start a query round with on a channel
+//returns the SX1257 LNA gain register (0x0C) value
+
+uint8_t rfidr_agc_gain(uint8_t channel);
+
+//function for feeding one tag read of the current round to the AGC, whether or not its CRC passed
+
+void rfidr_agc_observe(const rfidr_tag_record_t * p_record);
+
+//function for closing out a round on a channel: step that channel's gain if the round calls for it and clear the round's statistics
+//A round with no reads at all keeps stepping the same way as the last step that had reads, turning around at either end, so a tag too weak to decode still gets more gain.
+//returns true if the channel's gain changed
+
+bool rfidr_agc_end_round(uint8_t channel);
+
+//function for finding how much more gain than 0xD4 a given LNA gain register value has, so that reads taken at different gains can be compared
+//returns the extra gain in dB as Q8.8, or 0 for a value not on the AGC ladder
+
+uint16_t rfidr_agc_gain_above_default_db(uint8_t lna_gain);
+
+//function for copying out every channel's gain step (0 for 0xD4 up to RFIDR_AGC_NUM_STEPS-1), RFIDR_CHPLAN_MAX_CHANNELS bytes, e.g. to keep it in flash
+
+void rfidr_agc_export(uint8_t * p_steps);
+
+//function for loading the gain steps from a copy made by rfidr_agc_export. Steps that are out of range are taken as 0xD4.
+
+void rfidr_agc_import(const uint8_t * p_steps);
+
+#endif
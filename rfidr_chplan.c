@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Channel Plans                                        //
+//                                                                              //
+// Filename: rfidr_chplan.c                                                     //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the regional channel plans the reader can hop over, and//
+//    the pseudo-random hop sequence used to visit their channels. The SX1257   //
+//    frequency codes of every channel are kept in a const table in flash, so   //
+//    they cost no RAM. Hopping uses a maximal-length Galois LFSR just wider    //
+//    than the channel count, skipping the states that do not map to a channel, //
+//    so every channel is used equally often.                                   //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "rfidr_chplan.h"
+#include <stddef.h>
+
+#define CHPLAN_TOTAL_CHANNELS        99       //Sum of the channel counts of all the plans.
+
+typedef struct
+{
+    uint8_t        first_code;                          //Index of channel 0 in m_chplan_regs.
+    uint16_t       spacing_khz;
+    uint16_t       max_dwell_ms;                        //Most transmit time allowed on one channel...
+    uint16_t       dwell_window_ms;                     //...in any window this long.
+    uint8_t        num_channels;
+    uint8_t        lfsr_taps;                           //Galois feedback mask of a maximal-length LFSR with at least num_channels nonzero states.
+} rfidr_chplan_t;
+
+static const rfidr_chplan_t m_chplans[RFIDR_CHPLAN_NUM_PLANS] =
+{
+    { 0, 1000,  400, 10000, 25, 0x14},    //FCC 15.247 with 25-49 channels: 0.4s in any 10s.
+    {25,  500,  400, 20000, 50, 0x30},    //FCC 15.247 with 50 or more channels: 0.4s in any 20s.
+    {75,  600, 4000,  4100,  4, 0x06},    //EN 302 208: 4s per channel, then 100ms off it.
+    {79, 1200, 4000,  4050,  4, 0x06},    //ARIB STD-T106: 4s per channel, then 50ms off it.
+    {83,  250, 2000,  2100, 16, 0x14}     //China 920-925MHz: 2s per channel, with 100ms off it for margin.
+};
+
+//SX1257 frequency codes (MSB, MidSB, LSB) of every channel of every plan, plan by plan in m_chplans order.
+//The SX1257 PLL step is 36MHz/2^19, so each code is round(frequency_khz*2^14/1125), with the channels of a plan spacing_khz apart from the frequency given.
+static const uint8_t m_chplan_regs[CHPLAN_TOTAL_CHANNELS][3] =
+{
+    //RFIDR_CHPLAN_FCC_25, from 903.000MHz
+    {0xC8,0xAA,0xAB}, {0xC8,0xE3,0x8E}, {0xC9,0x1C,0x72}, {0xC9,0x55,0x55}, {0xC9,0x8E,0x39},
+    {0xC9,0xC7,0x1C}, {0xCA,0x00,0x00}, {0xCA,0x38,0xE4}, {0xCA,0x71,0xC7}, {0xCA,0xAA,0xAB},
+    {0xCA,0xE3,0x8E}, {0xCB,0x1C,0x72}, {0xCB,0x55,0x55}, {0xCB,0x8E,0x39}, {0xCB,0xC7,0x1C},
+    {0xCC,0x00,0x00}, {0xCC,0x38,0xE4}, {0xCC,0x71,0xC7}, {0xCC,0xAA,0xAB}, {0xCC,0xE3,0x8E},
+    {0xCD,0x1C,0x72}, {0xCD,0x55,0x55}, {0xCD,0x8E,0x39}, {0xCD,0xC7,0x1C}, {0xCE,0x00,0x00},
+    //RFIDR_CHPLAN_FCC_50, from 902.750MHz
+    {0xC8,0x9C,0x72}, {0xC8,0xB8,0xE4}, {0xC8,0xD5,0x55}, {0xC8,0xF1,0xC7}, {0xC9,0x0E,0x39},
+    {0xC9,0x2A,0xAB}, {0xC9,0x47,0x1C}, {0xC9,0x63,0x8E}, {0xC9,0x80,0x00}, {0xC9,0x9C,0x72},
+    {0xC9,0xB8,0xE4}, {0xC9,0xD5,0x55}, {0xC9,0xF1,0xC7}, {0xCA,0x0E,0x39}, {0xCA,0x2A,0xAB},
+    {0xCA,0x47,0x1C}, {0xCA,0x63,0x8E}, {0xCA,0x80,0x00}, {0xCA,0x9C,0x72}, {0xCA,0xB8,0xE4},
+    {0xCA,0xD5,0x55}, {0xCA,0xF1,0xC7}, {0xCB,0x0E,0x39}, {0xCB,0x2A,0xAB}, {0xCB,0x47,0x1C},
+    {0xCB,0x63,0x8E}, {0xCB,0x80,0x00}, {0xCB,0x9C,0x72}, {0xCB,0xB8,0xE4}, {0xCB,0xD5,0x55},
+    {0xCB,0xF1,0xC7}, {0xCC,0x0E,0x39}, {0xCC,0x2A,0xAB}, {0xCC,0x47,0x1C}, {0xCC,0x63,0x8E},
+    {0xCC,0x80,0x00}, {0xCC,0x9C,0x72}, {0xCC,0xB8,0xE4}, {0xCC,0xD5,0x55}, {0xCC,0xF1,0xC7},
+    {0xCD,0x0E,0x39}, {0xCD,0x2A,0xAB}, {0xCD,0x47,0x1C}, {0xCD,0x63,0x8E}, {0xCD,0x80,0x00},
+    {0xCD,0x9C,0x72}, {0xCD,0xB8,0xE4}, {0xCD,0xD5,0x55}, {0xCD,0xF1,0xC7}, {0xCE,0x0E,0x39},
+    //RFIDR_CHPLAN_ETSI_4, from 865.700MHz
+    {0xC0,0x60,0xB6}, {0xC0,0x82,0xD8}, {0xC0,0xA4,0xFA}, {0xC0,0xC7,0x1C},
+    //RFIDR_CHPLAN_JAPAN_4, from 916.800MHz
+    {0xCB,0xBB,0xBC}, {0xCC,0x00,0x00}, {0xCC,0x44,0x44}, {0xCC,0x88,0x89},
+    //RFIDR_CHPLAN_CHINA_16, from 920.625MHz
+    {0xCC,0x95,0x55}, {0xCC,0xA3,0x8E}, {0xCC,0xB1,0xC7}, {0xCC,0xC0,0x00}, {0xCC,0xCE,0x39},
+    {0xCC,0xDC,0x72}, {0xCC,0xEA,0xAB}, {0xCC,0xF8,0xE4}, {0xCD,0x07,0x1C}, {0xCD,0x15,0x55},
+    {0xCD,0x23,0x8E}, {0xCD,0x31,0xC7}, {0xCD,0x40,0x00}, {0xCD,0x4E,0x39}, {0xCD,0x5C,0x72},
+    {0xCD,0x6A,0xAB}
+};
+
+static uint8_t             m_chplan_active              =    RFIDR_CHPLAN_FCC_25;
+static uint8_t             m_chplan_active_seed         =    0;
+static uint8_t             m_chplan_lfsr                =    1;
+static uint8_t             m_chplan_requested           =    RFIDR_CHPLAN_FCC_25;
+static uint8_t             m_chplan_requested_seed      =    0;
+static volatile bool       m_chplan_pending             =    true;          //Starts true so that load_sx1257_default starts the hop sequence.
+
+rfidr_error_t rfidr_chplan_request(uint8_t plan, uint8_t seed)
+{
+    if(plan >= RFIDR_CHPLAN_NUM_PLANS){return RFIDR_ERROR_GENERAL;}
+
+    CRITICAL_REGION_ENTER();
+    m_chplan_requested         =    plan;
+    m_chplan_requested_seed    =    seed;
+    m_chplan_pending           =    true;
+    CRITICAL_REGION_EXIT();
+
+    return RFIDR_SUCCESS;
+}
+
+bool rfidr_chplan_apply_pending(void)
+{
+    const rfidr_chplan_t    *p_plan         =    NULL;
+    uint8_t                 seed            =    0;
+    uint8_t                 lfsr_period     =    0;
+
+    if(!m_chplan_pending){return false;}
+
+    CRITICAL_REGION_ENTER();
+    m_chplan_active     =    m_chplan_requested;
+    seed                =    m_chplan_requested_seed;
+    m_chplan_pending    =    false;
+    CRITICAL_REGION_EXIT();
+
+    m_chplan_active_seed    =    seed;
+    p_plan=&m_chplans[m_chplan_active];
+
+    //The LFSR period is 2^k-1, i.e. every bit at and below the top tap set. The state must never be 0.
+    lfsr_period    =    p_plan->lfsr_taps;
+    lfsr_period   |=    lfsr_period >> 1;
+    lfsr_period   |=    lfsr_period >> 2;
+    lfsr_period   |=    lfsr_period >> 4;
+    m_chplan_lfsr=(uint8_t)((seed % lfsr_period)+1);
+
+    return true;
+}
+
+uint8_t rfidr_chplan_active(void)
+{
+    return m_chplan_active;
+}
+
+uint8_t rfidr_chplan_seed(void)
+{
+    return m_chplan_active_seed;
+}
+
+uint8_t rfidr_chplan_requested(void)
+{
+    return m_chplan_requested;
+}
+
+uint8_t rfidr_chplan_requested_seed(void)
+{
+    return m_chplan_requested_seed;
+}
+
+uint8_t rfidr_chplan_num_channels(void)
+{
+    return m_chplans[m_chplan_active].num_channels;
+}
+
+uint16_t rfidr_chplan_spacing_khz(void)
+{
+    return m_chplans[m_chplan_active].spacing_khz;
+}
+
+uint16_t rfidr_chplan_max_dwell_ms(void)
+{
+    return m_chplans[m_chplan_active].max_dwell_ms;
+}
+
+uint16_t rfidr_chplan_dwell_window_ms(void)
+{
+    return m_chplans[m_chplan_active].dwell_window_ms;
+}
+
+uint8_t rfidr_chplan_center_channel(void)
+{
+    return m_chplans[m_chplan_active].num_channels >> 1;
+}
+
+//Step the LFSR until it lands on a state that maps to a channel. States run from 1 to 2^k-1 and channels from 0 to num_channels-1.
+uint8_t rfidr_chplan_next_channel(void)
+{
+    const rfidr_chplan_t    *p_plan    =    &m_chplans[m_chplan_active];
+
+    do
+    {
+        m_chplan_lfsr=(m_chplan_lfsr & 1) ? ((m_chplan_lfsr >> 1) ^ p_plan->lfsr_taps) : (m_chplan_lfsr >> 1);
+    } while(m_chplan_lfsr > p_plan->num_channels);
+
+    return m_chplan_lfsr-1;
+}
+
+uint8_t rfidr_chplan_skip_channel(uint8_t channel, uint8_t distance)
+{
+    uint8_t    num_channels    =    m_chplans[m_chplan_active].num_channels;
+
+    if(channel+distance < num_channels)
+        return channel+distance;
+    else if(channel >= distance)
+        return channel-distance;
+    else
+        return (channel >= num_channels-1-channel) ? 0 : num_channels-1;
+}
+
+const uint8_t * rfidr_chplan_channel_regs(uint8_t channel)
+{
+    if(channel >= m_chplans[m_chplan_active].num_channels){channel=rfidr_chplan_center_channel();}
+
+    return m_chplan_regs[m_chplans[m_chplan_active].first_code+channel];
+}
@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Channel Plans                                        //
+//                                                                              //
+// Filename: rfidr_chplan.h                                                     //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the regional channel plans the reader can hop over, and//
+//    the pseudo-random hop sequence used to visit their channels.              //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR channel plan functions
+//This file provides the active channel plan, its SX1257 frequency codes and its hop sequence
+
+#ifndef RFIDR_CHPLAN_H__
+#define RFIDR_CHPLAN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_error.h"
+
+#define RFIDR_CHPLAN_MAX_CHANNELS    50       //Largest plan. Per-channel state elsewhere is sized by this.
+
+typedef enum
+{
+    RFIDR_CHPLAN_FCC_25,                                //902-928MHz, 25 channels 1MHz apart from 903MHz. The original plan, and the default.
+    RFIDR_CHPLAN_FCC_50,                                //902-928MHz, 50 channels 500kHz apart from 902.75MHz.
+    RFIDR_CHPLAN_ETSI_4,                                //865-868MHz (EN 302 208), 4 high-power channels 600kHz apart from 865.7MHz.
+    RFIDR_CHPLAN_JAPAN_4,                               //916.7-920.9MHz (ARIB STD-T106), 4 LBT-exempt channels 1.2MHz apart from 916.8MHz.
+    RFIDR_CHPLAN_CHINA_16,                              //920.5-924.5MHz, 16 channels 250kHz apart from 920.625MHz.
+    RFIDR_CHPLAN_NUM_PLANS
+} rfidr_chplan_id_t;
+
+//function for asking for a new channel plan and hop sequence seed, e.g. from the BTLE event handler
+//The change takes effect at the next call to rfidr_chplan_apply_pending, so a hop/skip pair never straddles two plans.
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_GENERAL if the plan does not exist
+
+rfidr_error_t rfidr_chplan_request(uint8_t plan, uint8_t seed);
+
+//function for switching to the requested channel plan, if one is pending, and restarting the hop sequence
+//This must run once before any other function here is used; load_sx1257_default takes care of that.
+//returns true if the plan was (re)loaded
+
+bool rfidr_chplan_apply_pending(void);
+
+//function for reading which channel plan is in use
+//returns the rfidr_chplan_id_t of the active plan
+
+uint8_t rfidr_chplan_active(void);
+
+//function for reading the hop sequence seed the active plan was loaded with
+//returns the seed passed to rfidr_chplan_request
+
+uint8_t rfidr_chplan_seed(void);
+
+//function for reading which channel plan was last asked for, e.g. from flash or by the iDevice
+//This is the active plan once rfidr_chplan_apply_pending has run, and the plan the next hop will switch to until then.
+//returns the rfidr_chplan_id_t of the requested plan
+
+uint8_t rfidr_chplan_requested(void);
+
+//function for reading the hop sequence seed that was last asked for
+//returns the seed passed to rfidr_chplan_request
+
+uint8_t rfidr_chplan_requested_seed(void);
+
+//function for reading the number of channels in the active plan
+//returns the channel count
+
+uint8_t rfidr_chplan_num_channels(void);
+
+//function for reading the channel spacing of the active plan
+//returns the spacing in kHz
+
+uint16_t rfidr_chplan_spacing_khz(void);
+
+//function for reading how much transmit time the active plan allows on one channel within its dwell window
+//returns the dwell limit in ms
+
+uint16_t rfidr_chplan_max_dwell_ms(void);
+
+//function for reading the sliding window over which the active plan's dwell limit applies
+//returns the window length in ms
+
+uint16_t rfidr_chplan_dwell_window_ms(void);
+
+//function for reading the channel closest to the middle of the active plan, used as the power-on channel
+//returns the channel index
+
+uint8_t rfidr_chplan_center_channel(void);
+
+//function for picking the next channel of the hop sequence
+//Each channel comes up exactly once in every 2^k-1 calls, where 2^k-1 is the LFSR period used for the plan.
+//returns the channel index
+
+uint8_t rfidr_chplan_next_channel(void);
+
+//function for picking a channel distance channels away from channel, for PDOA
+//Goes up if it can, otherwise down, otherwise to whichever edge of the plan is farther.
+//returns the channel index
+
+uint8_t rfidr_chplan_skip_channel(uint8_t channel, uint8_t distance);
+
+//function for reading the SX1257 frequency register values for a channel of the active plan
+//Out-of-range channels get the center channel.
+//returns a pointer to the MSB, MidSB and LSB of the frequency code
+
+const uint8_t * rfidr_chplan_channel_regs(uint8_t channel);
+
+#endif
@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Persistent Configuration                             //
+//                                                                              //
+// Filename: rfidr_config.c                                                     //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file keeps the reader's calibration and configuration in a single    //
+//    flash block managed by pstorage: the channel plan and seed, the SPI link  //
+//    clock and the per-channel TX offset and AGC gain tables. The record starts//
+//    with a layout version and a CRC-16 over the rest, and anything that fails //
+//    either check is treated as no record at all, which includes a blank or    //
+//    half-written block.                                                       //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "pstorage.h"
+#include "rfidr_agc.h"
+#include "rfidr_chplan.h"
+#include "rfidr_config.h"
+#include "rfidr_crc.h"
+#include "rfidr_txcal.h"
+#include <stddef.h>
+#include <string.h>
+
+//The record is stored as a whole number of words, which pstorage requires. The fields below add up to 116 bytes.
+typedef struct
+{
+    uint16_t       version;                                         //RFIDR_CONFIG_VERSION.
+    uint16_t       crc;                                             //CRC-16 over everything after this field.
+    uint16_t       spi_link_khz;
+    uint8_t        chplan;
+    uint8_t        chplan_seed;
+    uint8_t        reserved;                                        //Pads the record to a whole number of words.
+    uint8_t        txcal_valid[RFIDR_TXCAL_VALID_BYTES];
+    uint8_t        txcal_offsets[RFIDR_CHPLAN_MAX_CHANNELS];
+    uint8_t        agc_steps[RFIDR_CHPLAN_MAX_CHANNELS];
+} rfidr_config_record_t;
+
+#define CONFIG_CRC_OFFSET          offsetof(rfidr_config_record_t,spi_link_khz)    //The CRC covers the record from here onwards.
+#define CONFIG_COMPARE_END         offsetof(rfidr_config_record_t,agc_steps)       //Fields from here on don't justify a flash write on their own.
+
+static pstorage_handle_t        m_config_handle;
+static rfidr_config_record_t    m_config_record;                //Record read at power on, then the staging buffer for writes. pstorage reads from it until the write completes.
+static bool                     m_config_warm             =    false;
+static bool                     m_config_restored         =    false;
+static volatile bool            m_config_busy             =    false;
+
+static void config_pstorage_cb(pstorage_handle_t * p_handle, uint8_t op_code, uint32_t result, uint8_t * p_data, uint32_t data_len)
+{
+    m_config_busy    =    false;    //A failed write just leaves the old record, or a bad CRC, behind. Either way we fall back safely next time.
+}
+
+static uint16_t config_crc(const rfidr_config_record_t * p_record)
+{
+    return rfidr_crc16_compute((const uint8_t *)p_record+CONFIG_CRC_OFFSET,(uint16_t)((sizeof(rfidr_config_record_t)-CONFIG_CRC_OFFSET)*8));
+}
+
+//Check whether the record in flash is good and already holds the staged values.
+//The AGC gains move by a step most query rounds, so a change there alone isn't worth a page erase. They go along with the next write.
+static bool config_flash_current(void)
+{
+    const rfidr_config_record_t    *p_flash    =    (const rfidr_config_record_t *)m_config_handle.block_id;    //The block is memory mapped.
+
+    if(p_flash->version != RFIDR_CONFIG_VERSION || p_flash->crc != config_crc(p_flash)){return false;}
+
+    return memcmp((const uint8_t *)p_flash+CONFIG_CRC_OFFSET,(const uint8_t *)&m_config_record+CONFIG_CRC_OFFSET,CONFIG_COMPARE_END-CONFIG_CRC_OFFSET) == 0;
+}
+
+rfidr_error_t rfidr_config_init(void)
+{
+    pstorage_module_param_t    param;
+    pstorage_handle_t          base_handle;
+
+    param.block_size     =    sizeof(rfidr_config_record_t);
+    param.block_count    =    1;
+    param.cb             =    config_pstorage_cb;
+
+    if(pstorage_register(&param,&base_handle) != NRF_SUCCESS){return RFIDR_ERROR_CONFIG;}
+    if(pstorage_block_identifier_get(&base_handle,0,&m_config_handle) != NRF_SUCCESS){return RFIDR_ERROR_CONFIG;}
+    if(pstorage_load((uint8_t *)&m_config_record,&m_config_handle,sizeof(rfidr_config_record_t),0) != NRF_SUCCESS){return RFIDR_ERROR_CONFIG;}
+
+    m_config_warm    =    (m_config_record.version == RFIDR_CONFIG_VERSION) && (m_config_record.crc == config_crc(&m_config_record));
+
+    if(m_config_warm)
+    {
+        //A plan the firmware no longer has fails here and leaves the default plan in place.
+        if(rfidr_chplan_request(m_config_record.chplan,m_config_record.chplan_seed) != RFIDR_SUCCESS){m_config_warm=false;}
+    }
+
+    return RFIDR_SUCCESS;
+}
+
+bool rfidr_config_warm(void)
+{
+    return m_config_warm;
+}
+
+uint16_t rfidr_config_spi_link_khz(void)
+{
+    return m_config_warm ? m_config_record.spi_link_khz : 0;
+}
+
+bool rfidr_config_restore_tables(void)
+{
+    if(!m_config_warm || m_config_restored){return false;}
+    m_config_restored    =    true;
+
+    if(m_config_record.chplan != rfidr_chplan_active() || m_config_record.chplan_seed != rfidr_chplan_seed()){return false;}
+
+    rfidr_txcal_import(m_config_record.txcal_offsets,m_config_record.txcal_valid);
+    rfidr_agc_import(m_config_record.agc_steps);
+
+    return true;
+}
+
+rfidr_error_t rfidr_config_save(uint16_t spi_link_khz)
+{
+    if(m_config_busy){return RFIDR_SUCCESS;}
+
+    //Before the tables have been restored, the ones in RAM are missing whatever the record holds, so don't write over it yet.
+    if(m_config_warm && !m_config_restored){return RFIDR_SUCCESS;}
+
+    memset(&m_config_record,0,sizeof(m_config_record));
+    m_config_record.version         =    RFIDR_CONFIG_VERSION;
+    m_config_record.spi_link_khz    =    spi_link_khz;
+    m_config_record.chplan          =    rfidr_chplan_active();
+    m_config_record.chplan_seed     =    rfidr_chplan_seed();
+    rfidr_txcal_export(m_config_record.txcal_offsets,m_config_record.txcal_valid);
+    rfidr_agc_export(m_config_record.agc_steps);
+    m_config_record.crc             =    config_crc(&m_config_record);
+
+    if(config_flash_current()){return RFIDR_SUCCESS;}
+
+    m_config_busy    =    true;
+    if(pstorage_update(&m_config_handle,(uint8_t *)&m_config_record,sizeof(rfidr_config_record_t),0) != NRF_SUCCESS)
+    {
+        m_config_busy    =    false;
+        return RFIDR_ERROR_CONFIG;
+    }
+
+    return RFIDR_SUCCESS;
+}
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Persistent Configuration                             //
+//                                                                              //
+// Filename: rfidr_config.h                                                     //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the prototypes for the flash record which carries the  //
+//    reader's calibration and configuration across power cycles, so that       //
+//    initialization can check the old values instead of finding them again from//
+//    scratch.                                                                  //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR persistent configuration functions
+//This file keeps one versioned, CRC-protected record in flash through the Nordic pstorage module
+
+#ifndef RFIDR_CONFIG_H__
+#define RFIDR_CONFIG_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_error.h"
+
+#define RFIDR_CONFIG_VERSION           1        //Bump whenever the record layout changes, so that an old record is ignored rather than misread.
+
+//function for registering with pstorage and reading back the record, if there is a good one
+//A good record's channel plan is requested straight away so that the first load_sx1257_default picks it up.
+//pstorage_init must have been called first.
+//returns RFIDR_SUCCESS whether or not a good record was found, or RFIDR_ERROR_CONFIG if pstorage could not be used
+
+rfidr_error_t rfidr_config_init(void);
+
+//function for checking whether a good record was found at power on
+//returns true if the record passed its version and CRC checks
+
+bool rfidr_config_warm(void);
+
+//function for reading the SPI clock kept in the record
+//returns the clock in kHz, or 0 if there is no good record
+
+uint16_t rfidr_config_spi_link_khz(void);
+
+//function for loading the TX offset and AGC gain tables from the record
+//Only the first call after power on does anything, and only if the record was made on the channel plan now active,
+//so tables found since then are never overwritten with older ones. Call it after load_sx1257_default has applied the plan.
+//returns true if the tables were loaded
+
+bool rfidr_config_restore_tables(void);
+
+//function for writing the current channel plan, TX offsets and AGC gains to flash along with the SPI clock given
+//Nothing is written if the record in flash already holds the same values, other than the AGC gains, so this can be called freely without wearing the flash.
+//The write completes in the background; if an earlier one is still in progress this one is skipped.
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_CONFIG if pstorage refused the write
+
+rfidr_error_t rfidr_config_save(uint16_t spi_link_khz);
+
+#endif
@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Gen2 CRC computation                                 //
+//                                                                              //
+// Filename: rfidr_crc.c                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains table-driven versions of the CRC-5 and CRC-16 used by  //
+//    the EPC Gen2 air interface (Annex F of the specification). Whole bytes go //
+//    through a 256-entry table; any leftover bits are done one at a time,      //
+//    exactly as the spec's shift register would do them.                       //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_crc.h"
+
+//CRC-5 polynomial x^5+x^3+1. The byte table works on the 5-bit register held in the top 5 bits of a byte (i.e. shifted left by 3),
+//so entry n is the register after shifting 8 zero bits through a register which started out as n.
+static const uint8_t m_crc5_table[256] =
+{
+    0x00, 0x48, 0x90, 0xd8, 0x68, 0x20, 0xf8, 0xb0, 0xd0, 0x98, 0x40, 0x08, 0xb8, 0xf0, 0x28, 0x60,
+    0xe8, 0xa0, 0x78, 0x30, 0x80, 0xc8, 0x10, 0x58, 0x38, 0x70, 0xa8, 0xe0, 0x50, 0x18, 0xc0, 0x88,
+    0x98, 0xd0, 0x08, 0x40, 0xf0, 0xb8, 0x60, 0x28, 0x48, 0x00, 0xd8, 0x90, 0x20, 0x68, 0xb0, 0xf8,
+    0x70, 0x38, 0xe0, 0xa8, 0x18, 0x50, 0x88, 0xc0, 0xa0, 0xe8, 0x30, 0x78, 0xc8, 0x80, 0x58, 0x10,
+    0x78, 0x30, 0xe8, 0xa0, 0x10, 0x58, 0x80, 0xc8, 0xa8, 0xe0, 0x38, 0x70, 0xc0, 0x88, 0x50, 0x18,
+    0x90, 0xd8, 0x00, 0x48, 0xf8, 0xb0, 0x68, 0x20, 0x40, 0x08, 0xd0, 0x98, 0x28, 0x60, 0xb8, 0xf0,
+    0xe0, 0xa8, 0x70, 0x38, 0x88, 0xc0, 0x18, 0x50, 0x30, 0x78, 0xa0, 0xe8, 0x58, 0x10, 0xc8, 0x80,
+    0x08, 0x40, 0x98, 0xd0, 0x60, 0x28, 0xf0, 0xb8, 0xd8, 0x90, 0x48, 0x00, 0xb0, 0xf8, 0x20, 0x68,
+    0xf0, 0xb8, 0x60, 0x28, 0x98, 0xd0, 0x08, 0x40, 0x20, 0x68, 0xb0, 0xf8, 0x48, 0x00, 0xd8, 0x90,
+    0x18, 0x50, 0x88, 0xc0, 0x70, 0x38, 0xe0, 0xa8, 0xc8, 0x80, 0x58, 0x10, 0xa0, 0xe8, 0x30, 0x78,
+    0x68, 0x20, 0xf8, 0xb0, 0x00, 0x48, 0x90, 0xd8, 0xb8, 0xf0, 0x28, 0x60, 0xd0, 0x98, 0x40, 0x08,
+    0x80, 0xc8, 0x10, 0x58, 0xe8, 0xa0, 0x78, 0x30, 0x50, 0x18, 0xc0, 0x88, 0x38, 0x70, 0xa8, 0xe0,
+    0x88, 0xc0, 0x18, 0x50, 0xe0, 0xa8, 0x70, 0x38, 0x58, 0x10, 0xc8, 0x80, 0x30, 0x78, 0xa0, 0xe8,
+    0x60, 0x28, 0xf0, 0xb8, 0x08, 0x40, 0x98, 0xd0, 0xb0, 0xf8, 0x20, 0x68, 0xd8, 0x90, 0x48, 0x00,
+    0x10, 0x58, 0x80, 0xc8, 0x78, 0x30, 0xe8, 0xa0, 0xc0, 0x88, 0x50, 0x18, 0xa8, 0xe0, 0x38, 0x70,
+    0xf8, 0xb0, 0x68, 0x20, 0x90, 0xd8, 0x00, 0x48, 0x28, 0x60, 0xb8, 0xf0, 0x40, 0x08, 0xd0, 0x98
+};
+
+//CRC-16 polynomial x^16+x^12+x^5+1 (the CCITT polynomial), MSB first.
+static const uint16_t m_crc16_table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
+};
+
+//Shift a single bit through the CRC-5 register. The register is kept in the low 5 bits.
+static uint8_t crc5_shift_bit(uint8_t state, uint8_t bit)
+{
+    uint8_t    xor_bit    =    (bit ^ (state >> 4)) & 1;
+
+    return (uint8_t)(((state << 1) ^ (xor_bit ? 0x09 : 0x00)) & 31);
+}
+
+//Shift a single bit through the CRC-16 register.
+static uint16_t crc16_shift_bit(uint16_t state, uint8_t bit)
+{
+    uint16_t   xor_bit    =    (bit ^ (state >> 15)) & 1;
+
+    return (uint16_t)((state << 1) ^ (xor_bit ? 0x1021 : 0x0000));
+}
+
+uint8_t rfidr_crc5_compute(uint32_t bits, uint8_t num_bits)
+{
+    uint8_t    state       =    RFIDR_CRC5_PRESET;
+    uint8_t    lead_bits   =    num_bits & 7;    //Bits that do not fill a whole byte are shifted in first, one at a time.
+    uint8_t    loop_bit    =    0;
+
+    if(num_bits > 32){num_bits = 32; lead_bits = 0;}
+
+    for(loop_bit=0; loop_bit<lead_bits; loop_bit++)
+    {
+        state    =    crc5_shift_bit(state,(uint8_t)(bits >> (num_bits-1-loop_bit)));
+    }
+
+    //The rest of the vector is a whole number of bytes, MSB first.
+    state    =    (uint8_t)(state << 3);
+    for(num_bits-=lead_bits; num_bits>0; num_bits-=8)
+    {
+        state    =    m_crc5_table[state ^ (uint8_t)(bits >> (num_bits-8))];
+    }
+
+    return (uint8_t)(state >> 3);
+}
+
+//Run the CRC-16 register over num_bits bits packed MSB first, starting from the preset value.
+static uint16_t crc16_run(const uint8_t * p_data, uint16_t num_bits)
+{
+    uint16_t   state       =    RFIDR_CRC16_PRESET;
+    uint16_t   loop_byte   =    0;
+    uint8_t    loop_bit    =    0;
+
+    for(loop_byte=0; loop_byte<(num_bits >> 3); loop_byte++)
+    {
+        state    =    (uint16_t)((state << 8) ^ m_crc16_table[(state >> 8) ^ p_data[loop_byte]]);
+    }
+
+    //Tag replies such as the reply to Read are not a whole number of bytes long, so finish off any trailing bits individually.
+    for(loop_bit=0; loop_bit<(num_bits & 7); loop_bit++)
+    {
+        state    =    crc16_shift_bit(state,(uint8_t)(p_data[loop_byte] >> (7-loop_bit)));
+    }
+
+    return state;
+}
+
+uint16_t rfidr_crc16_compute(const uint8_t * p_data, uint16_t num_bits)
+{
+    return (uint16_t)~crc16_run(p_data,num_bits);
+}
+
+bool rfidr_crc16_check(const uint8_t * p_data, uint16_t num_bits)
+{
+    if(num_bits < 16){return false;}
+
+    return crc16_run(p_data,num_bits) == RFIDR_CRC16_RESIDUE;
+}
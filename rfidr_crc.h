@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Gen2 CRC computation                                 //
+//                                                                              //
+// Filename: rfidr_crc.h                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains table-driven versions of the CRC-5 and CRC-16 used by  //
+//    the EPC Gen2 air interface (Annex F of the specification). It only depends//
+//    on the C standard headers so that it can also be compiled on a host       //
+//    machine.                                                                  //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR Gen2 CRC functions
+//This file provides the CRC-5 appended to Query and the CRC-16 appended to most other commands and tag replies
+
+#ifndef RFIDR_CRC_H__
+#define RFIDR_CRC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RFIDR_CRC5_PRESET          0x09      //Sec F.1: the CRC-5 register is preset to 01001b.
+#define RFIDR_CRC16_PRESET         0xFFFF    //Sec F.2: the CRC-16 register is preset to all ones.
+#define RFIDR_CRC16_RESIDUE        0x1D0F    //Sec F.2: running the CRC-16 over data followed by its own CRC-16 leaves this in the register.
+
+//function for computing the CRC-5 of the num_bits least significant bits of bits, MSB first (num_bits may be at most 32)
+//returns the 5-bit CRC
+
+uint8_t rfidr_crc5_compute(uint32_t bits, uint8_t num_bits);
+
+//function for computing the CRC-16 to be appended to num_bits bits of data, packed MSB first starting at p_data[0]
+//returns the (already complemented) 16-bit CRC
+
+uint16_t rfidr_crc16_compute(const uint8_t * p_data, uint16_t num_bits);
+
+//function for checking num_bits bits of data packed MSB first starting at p_data[0], where the final 16 bits are the CRC-16
+//returns true if the CRC-16 matches the data
+
+bool rfidr_crc16_check(const uint8_t * p_data, uint16_t num_bits);
+
+#endif
@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Dwell Time Accountant                                //
+//                                                                              //
+// Filename: rfidr_dwell.c                                                      //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the dwell time accountant. Transmit time is measured   //
+//    with the RTC1 counter, which a slow repeated app timer keeps running, and //
+//    each channel's use over the plan's sliding window is kept in a small ring //
+//    of time buckets. The buckets cover at least a full window, so a burst is  //
+//    never forgotten before it has left the window.                            //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "nrf_error.h"
+#include "rfidr_chplan.h"
+#include "rfidr_dwell.h"
+#include <string.h>
+
+#define DWELL_RTC_MASK             0x00FFFFFFUL    //RTC1 is a 24 bit counter.
+#define DWELL_RTC_HZ               32768UL
+#define DWELL_KEEPALIVE_TICKS      APP_TIMER_TICKS(60000, 0)    //RTC1 runs unprescaled (APP_TIMER_PRESCALER in main.c). Well inside the 512s wrap.
+
+APP_TIMER_DEF(m_dwell_keepalive_timer_id);
+
+//RFIDR_DWELL_NUM_BUCKETS-1 full buckets always span the window, and the current bucket only adds to that.
+//Everything in the ring is summed, so the window seen is between 1 and RFIDR_DWELL_NUM_BUCKETS/(RFIDR_DWELL_NUM_BUCKETS-1) windows long.
+static uint16_t    m_dwell_ms[RFIDR_DWELL_NUM_BUCKETS][RFIDR_CHPLAN_MAX_CHANNELS];
+static uint32_t    m_dwell_bucket_ticks      =    0;        //Length of one bucket. Zero until the first reset.
+static uint32_t    m_dwell_bucket_start      =    0;        //RTC1 count at which the current bucket began.
+static uint8_t     m_dwell_bucket            =    0;        //Index of the current bucket.
+static uint8_t     m_dwell_channel           =    0;
+static uint32_t    m_dwell_tx_start          =    0;        //RTC1 count at which the PA was turned on.
+static bool        m_dwell_tx_on             =    false;
+
+//app_timer stops RTC1 whenever no timer is pending, and then the count stands still. This timer only exists to keep one pending.
+static void dwell_keepalive_handler(void * p_context)
+{
+}
+
+static uint32_t dwell_now(void)
+{
+    uint32_t    now    =    0;
+
+    app_timer_cnt_get(&now);    //Cannot fail.
+    return now;
+}
+
+//Round up, so that short bursts are never lost. ticks*125 stays below 2^32 for any 24 bit count.
+static uint16_t dwell_ticks_to_ms(uint32_t ticks)
+{
+    uint32_t    ms    =    (ticks*125+4095) >> 12;
+
+    return (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+}
+
+//Retire buckets which have fallen out of the window.
+//If the counter wraps while the reader is idle for over 8 minutes, too few buckets get retired, which errs on the safe side.
+static void dwell_advance(uint32_t now)
+{
+    uint32_t    elapsed      =    (now-m_dwell_bucket_start) & DWELL_RTC_MASK;
+    uint8_t     loop_retire  =    0;
+
+    if(m_dwell_bucket_ticks == 0){rfidr_dwell_reset(); return;}
+
+    for(loop_retire=0;loop_retire < RFIDR_DWELL_NUM_BUCKETS && elapsed >= m_dwell_bucket_ticks;loop_retire++)
+    {
+        m_dwell_bucket=(uint8_t)((m_dwell_bucket+1) % RFIDR_DWELL_NUM_BUCKETS);
+        memset(m_dwell_ms[m_dwell_bucket],0,sizeof(m_dwell_ms[m_dwell_bucket]));
+        m_dwell_bucket_start=(m_dwell_bucket_start+m_dwell_bucket_ticks) & DWELL_RTC_MASK;
+        elapsed-=m_dwell_bucket_ticks;
+    }
+
+    if(elapsed >= m_dwell_bucket_ticks){m_dwell_bucket_start=now;}    //Everything is already clear, so just restart the ring.
+}
+
+//Charge the time since m_dwell_tx_start to the current channel and restart the burst from now.
+//The whole burst goes into the current bucket, which keeps it in the window for longest.
+static void dwell_charge(uint32_t now)
+{
+    uint16_t    *p_bucket    =    &m_dwell_ms[m_dwell_bucket][m_dwell_channel];
+    uint32_t    sum          =    (uint32_t)*p_bucket+dwell_ticks_to_ms((now-m_dwell_tx_start) & DWELL_RTC_MASK);
+
+    *p_bucket           =    (sum > 0xFFFF) ? 0xFFFF : (uint16_t)sum;
+    m_dwell_tx_start    =    now;
+}
+
+//Set the bucket length from the window of the active plan.
+static void dwell_set_bucket_ticks(void)
+{
+    uint32_t    window_ticks    =    (uint32_t)rfidr_chplan_dwell_window_ms()*DWELL_RTC_HZ/1000;
+
+    m_dwell_bucket_ticks    =    (window_ticks+RFIDR_DWELL_NUM_BUCKETS-2)/(RFIDR_DWELL_NUM_BUCKETS-1);
+}
+
+//Called once from main after APP_TIMER_INIT.
+void rfidr_dwell_init(void)
+{
+    uint32_t    error_code    =    NRF_SUCCESS;
+
+    error_code    =    app_timer_create(&m_dwell_keepalive_timer_id, APP_TIMER_MODE_REPEATED, dwell_keepalive_handler);
+    APP_ERROR_CHECK(error_code);
+    error_code    =    app_timer_start(m_dwell_keepalive_timer_id, DWELL_KEEPALIVE_TICKS, NULL);
+    APP_ERROR_CHECK(error_code);
+
+    rfidr_dwell_reset();
+}
+
+void rfidr_dwell_reset(void)
+{
+    memset(m_dwell_ms,0,sizeof(m_dwell_ms));
+    dwell_set_bucket_ticks();
+    m_dwell_bucket_start    =    dwell_now();
+    m_dwell_bucket          =    0;
+}
+
+//Channel numbers change meaning, so every channel of the new plan takes on the busiest old channel's time in each bucket.
+//A bucket is only cleared once N-1 whole buckets have gone by after it, and that is at least one window whatever length the old buckets were.
+void rfidr_dwell_replan(void)
+{
+    uint32_t    now            =    dwell_now();
+    uint16_t    busiest        =    0;
+    uint8_t     loop_bucket    =    0;
+    uint8_t     loop_chan      =    0;
+
+    if(m_dwell_tx_on){dwell_advance(now); dwell_charge(now);}
+
+    for(loop_bucket=0;loop_bucket < RFIDR_DWELL_NUM_BUCKETS;loop_bucket++)
+    {
+        busiest=0;
+        for(loop_chan=0;loop_chan < RFIDR_CHPLAN_MAX_CHANNELS;loop_chan++)
+        {
+            if(m_dwell_ms[loop_bucket][loop_chan] > busiest){busiest=m_dwell_ms[loop_bucket][loop_chan];}
+        }
+        for(loop_chan=0;loop_chan < RFIDR_CHPLAN_MAX_CHANNELS;loop_chan++)
+        {
+            m_dwell_ms[loop_bucket][loop_chan]=busiest;
+        }
+    }
+
+    dwell_set_bucket_ticks();
+}
+
+void rfidr_dwell_set_channel(uint8_t channel)
+{
+    uint32_t    now    =    0;
+
+    if(channel >= RFIDR_CHPLAN_MAX_CHANNELS){channel=0;}
+    if(channel == m_dwell_channel){return;}
+
+    if(m_dwell_tx_on)
+    {
+        now=dwell_now();
+        dwell_advance(now);
+        dwell_charge(now);
+    }
+
+    m_dwell_channel    =    channel;
+}
+
+void rfidr_dwell_tx_on(void)
+{
+    if(m_dwell_tx_on){return;}
+
+    m_dwell_tx_start    =    dwell_now();
+    m_dwell_tx_on       =    true;
+}
+
+void rfidr_dwell_tx_off(void)
+{
+    uint32_t    now    =    0;
+
+    if(!m_dwell_tx_on){return;}
+
+    now=dwell_now();
+    dwell_advance(now);
+    dwell_charge(now);
+    m_dwell_tx_on    =    false;
+}
+
+uint16_t rfidr_dwell_remaining_ms(void)
+{
+    uint32_t    now            =    dwell_now();
+    uint32_t    used           =    0;
+    uint16_t    max_dwell      =    rfidr_chplan_max_dwell_ms();
+    uint8_t     loop_bucket    =    0;
+
+    dwell_advance(now);
+
+    for(loop_bucket=0;loop_bucket < RFIDR_DWELL_NUM_BUCKETS;loop_bucket++)
+    {
+        used+=m_dwell_ms[loop_bucket][m_dwell_channel];
+    }
+
+    if(m_dwell_tx_on){used+=dwell_ticks_to_ms((now-m_dwell_tx_start) & DWELL_RTC_MASK);}
+
+    return (used >= max_dwell) ? 0 : (uint16_t)(max_dwell-used);
+}
@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Dwell Time Accountant                                //
+//                                                                              //
+// Filename: rfidr_dwell.h                                                      //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the prototypes for the accountant which keeps track of //
+//    how long the PA has been on at each channel of the active channel plan, so//
+//    that the state machine can hop before a regulatory dwell limit is reached //
+//    rather than relying on a fixed cap on query round length.                 //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR dwell time functions
+//This file provides per-channel transmit time accounting over the sliding window of the active channel plan
+
+#ifndef RFIDR_DWELL_H__
+#define RFIDR_DWELL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RFIDR_DWELL_NUM_BUCKETS    4        //Each channel's window is kept as this many buckets, at 2 bytes of RAM per bucket per channel.
+
+//function for starting the timer which keeps RTC1 counting, and clearing the accounts
+//Called once from main after APP_TIMER_INIT.
+
+void rfidr_dwell_init(void);
+
+//function for forgetting all transmit time
+
+void rfidr_dwell_reset(void);
+
+//function for carrying the transmit time over to a new channel plan, once it has been applied
+//Every new channel is charged as much as the busiest old one, so a plan change never frees up transmit time early.
+
+void rfidr_dwell_replan(void);
+
+//function for telling the accountant which channel the SX1257 is now tuned to
+//If the PA is on, the time up to now is charged to the old channel and the time from now on to the new one.
+
+void rfidr_dwell_set_channel(uint8_t channel);
+
+//function for telling the accountant that the PA has just been turned on
+
+void rfidr_dwell_tx_on(void);
+
+//function for telling the accountant that the PA has just been turned off
+
+void rfidr_dwell_tx_off(void);
+
+//function for reading how much transmit time the current channel has left within the dwell window of the active plan
+//Includes the time since the PA was last turned on, if it is still on.
+//returns the remaining time in ms, 0 if the channel is used up
+
+uint16_t rfidr_dwell_remaining_ms(void);
+
+#endif
@@ -59,7 +59,13 @@ typedef enum
   RFIDR_ERROR_WAVE_MEM_1,
   RFIDR_ERROR_WAVE_MEM_2,
   RFIDR_ERROR_USER_MEM,
-  RFIDR_ERROR_GENERAL
+  RFIDR_ERROR_GENERAL,
+  RFIDR_ERROR_SPI_BURST,
+  RFIDR_ERROR_SPI_LINK,
+  RFIDR_ERROR_EPC_CRC,
+  RFIDR_ERROR_SX1257_PLL_LOCK,
+  RFIDR_ERROR_CONFIG,
+  RFIDR_ERROR_BLE_REPORT_TIMEOUT
 }rfidr_error_t;
 
 uint32_t    rfidr_error_complete_message_send(ble_rfidrs_t * p_rfidrs, uint8_t * p_string);
@@ -42,6 +42,7 @@
 #include "nrf_delay.h"
 #include "nrf_error.h"
 #include "nordic_common.h"
+#include "rfidr_dwell.h"
 #include "rfidr_error.h"
 #include "rfidr_gpio.h"
 #include "rfidr_state.h"
@@ -422,6 +423,7 @@ rfidr_error_t rfidr_enable_pa(void)
 {
     nrf_drv_gpiote_out_set(OPA_SPDT1_CTL_PIN);
     nrf_drv_gpiote_out_set(EN_VDD_PA_PIN);
+    rfidr_dwell_tx_on(); //Transmit time is charged to the current channel from here on.
     nrf_delay_us(250); //Set a mandatory delay after powering up the PA.
     return RFIDR_SUCCESS;
 }
@@ -431,6 +433,7 @@ rfidr_error_t rfidr_disable_pa(void)
 {
     nrf_drv_gpiote_out_clear(EN_VDD_PA_PIN);
     nrf_drv_gpiote_out_clear(OPA_SPDT1_CTL_PIN);
+    rfidr_dwell_tx_off();
     nrf_delay_us(250); //Set a mandatory delay after powering down the PA.
     return RFIDR_SUCCESS;
 }
@@ -480,6 +483,7 @@ rfidr_error_t rfidr_disable_radio(void)
 {
     nrf_delay_ms(20);
     nrf_drv_gpiote_out_set(RDIO_RST_P_PIN);
+    invalidate_sx1257_shadow(); //Held in reset, the SX1257 loses its registers.
     nrf_delay_ms(20);
     return RFIDR_SUCCESS;
 }
@@ -492,6 +496,7 @@ rfidr_error_t rfidr_reset_radio(void)
     nrf_drv_gpiote_out_set(RDIO_RST_P_PIN);
     nrf_delay_ms(20);
     nrf_drv_gpiote_out_clear(RDIO_RST_P_PIN);
+    invalidate_sx1257_shadow(); //The SX1257 is back at its power-on register values.
     nrf_delay_ms(20);
     return RFIDR_SUCCESS;
 }
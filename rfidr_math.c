@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Fixed-Point Math                                     //
+//                                                                              //
+// Filename: rfidr_math.c                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the fixed-point math kernels used by the RSSI, phase,  //
+//    gain control and ranging code. The nRF51822 is a Cortex-M0 with no FPU, no//
+//    DSP instructions and no hardware divider, so the CMSIS DSP library in     //
+//    components/toolchain/gcc is of no use here.                               //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_math.h"
+
+#define CORDIC_STEPS            16
+#define CORDIC_INPUT_LIMIT      (1L << 29)    //The CORDIC grows the vector by 1.65 and the pre-rotation by up to sqrt(2), so this keeps x below 2^31.
+#define CORDIC_GAIN_INV_Q16     39797         //1/1.64676 (the CORDIC gain after 16 steps) in Q0.16.
+#define DB20_PER_LOG2_Q12       24660         //20*log10(2) in Q4.12.
+
+//atan(2^-i) in units where 65536 is a full circle.
+static const uint16_t m_cordic_atan[CORDIC_STEPS] = {8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1, 1, 0};
+
+void rfidr_math_cordic_vector(int32_t x, int32_t y, uint32_t * p_magnitude, uint16_t * p_phase)
+{
+    int32_t     x_next      =    0;
+    uint16_t    angle       =    0;
+    int8_t      shift       =    0;    //Positive when the inputs were scaled down, negative when they were scaled up.
+    uint8_t     step        =    0;
+    uint32_t    magnitude   =    0;
+
+    if(x == 0 && y == 0)
+    {
+        *p_magnitude    =    0;
+        *p_phase        =    0;
+        return;
+    }
+
+    //Scale the inputs so that the larger one sits just under CORDIC_INPUT_LIMIT.
+    //Scaling down keeps the iterations from overflowing; scaling up keeps the y >> step terms from truncating to nothing for small vectors.
+    while(x >= CORDIC_INPUT_LIMIT || x <= -CORDIC_INPUT_LIMIT || y >= CORDIC_INPUT_LIMIT || y <= -CORDIC_INPUT_LIMIT)
+    {
+        x >>= 1;
+        y >>= 1;
+        shift++;
+    }
+    while(x < CORDIC_INPUT_LIMIT/2 && x > -CORDIC_INPUT_LIMIT/2 && y < CORDIC_INPUT_LIMIT/2 && y > -CORDIC_INPUT_LIMIT/2)
+    {
+        x *= 2;
+        y *= 2;
+        shift--;
+    }
+
+    //The CORDIC only converges for angles within +/-99 degrees, so start from the right half-plane.
+    if(x < 0)
+    {
+        x=-x;
+        y=-y;
+        angle=32768;
+    }
+
+    for(step=0;step < CORDIC_STEPS;step++)
+    {
+        if(y > 0)
+        {
+            x_next    =    x+(y >> step);
+            y         =    y-(x >> step);
+            angle    +=    m_cordic_atan[step];
+        }
+        else
+        {
+            x_next    =    x-(y >> step);
+            y         =    y+(x >> step);
+            angle    -=    m_cordic_atan[step];
+        }
+        x=x_next;
+    }
+
+    //Remove the CORDIC gain without a 64-bit multiply.
+    magnitude=((uint32_t)x >> 16)*CORDIC_GAIN_INV_Q16+((((uint32_t)x & 0xFFFF)*CORDIC_GAIN_INV_Q16) >> 16);
+
+    if(shift < 0)
+        magnitude=(magnitude+(1UL << (-shift-1))) >> (-shift);    //Round to nearest.
+    else if(shift > 0 && magnitude > (0xFFFFFFFFUL >> shift))
+        magnitude=0xFFFFFFFFUL;
+    else
+        magnitude <<= shift;
+
+    *p_magnitude    =    magnitude;
+    *p_phase        =    angle;
+}
+
+//log2 by repeated squaring: the integer part is the position of the leading one, and each squaring of the normalized mantissa yields one fractional bit.
+uint32_t rfidr_math_log2(uint32_t value)
+{
+    uint32_t    log2_q12    =    0;
+    uint32_t    mantissa    =    0;
+    uint8_t     msb         =    31;
+    uint8_t     bit         =    0;
+
+    if(value == 0){return 0;}
+
+    while((value & (1UL << msb)) == 0){msb--;}
+
+    //Normalize the mantissa to Q1.15 in [1,2).
+    mantissa=(msb >= 15) ? (value >> (msb-15)) : (value << (15-msb));
+    log2_q12=(uint32_t)msb << RFIDR_MATH_LOG2_FRAC_BITS;
+
+    for(bit=1;bit <= RFIDR_MATH_LOG2_FRAC_BITS;bit++)
+    {
+        mantissa=(mantissa*mantissa) >> 15;
+        if(mantissa >= (2UL << 15))
+        {
+            mantissa >>= 1;
+            log2_q12 |= 1UL << (RFIDR_MATH_LOG2_FRAC_BITS-bit);
+        }
+    }
+
+    return log2_q12;
+}
+
+uint16_t rfidr_math_db20(uint32_t value)
+{
+    //log2 is below 32, so this product fits in 32 bits, and the dB value (at most 193) fits in Q8.8.
+    return (uint16_t)((rfidr_math_log2(value)*DB20_PER_LOG2_Q12) >> 16);
+}
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Fixed-Point Math                                     //
+//                                                                              //
+// Filename: rfidr_math.h                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the fixed-point math kernels used by the RSSI, phase,  //
+//    gain control and ranging code. The nRF51822 is a Cortex-M0 with no FPU, no//
+//    DSP instructions and no hardware divider, so the CMSIS DSP library in     //
+//    components/toolchain/gcc is of no use here.                               //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR fixed-point math functions
+//This file provides CORDIC and logarithm kernels using only shifts, adds and 32-bit multiplies
+
+#ifndef RFIDR_MATH_H__
+#define RFIDR_MATH_H__
+
+#include <stdint.h>
+
+#define RFIDR_MATH_LOG2_FRAC_BITS    12       //Fractional bits of rfidr_math_log2.
+
+//function for computing the magnitude and phase of the vector (x,y) with a 16-step CORDIC
+//Cost: two normalization loops of up to 30 passes each, then 16 add/shift iterations and 2 multiplies; no division
+//phase is atan2(y,x) where 65536 is a full circle; magnitude saturates at 0xFFFFFFFF
+
+void rfidr_math_cordic_vector(int32_t x, int32_t y, uint32_t * p_magnitude, uint16_t * p_phase);
+
+//function for computing log2 of a value by repeated squaring
+//Cost: a leading-one search of up to 31 passes, then 12 multiplies; no division
+//returns log2(value) as unsigned Q5.12, or 0 for a value of 0
+
+uint32_t rfidr_math_log2(uint32_t value);
+
+//function for converting an amplitude to dB
+//Cost: one rfidr_math_log2 and one multiply
+//returns 20*log10(value) as unsigned Q8.8, or 0 for a value of 0 (good to about 0.01dB)
+
+uint16_t rfidr_math_db20(uint32_t value);
+
+#endif
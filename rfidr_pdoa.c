@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware PDOA Ranging                                         //
+//                                                                              //
+// Filename: rfidr_pdoa.c                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file pairs up the hop and skip reads of a tag made during tracking   //
+//    and turns the change in calibrated phase between them into a range. Each  //
+//    read's phase is taken relative to the calibration tag read at the same    //
+//    frequency, which removes the phase of the reader's own signal path.       //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_chplan.h"
+#include "rfidr_pdoa.h"
+#include "rfidr_rssi.h"
+#include "rfidr_tagtable.h"
+#include <stddef.h>
+
+//c/2 in cm per ms, so that dividing by a frequency difference in kHz gives the unambiguous range c/(2*delta_f) in cm.
+#define PDOA_HALF_C_CM_KHZ           14989623UL
+
+typedef struct
+{
+    uint32_t       hash;                                //rfidr_epc_hash of the tag's EPC.
+    uint16_t       phase;                               //Tag phase minus calibration tag phase at the hop, 65536 to a full circle.
+    uint8_t        rssi;                                //Tag RSSI at the hop, in whole dB.
+    uint8_t        frequency_slot;
+} pdoa_entry_t;
+
+static pdoa_entry_t    m_pdoa_table[RFIDR_PDOA_TABLE_SIZE];
+static uint8_t         m_pdoa_count               =    0;    //Entries in use, all of which belong to m_pdoa_nonce.
+static uint8_t         m_pdoa_nonce               =    0;    //Hop/skip nonce of the hop whose reads are in the table.
+
+//Work out the EPC hash, calibrated phase and RSSI of a tag read.
+static rfidr_error_t pdoa_measure(const rfidr_return_t * p_ant, const rfidr_return_t * p_cal, uint32_t * p_hash, uint16_t * p_phase, uint8_t * p_rssi)
+{
+    rfidr_rssi_t     rssi_ant;
+    rfidr_rssi_t     rssi_cal;
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+
+    error_code=rfidr_rssi_from_return(p_ant,&rssi_ant);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+    error_code=rfidr_rssi_from_return(p_cal,&rssi_cal);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    *p_hash=rfidr_epc_hash((rssi_ant.choose_i == RFIDR_RSSI_CHOOSE_I) ? p_ant->i_epc : p_ant->q_epc);
+    *p_phase=(uint16_t)(rssi_ant.phase-rssi_cal.phase);
+    *p_rssi=(uint8_t)(rssi_ant.rssi >> 8);    //Integrator magnitudes are at most 32b, so this is at most 193dB.
+
+    return RFIDR_SUCCESS;
+}
+
+void rfidr_pdoa_reset(void)
+{
+    m_pdoa_count    =    0;
+}
+
+rfidr_error_t rfidr_pdoa_store_hop(const rfidr_return_t * p_ant, const rfidr_return_t * p_cal, uint8_t frequency_slot, uint8_t hopskip_nonce)
+{
+    pdoa_entry_t     entry;
+    uint8_t          loop_entry    =    0;
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+
+    error_code=pdoa_measure(p_ant,p_cal,&entry.hash,&entry.phase,&entry.rssi);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+    entry.frequency_slot=frequency_slot;
+
+    //Reads from an earlier hop can never be paired again, so a new nonce empties the table.
+    if(hopskip_nonce != m_pdoa_nonce)
+    {
+        m_pdoa_count    =    0;
+        m_pdoa_nonce    =    hopskip_nonce;
+    }
+
+    //A tag read twice at one hop keeps its latest read.
+    for(loop_entry=0;loop_entry < m_pdoa_count;loop_entry++)
+    {
+        if(m_pdoa_table[loop_entry].hash == entry.hash){break;}
+    }
+
+    if(loop_entry == RFIDR_PDOA_TABLE_SIZE){return RFIDR_ERROR_GENERAL;}
+    if(loop_entry == m_pdoa_count){m_pdoa_count++;}
+    m_pdoa_table[loop_entry]=entry;
+
+    return RFIDR_SUCCESS;
+}
+
+//Received phase falls by 4*pi*R/c radians per Hz of carrier, since the signal travels to the tag and back.
+//So R = c*(phase_hop-phase_skip)/(4*pi*(f_skip-f_hop)), and wrapping the phase difference into one circle (which the 16b arithmetic does for free)
+//unwraps the range into [0,c/(2*|f_skip-f_hop|)), which is about 50m for the 3MHz skip used by tracking with the default channel plan.
+rfidr_error_t rfidr_pdoa_compute_range(const rfidr_return_t * p_ant, const rfidr_return_t * p_cal, uint8_t frequency_slot, uint8_t hopskip_nonce, rfidr_pdoa_range_t * p_range)
+{
+    uint32_t         hash               =    0;
+    uint16_t         phase              =    0;
+    uint16_t         phase_delta        =    0;
+    uint8_t          rssi               =    0;
+    uint8_t          loop_entry         =    0;
+    uint8_t          abs_delta_slots    =    0;
+    uint32_t         cycle_range        =    0;
+    uint32_t         confidence         =    0;
+    pdoa_entry_t     *p_entry           =    NULL;
+    rfidr_error_t    error_code         =    RFIDR_SUCCESS;
+
+    if(hopskip_nonce != m_pdoa_nonce){return RFIDR_ERROR_GENERAL;}
+
+    error_code=pdoa_measure(p_ant,p_cal,&hash,&phase,&rssi);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    for(loop_entry=0;loop_entry < m_pdoa_count;loop_entry++)
+    {
+        if(m_pdoa_table[loop_entry].hash == hash){break;}
+    }
+    if(loop_entry == m_pdoa_count){return RFIDR_ERROR_GENERAL;}
+    p_entry=&m_pdoa_table[loop_entry];
+
+    if(frequency_slot == p_entry->frequency_slot){return RFIDR_ERROR_GENERAL;}
+
+    p_range->delta_slots=(int8_t)(frequency_slot-p_entry->frequency_slot);
+    if(p_range->delta_slots > 0)
+    {
+        abs_delta_slots    =    (uint8_t)p_range->delta_slots;
+        phase_delta        =    (uint16_t)(p_entry->phase-phase);
+    }
+    else
+    {
+        abs_delta_slots    =    (uint8_t)(-p_range->delta_slots);
+        phase_delta        =    (uint16_t)(phase-p_entry->phase);
+    }
+
+    //No channel plan has channels closer than 250kHz, so the range of a full circle is under 600m and the product below stays under 2^32.
+    cycle_range=PDOA_HALF_C_CM_KHZ/((uint32_t)abs_delta_slots*rfidr_chplan_spacing_khz());
+    p_range->range=(uint16_t)((cycle_range*phase_delta) >> 16);
+
+    //Phase noise goes as 1/SNR and the range error as phase noise over delta f, so weaken the confidence for weak reads and short skips.
+    //A read 64dB above the floor gets full marks.
+    if(rssi > p_entry->rssi){rssi=p_entry->rssi;}
+    confidence=(rssi > RFIDR_PDOA_RSSI_FLOOR_DB) ? ((uint32_t)(rssi-RFIDR_PDOA_RSSI_FLOOR_DB) << 2) : 0;
+    if(confidence > 255){confidence=255;}
+    if(abs_delta_slots < RFIDR_PDOA_MAX_SKIP_SLOTS){confidence=(confidence*abs_delta_slots)/RFIDR_PDOA_MAX_SKIP_SLOTS;}
+    p_range->confidence=(uint8_t)confidence;
+
+    return RFIDR_SUCCESS;
+}
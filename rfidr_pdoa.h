@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware PDOA Ranging                                         //
+//                                                                              //
+// Filename: rfidr_pdoa.h                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file pairs up the hop and skip reads of a tag made during tracking   //
+//    and turns the change in calibrated phase between them into a range, so    //
+//    that the iDevice only needs to be sent the range.                         //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR PDOA ranging functions
+//This file provides phase difference of arrival range estimates for tracked tags
+
+#ifndef RFIDR_PDOA_H__
+#define RFIDR_PDOA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_error.h"
+#include "rfidr_rxradio.h"
+
+#define RFIDR_PDOA_TABLE_SIZE        16       //Tags whose hop read can be remembered at once. Each entry costs 8 bytes of RAM.
+#define RFIDR_PDOA_MAX_SKIP_SLOTS    3        //Largest hop to skip distance (in channels) used by tracking, which gets full confidence.
+#define RFIDR_PDOA_RSSI_FLOOR_DB     40       //RSSI (in dB of integrator magnitude) at and below which a read gets no confidence.
+
+typedef struct
+{
+    uint16_t       range;                               //Tag range in cm, modulo the unambiguous range of c/(2*delta_f).
+    uint8_t        confidence;                          //0 (useless) to 255, from the weaker of the two reads and the hop to skip distance.
+    int8_t         delta_slots;                         //Skip slot minus hop slot.
+} rfidr_pdoa_range_t;
+
+//function for forgetting all stored hop reads, to be called whenever tracking starts
+
+void rfidr_pdoa_reset(void);
+
+//function for storing the calibrated phase of a tag read made right after a frequency hop
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_GENERAL if either read did not pass or the table is full
+
+rfidr_error_t rfidr_pdoa_store_hop(const rfidr_return_t * p_ant, const rfidr_return_t * p_cal, uint8_t frequency_slot, uint8_t hopskip_nonce);
+
+//function for computing the range of a tag from a read made after a frequency skip and the hop read stored for the same tag and nonce
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_GENERAL if either read did not pass or there is no matching hop read
+
+rfidr_error_t rfidr_pdoa_compute_range(const rfidr_return_t * p_ant, const rfidr_return_t * p_cal, uint8_t frequency_slot, uint8_t hopskip_nonce, rfidr_pdoa_range_t * p_range);
+
+#endif
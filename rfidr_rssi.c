@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware RSSI and Phase                                       //
+//                                                                              //
+// Filename: rfidr_rssi.c                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file turns the I and Q integrator magnitudes recovered for a tag into//
+//    an RSSI in dB and a phase angle, in fixed point only, since the Cortex-M0 //
+//    has no FPU. The phase and vector magnitude come from a CORDIC in vectoring//
+//    mode and the dB value from a bitwise log2 (rfidr_math.c).                 //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_agc.h"
+#include "rfidr_math.h"
+#include "rfidr_rssi.h"
+
+uint8_t rfidr_rssi_choose_i(const rfidr_return_t * p_return)
+{
+    if(p_return->i_pass && p_return->q_pass)
+        return ((p_return->i_main_mag) > (p_return->q_main_mag)) ? RFIDR_RSSI_CHOOSE_I : RFIDR_RSSI_CHOOSE_Q;
+    else if(p_return->i_pass)
+        return RFIDR_RSSI_CHOOSE_I;
+    else if(p_return->q_pass)
+        return RFIDR_RSSI_CHOOSE_Q;
+    else
+        return RFIDR_RSSI_CHOOSE_NONE;
+}
+
+rfidr_error_t rfidr_rssi_iq(const rfidr_return_t * p_return, int32_t * p_i_mag, int32_t * p_q_mag)
+{
+    switch(rfidr_rssi_choose_i(p_return))
+    {
+        case RFIDR_RSSI_CHOOSE_I:
+            *p_i_mag=p_return->i_main_mag;
+            *p_q_mag=p_return->i_alt_mag;
+            return RFIDR_SUCCESS;
+        case RFIDR_RSSI_CHOOSE_Q:
+            *p_i_mag=p_return->q_alt_mag;
+            *p_q_mag=p_return->q_main_mag;
+            return RFIDR_SUCCESS;
+        default:
+            *p_i_mag=0;
+            *p_q_mag=0;
+            return RFIDR_ERROR_GENERAL;
+    }
+}
+
+rfidr_error_t rfidr_rssi_from_return(const rfidr_return_t * p_return, rfidr_rssi_t * p_rssi)
+{
+    int32_t          i_mag         =    0;
+    int32_t          q_mag         =    0;
+    uint16_t         lna_gain_db   =    0;
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+
+    p_rssi->choose_i=rfidr_rssi_choose_i(p_return);
+
+    error_code=rfidr_rssi_iq(p_return,&i_mag,&q_mag);
+    if(error_code != RFIDR_SUCCESS)
+    {
+        p_rssi->magnitude    =    0;
+        p_rssi->rssi         =    0;
+        p_rssi->phase        =    0;
+        return error_code;
+    }
+
+    rfidr_math_cordic_vector(i_mag,q_mag,&(p_rssi->magnitude),&(p_rssi->phase));
+    p_rssi->rssi=rfidr_math_db20(p_rssi->magnitude);
+
+    //Take off whatever gain the AGC added above 0xD4 so that RSSI compares across channels and rounds.
+    lna_gain_db=rfidr_agc_gain_above_default_db((p_rssi->choose_i == RFIDR_RSSI_CHOOSE_I) ? p_return->i_lna_gain : p_return->q_lna_gain);
+    p_rssi->rssi=(p_rssi->rssi > lna_gain_db) ? (p_rssi->rssi-lna_gain_db) : 0;
+
+    return RFIDR_SUCCESS;
+}
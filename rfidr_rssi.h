@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware RSSI and Phase                                       //
+//                                                                              //
+// Filename: rfidr_rssi.h                                                       //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file turns the I and Q integrator magnitudes recovered for a tag into//
+//    an RSSI in dB and a phase angle, in fixed point only, since the Cortex-M0 //
+//    has no FPU. The phase and vector magnitude come from a CORDIC in vectoring//
+//    mode and the dB value from a bitwise log2 (rfidr_math.c).                 //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR RSSI and phase functions
+//This file provides fixed-point RSSI and phase estimates for a tag read, including the choice between the I and Q runs
+
+#ifndef RFIDR_RSSI_H__
+#define RFIDR_RSSI_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_error.h"
+#include "rfidr_rxradio.h"
+
+#define RFIDR_RSSI_CHOOSE_Q         0        //Use the Q run of the tag read.
+#define RFIDR_RSSI_CHOOSE_I         1        //Use the I run of the tag read.
+#define RFIDR_RSSI_CHOOSE_NONE      255      //Neither run passed.
+
+typedef struct
+{
+    uint32_t       magnitude;                           //sqrt(I^2+Q^2), in integrator LSBs.
+    uint16_t       rssi;                                //20*log10(magnitude) less any LNA gain above 0xD4, in dB as unsigned Q8.8.
+    uint16_t       phase;                               //atan2(Q,I), where 65536 is a full circle.
+    uint8_t        choose_i;                            //Which run the estimate came from, RFIDR_RSSI_CHOOSE_x.
+} rfidr_rssi_t;
+
+//function for picking the I or Q run of a tag read: whichever passed, or the one with the larger main magnitude if both did
+//returns RFIDR_RSSI_CHOOSE_I, RFIDR_RSSI_CHOOSE_Q or RFIDR_RSSI_CHOOSE_NONE
+
+uint8_t rfidr_rssi_choose_i(const rfidr_return_t * p_return);
+
+//function for finding the I and Q magnitudes of the chosen run of a tag read
+//For an I run, I is the main integrator and Q the alt integrator, and vice versa for a Q run.
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_GENERAL if neither run passed
+
+rfidr_error_t rfidr_rssi_iq(const rfidr_return_t * p_return, int32_t * p_i_mag, int32_t * p_q_mag);
+
+//function for computing the RSSI and phase of a tag read
+//returns RFIDR_SUCCESS, or RFIDR_ERROR_GENERAL if neither run passed (p_rssi->choose_i is then RFIDR_RSSI_CHOOSE_NONE)
+
+rfidr_error_t rfidr_rssi_from_return(const rfidr_return_t * p_return, rfidr_rssi_t * p_rssi);
+
+#endif
@@ -31,11 +31,15 @@
 //////////////////////////////////////////////////////////////////////////////////
 
 #include "app_error.h"
+#include "app_timer.h"
 #include "app_util_platform.h"
 #include "ble_rfidrs.h"
 #include "nordic_common.h"
 #include "nrf_error.h"
+#include "nrf_soc.h"
+#include "rfidr_crc.h"
 #include "rfidr_error.h"
+#include "rfidr_rssi.h"
 #include "rfidr_spi.h"
 #include "rfidr_state.h"
 #include "rfidr_rxradio.h"
@@ -70,6 +74,188 @@
 #define    RX_BITS_READ                 129       //(1 bit header+96 bits+16 bit RN+16 bit CRC).
 #define    RX_BITS_PCEPC                128       //See Table 6.17 of spec. We get PC(16b)+EPC(96b)+CRC(16b)=128b back.
 
+#define    RX_BYTES_PCEPC               ((RX_BITS_PCEPC+7) >> 3)
+#define    RX_BYTES_READ                ((RX_BITS_READ+7) >> 3)
+
+//Layout of the PCEPC section after the byte holding the number of bits to expect, as offsets from RX_RAM_ADDR_OFFSET_PCEPC << 4.
+#define    RX_PCEPC_OFFSET_DATA         1         //PC, then EPC, then CRC-16.
+#define    RX_PCEPC_OFFSET_EXIT_CODE    (RX_PCEPC_OFFSET_DATA+RX_BYTES_PCEPC)
+#define    RX_PCEPC_OFFSET_MAIN_MAG     (RX_PCEPC_OFFSET_EXIT_CODE+1)
+#define    RX_PCEPC_OFFSET_ALT_MAG      (RX_PCEPC_OFFSET_MAIN_MAG+4)
+#define    RX_PCEPC_RECORD_LENGTH       (RX_PCEPC_OFFSET_ALT_MAG+4-RX_PCEPC_OFFSET_DATA)
+
+//Tag reports waiting to go out over BTLE. The RF loop formats a report into the slot at the head and moves on;
+//the slot at the tail is sent from the SoftDevice event handler, one indication per confirmation, so a tag read never waits on a connection interval.
+//The RF loop (thread mode) only writes m_report_head and the SoftDevice event handler only writes m_report_tail, so the ring needs no lock to be filled.
+//Sending is serialized by doing it inside a critical region from either side.
+#define    REPORT_QUEUE_DEPTH           8         //Must be a power of 2. Each slot costs 38 bytes of RAM.
+#define    REPORT_QUEUE_MASK            (REPORT_QUEUE_DEPTH-1)
+
+typedef struct
+{
+    uint8_t    pckt_data1[BLE_RFIDRS_PCKT_DATA1_CHAR_LEN];
+    uint8_t    pckt_data2[BLE_RFIDRS_PCKT_DATA2_CHAR_LEN];
+    bool       has_pckt_data1;
+    bool       has_pckt_data2;
+} rfidr_report_t;
+
+static rfidr_report_t      m_report_queue[REPORT_QUEUE_DEPTH];
+static volatile uint8_t    m_report_head                =    0;        //Next slot the RF loop will fill.
+static volatile uint8_t    m_report_tail                =    0;        //Slot currently being sent to the iDevice.
+static bool                m_report_data1_sent          =    false;    //The tail slot's data 1 indication has been handed to the SoftDevice.
+static bool                m_report_data2_sent          =    false;    //The tail slot's data 2 notification has been handed to the SoftDevice.
+static bool                m_report_data1_confirmed     =    false;    //The iDevice has acknowledged the tail slot's data 1 indication.
+static uint8_t             m_report_data_id             =    0;        //Nonce counting how many packets we have sent to the iDevice, in either report format.
+
+//Waiting on the queue gives up after this long, in case the iDevice stays connected but stops acknowledging indications.
+//A link that has really gone away is dropped by the SoftDevice after the 4s supervision timeout, which empties the queue anyway.
+#define    REPORT_WAIT_TIMEOUT_TICKS    APP_TIMER_TICKS(5000, 0)    //RTC1 runs unprescaled (APP_TIMER_PRESCALER in main.c).
+
+APP_TIMER_DEF(m_report_wait_timer_id);
+static volatile bool       m_report_wait_expired        =    false;    //Set by the timer once a wait on the queue has gone on too long.
+
+//Hand as much of the queue to the SoftDevice as it will take. Must be called from within a critical region or from the SoftDevice event handler.
+//A slot is retired once its data 1 indication (if any) is confirmed and its data 2 notification (if any) has been buffered.
+//If the SoftDevice is out of buffers, we stop here and pick up again on the next TX complete or indication confirmation event.
+//If there is no one to send to (no connection, indications disabled), the slot is dropped, which is what the blocking version of this code did too.
+static void report_queue_service(ble_rfidrs_t * p_rfidrs)
+{
+    rfidr_report_t    *p_report       =    NULL;
+    uint32_t          error_code      =    NRF_SUCCESS;
+
+    while(m_report_tail != m_report_head)
+    {
+        p_report=&m_report_queue[m_report_tail];
+
+        if(!p_report->has_pckt_data1)
+        {
+            m_report_data1_sent=true;
+            m_report_data1_confirmed=true;
+        }
+        else if(!m_report_data1_sent)
+        {
+            error_code=ble_rfidrs_pckt_data1_send(p_rfidrs, p_report->pckt_data1, BLE_RFIDRS_PCKT_DATA1_CHAR_LEN);
+            if(error_code == BLE_ERROR_NO_TX_BUFFERS || error_code == NRF_ERROR_BUSY){return;}
+            m_report_data1_sent=true;
+            m_report_data1_confirmed=(error_code != NRF_SUCCESS);    //No confirmation is coming for an indication that was never sent.
+        }
+
+        if(p_report->has_pckt_data2 && !m_report_data2_sent)
+        {
+            error_code=ble_rfidrs_pckt_data2_send(p_rfidrs, p_report->pckt_data2, BLE_RFIDRS_PCKT_DATA2_CHAR_LEN);
+            if(error_code == BLE_ERROR_NO_TX_BUFFERS){return;}
+            m_report_data2_sent=true;
+        }
+
+        if(!m_report_data1_confirmed){return;}
+
+        m_report_data1_sent         =    false;
+        m_report_data2_sent         =    false;
+        m_report_data1_confirmed    =    false;
+        m_report_tail               =    (m_report_tail+1) & REPORT_QUEUE_MASK;
+    }
+}
+
+//Called from the SoftDevice event handler when the iDevice acknowledges a data 1 indication.
+void rfidr_report_queue_on_data1_confirmation(ble_rfidrs_t * p_rfidrs)
+{
+    m_report_data1_confirmed=true;
+    report_queue_service(p_rfidrs);
+}
+
+//Called from the SoftDevice event handler when BTLE TX buffers free up.
+void rfidr_report_queue_on_tx_complete(ble_rfidrs_t * p_rfidrs)
+{
+    report_queue_service(p_rfidrs);
+}
+
+//Called from the SoftDevice event handler on disconnect. Nothing in flight will ever be acknowledged, so drop everything.
+void rfidr_report_queue_reset(void)
+{
+    m_report_data1_sent         =    false;
+    m_report_data2_sent         =    false;
+    m_report_data1_confirmed    =    false;
+    m_report_tail               =    m_report_head;
+}
+
+static void report_wait_timeout_handler(void * p_context)
+{
+    m_report_wait_expired    =    true;
+}
+
+//Called once from main after APP_TIMER_INIT.
+void rfidr_report_queue_init(void)
+{
+    uint32_t    error_code    =    NRF_SUCCESS;
+
+    error_code    =    app_timer_create(&m_report_wait_timer_id, APP_TIMER_MODE_SINGLE_SHOT, report_wait_timeout_handler);
+    APP_ERROR_CHECK(error_code);
+}
+
+static uint8_t report_queue_used(void)
+{
+    return (uint8_t)((m_report_head-m_report_tail) & REPORT_QUEUE_MASK);
+}
+
+//Sleep until no more than max_used slots are waiting to go out, or until REPORT_WAIT_TIMEOUT_TICKS have gone by.
+//Slots are freed by the SoftDevice event handler, and each BTLE event or the timeout wakes us up from sd_app_evt_wait to look again.
+//Only to be called from the main loop (thread mode), so that the SoftDevice and app_timer interrupts can get in.
+//returns true if the queue drained far enough in time
+static bool report_queue_wait(uint8_t max_used)
+{
+    uint32_t    error_code    =    NRF_SUCCESS;
+
+    if(report_queue_used() <= max_used){return true;}
+
+    m_report_wait_expired    =    false;
+    error_code               =    app_timer_start(m_report_wait_timer_id, REPORT_WAIT_TIMEOUT_TICKS, NULL);
+    APP_ERROR_CHECK(error_code);
+
+    while(report_queue_used() > max_used && !m_report_wait_expired)
+    {
+        error_code    =    sd_app_evt_wait();
+        APP_ERROR_CHECK(error_code);
+    }
+
+    error_code    =    app_timer_stop(m_report_wait_timer_id);
+    APP_ERROR_CHECK(error_code);
+
+    return report_queue_used() <= max_used;
+}
+
+//Wait for a free slot (this is the only place the RF loop ever blocks on BTLE), clear it and hand it to the caller to fill in.
+//returns NULL if the iDevice has not freed up a slot within the timeout
+static rfidr_report_t * report_queue_claim(void)
+{
+    if(!report_queue_wait(REPORT_QUEUE_DEPTH-2)){return NULL;}
+    memset(&m_report_queue[m_report_head],0,sizeof(rfidr_report_t));
+    return &m_report_queue[m_report_head];
+}
+
+//Publish the slot returned by report_queue_claim, then kick the queue in case it was idle.
+//If it wasn't, the SoftDevice event handler will get to this slot on its own.
+static void report_queue_publish(ble_rfidrs_t * p_rfidrs)
+{
+    m_report_head=(m_report_head+1) & REPORT_QUEUE_MASK;
+    CRITICAL_REGION_ENTER();
+    report_queue_service(p_rfidrs);
+    CRITICAL_REGION_EXIT();
+}
+
+//Block until every queued report has been acknowledged or dropped.
+//This has to happen before anything else is indicated to the iDevice, since only one indication may be outstanding at a time.
+//If the iDevice stops acknowledging, whatever is left is dropped after the timeout so that the caller is not held up for good.
+rfidr_error_t rfidr_report_queue_flush(void)
+{
+    if(report_queue_wait(0)){return RFIDR_SUCCESS;}
+
+    CRITICAL_REGION_ENTER();
+    rfidr_report_queue_reset();
+    CRITICAL_REGION_EXIT();
+
+    return RFIDR_ERROR_BLE_REPORT_TIMEOUT;
+}
+
 //This function writes the first byte of every RX RAM memory space so that the RX Data Recovery state machine knows how many bits to look for in the tag reply.
 rfidr_error_t load_rfidr_rxram_default(void)
 {
@@ -120,12 +306,11 @@ rfidr_error_t load_rfidr_rxram_default(void)
 //It's best to have one do-it-all function for both, but this function needs to support rapid-read situations in which phase calibration data is not sent over to the iDevice
 rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, rfidr_return_t * search_return_cal, uint8_t frequency_slot, uint8_t num_failed_runs, uint8_t hopskip_nonce, rfidr_ble_push_t ble_push)
 {
-    static    uint8_t    data_id                                       =    0;          //This is just a nonce variable counting how many times we have sent packets to the iDevice using this function.
     uint8_t              choose_i_cal                                  =    255;        //255 means both I and Q failed. "0" means send Q data, "1" means send I data.
     uint8_t              choose_i_ant                                  =    255;          //255 means both I and Q failed. "0" means send Q data, "1" means send I data.
-    uint8_t              pckt_data1[BLE_RFIDRS_PCKT_DATA1_CHAR_LEN]    =    {0};        //Send back information listed below (only 20 bytes available).
-    uint8_t              pckt_data2[BLE_RFIDRS_PCKT_DATA2_CHAR_LEN]    =    {0};        //Send back information listed below (only 20 bytes available).
-    uint32_t             error_code                                    =    NRF_SUCCESS;
+    rfidr_report_t       *p_report                                     =    NULL;
+    uint8_t              *pckt_data1                                   =    NULL;       //Send back information listed below (only 20 bytes available).
+    uint8_t              *pckt_data2                                   =    NULL;       //Send back information listed below (only 20 bytes available).
     uint8_t              loop_bytes                                    =    0;
 
     //As of 112519, we no longer send the error code out routinely with this function call
@@ -154,25 +339,17 @@ rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t *
     //num_failed_runs does two things. If this value is 255, it means it is a first search run that passed.
     //If this value is less than 255, it means that we are on a secondary run and the value is the number of failed runs that occurred to get to a final acceptable one.
 
-    //Decide which cal magnitude we want to send. We want to pick one that's passed. If both passed, we want to pick the one with larger "main" value.
-    if(search_return_cal->i_pass && search_return_cal->q_pass)
-        choose_i_cal=(search_return_cal->i_main_mag) > (search_return_cal->q_main_mag);
-    else if(search_return_cal->i_pass && !search_return_cal->q_pass) 
-        choose_i_cal=1;
-    else if(!search_return_cal->i_pass && search_return_cal->q_pass) 
-        choose_i_cal=0;
-    else 
-        choose_i_cal=255; //We shouldn't be here, but this signifies a failure
-    
-    //Decide which ant magnitude we want to send. We want to pick one that's passed. If both passed, we want to pick the one with larger "main" value.
-    if(search_return_ant->i_pass && search_return_ant->q_pass)
-        choose_i_ant=(search_return_ant->i_main_mag) > (search_return_ant->q_main_mag);
-    else if(search_return_ant->i_pass && !search_return_ant->q_pass) 
-        choose_i_ant=1;
-    else if(!search_return_ant->i_pass && search_return_ant->q_pass) 
-        choose_i_ant=0;
-    else
-        choose_i_ant=255; //We shouldn't be here, but this signifies a failure
+    //Reports are built directly in the next free queue slot. Only if the iDevice has fallen a whole queue behind do we wait here.
+    p_report=report_queue_claim();
+    if(p_report == NULL){return RFIDR_ERROR_BLE_REPORT_TIMEOUT;}
+    p_report->has_pckt_data1=true;
+    pckt_data1=p_report->pckt_data1;
+    pckt_data2=p_report->pckt_data2;
+
+    //Decide which cal and ant magnitudes we want to send. We want to pick one that's passed. If both passed, we want to pick the one with larger "main" value.
+    //255 (RFIDR_RSSI_CHOOSE_NONE) means neither passed. We shouldn't be here, but this signifies a failure.
+    choose_i_cal=rfidr_rssi_choose_i(search_return_cal);
+    choose_i_ant=rfidr_rssi_choose_i(search_return_ant);
 
     //Load EPC bytes into pckt_data1
     for(loop_bytes=0;loop_bytes < MAX_EPC_LENGTH_IN_BYTES;loop_bytes++)
@@ -210,21 +387,10 @@ rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t *
         }
     }
     //Send the data ID for data tracking purposes on the iDevice.
-    pckt_data1[MAX_EPC_LENGTH_IN_BYTES+7]= data_id;
+    pckt_data1[MAX_EPC_LENGTH_IN_BYTES+7]= m_report_data_id;
     
-    //Send first packet back to the iDevice over BTLE. Keep trying to send the packet if the FIFO buffer for BTLE packets is full.
-    do
-    {
-        error_code=ble_rfidrs_pckt_data1_send(p_rfidrs, pckt_data1, BLE_RFIDRS_PCKT_DATA1_CHAR_LEN);
-    } while(error_code == BLE_ERROR_NO_TX_BUFFERS);
-
-    if (error_code != NRF_ERROR_INVALID_STATE)
-    {
-        APP_ERROR_CHECK(error_code);
-    }
-
     //Increment the data ID nonce variable.
-    data_id++;
+    m_report_data_id++;
 
     if(ble_push==BLE_PUSH_SUPPLEMENT) //Send the second packet as part of sending data over BLE.
     {
@@ -235,7 +401,7 @@ rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t *
         pckt_data2[12]=num_failed_runs; //Yes this is sort of repeated. Oh well.
         pckt_data2[13]= (search_return_cal->i_pass << 3) | (search_return_cal->q_pass << 2) | (search_return_ant->i_pass << 1) | (search_return_ant->q_pass << 0);
         pckt_data2[14]=hopskip_nonce;
-        pckt_data2[15]=data_id;
+        pckt_data2[15]=m_report_data_id;
     
         //Send the appropriate magnitude data over to the iDevice
     
@@ -276,26 +442,181 @@ rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t *
             }
         }
         
-        //Send second packet back to the iDevice over BTLE. Keep trying to send the packet if the FIFO buffer for BTLE packets is full.
-        do
-        {
-            error_code=ble_rfidrs_pckt_data2_send(p_rfidrs, pckt_data2, BLE_RFIDRS_PCKT_DATA2_CHAR_LEN);
-        } while(error_code == BLE_ERROR_NO_TX_BUFFERS);
+        p_report->has_pckt_data2=true;
 
-        if (error_code != NRF_ERROR_INVALID_STATE)
-        {
-            APP_ERROR_CHECK(error_code);
-        }
-        
         //Increment the data ID nonce variable.
-        data_id++;
+        m_report_data_id++;
     }
+
+    report_queue_publish(p_rfidrs);
     
     
 
     return RFIDR_SUCCESS;
 }
 
+//Packed report format, used during inventory when the iDevice opts in with BLE_RFIDRS_WRTE_STATE_PACKED_REPORTS.
+//Each packet data 1 indication carries as many tag records as fit, instead of one tag per indication.
+//Tags are referred to by an index into a dictionary of EPCs that the iDevice has already been sent; the full EPC only goes out on first sighting.
+//We keep the full EPC of each entry so that two tags can never share an index; a 32-bit hash alone would silently merge two tags on a collision.
+//The dictionary is kept small to pay for this in RAM. Once it is full, entries are replaced round-robin and the iDevice is sent the full EPC again.
+//The iDevice must clear its dictionary whenever an inventory starts.
+
+//Packet 1 (packed):
+//Byte  0:        Frequency Slot
+//Byte  1:        Data ID
+//Bytes 2-19:     Tag records, back to back, terminated by PACKED_RECORD_END if the packet is not full.
+//Known tag record (4 bytes):    {0, 0, Index (6b)}, RSSI (2 bytes, MSB first), Phase (1 byte)
+//New tag record (16 bytes):     {1, 0, Index (6b)}, EPC (12 bytes), RSSI (2 bytes, MSB first), Phase (1 byte)
+//The iDevice stores the EPC of a new tag record at the given index, overwriting whatever was there.
+//RSSI and phase are those of the chosen I or Q run (see rfidr_rssi.c): RSSI in dB as unsigned Q8.8, phase with 256 to a full circle.
+
+#define    PACKED_HEADER_LENGTH         2
+#define    PACKED_RECORD_KNOWN_LENGTH   4
+#define    PACKED_RECORD_NEW_LENGTH     (PACKED_RECORD_KNOWN_LENGTH+MAX_EPC_LENGTH_IN_BYTES)
+#define    PACKED_RECORD_NEW_FLAG       0x80
+#define    PACKED_RECORD_END            0xFF      //Cannot be mistaken for a record header since the index is only 6b.
+#define    PACKED_DICT_SIZE             24        //Must fit in the 6b index. Costs MAX_EPC_LENGTH_IN_BYTES of RAM per entry.
+
+static uint8_t     m_packed_dict_epc[PACKED_DICT_SIZE][MAX_EPC_LENGTH_IN_BYTES];
+static uint8_t     m_packed_dict_count                                    =    0;        //Entries in use.
+static uint8_t     m_packed_dict_next_evict                               =    0;        //Once the dictionary is full, entries are replaced round-robin.
+static uint8_t     m_packed_pckt[BLE_RFIDRS_PCKT_DATA1_CHAR_LEN];                        //The packet being filled in.
+static uint8_t     m_packed_pckt_length                                   =    0;        //0 means no packet is being filled in.
+
+//Hand the packet being filled in to the report queue.
+//The packet is dropped if the queue stays full, since the records in it refer to a frequency slot that is already over.
+static rfidr_error_t packed_emit(ble_rfidrs_t * p_rfidrs)
+{
+    rfidr_report_t    *p_report    =    NULL;
+
+    if(m_packed_pckt_length == 0){return RFIDR_SUCCESS;}
+
+    if(m_packed_pckt_length < BLE_RFIDRS_PCKT_DATA1_CHAR_LEN)
+        m_packed_pckt[m_packed_pckt_length]=PACKED_RECORD_END;
+
+    p_report=report_queue_claim();
+    m_packed_pckt_length=0;
+    if(p_report == NULL){return RFIDR_ERROR_BLE_REPORT_TIMEOUT;}
+
+    p_report->has_pckt_data1=true;
+    memcpy(p_report->pckt_data1,m_packed_pckt,BLE_RFIDRS_PCKT_DATA1_CHAR_LEN);
+    report_queue_publish(p_rfidrs);
+
+    return RFIDR_SUCCESS;
+}
+
+//Forget every EPC the iDevice has been sent and drop any partly filled packet.
+void rfidr_packed_report_reset(void)
+{
+    m_packed_dict_count         =    0;
+    m_packed_dict_next_evict    =    0;
+    m_packed_pckt_length        =    0;
+}
+
+//Send the partly filled packet, if any.
+rfidr_error_t rfidr_packed_report_flush(ble_rfidrs_t * p_rfidrs)
+{
+    return packed_emit(p_rfidrs);
+}
+
+//Add one tag to the packed report. The packet is only sent once it is full, the frequency slot changes, or rfidr_packed_report_flush is called.
+rfidr_error_t rfidr_push_packed_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, uint8_t frequency_slot)
+{
+    const uint8_t    *epc            =    NULL;
+    uint8_t          dict_index      =    0;
+    uint8_t          record_length   =    PACKED_RECORD_KNOWN_LENGTH;
+    rfidr_rssi_t     rssi;
+    rfidr_error_t    error_code      =    RFIDR_SUCCESS;
+
+    error_code=rfidr_rssi_from_return(search_return_ant,&rssi);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    epc=(rssi.choose_i == RFIDR_RSSI_CHOOSE_I) ? search_return_ant->i_epc : search_return_ant->q_epc;
+
+    //Look the tag up in the dictionary, adding it if the iDevice hasn't been sent it yet.
+    for(dict_index=0;dict_index < m_packed_dict_count;dict_index++)
+    {
+        if(memcmp(m_packed_dict_epc[dict_index],epc,MAX_EPC_LENGTH_IN_BYTES) == 0){break;}
+    }
+
+    if(dict_index == m_packed_dict_count)
+    {
+        if(m_packed_dict_count < PACKED_DICT_SIZE)
+        {
+            m_packed_dict_count++;
+        }
+        else
+        {
+            dict_index=m_packed_dict_next_evict;
+            m_packed_dict_next_evict=(m_packed_dict_next_evict+1) % PACKED_DICT_SIZE;
+        }
+        memcpy(m_packed_dict_epc[dict_index],epc,MAX_EPC_LENGTH_IN_BYTES);
+        record_length=PACKED_RECORD_NEW_LENGTH;
+    }
+
+    //Records never straddle packets, and all records in a packet share one frequency slot.
+    if(m_packed_pckt_length != 0 && (m_packed_pckt_length+record_length > BLE_RFIDRS_PCKT_DATA1_CHAR_LEN || m_packed_pckt[0] != frequency_slot))
+    {
+        error_code=packed_emit(p_rfidrs);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+    }
+
+    if(m_packed_pckt_length == 0)
+    {
+        m_packed_pckt[0]=frequency_slot;
+        m_packed_pckt[1]=m_report_data_id++;
+        m_packed_pckt_length=PACKED_HEADER_LENGTH;
+    }
+
+    if(record_length == PACKED_RECORD_NEW_LENGTH)
+    {
+        m_packed_pckt[m_packed_pckt_length++]=dict_index | PACKED_RECORD_NEW_FLAG;
+        memcpy(&m_packed_pckt[m_packed_pckt_length],epc,MAX_EPC_LENGTH_IN_BYTES);
+        m_packed_pckt_length+=MAX_EPC_LENGTH_IN_BYTES;
+    }
+    else
+    {
+        m_packed_pckt[m_packed_pckt_length++]=dict_index;
+    }
+    m_packed_pckt[m_packed_pckt_length++]=(uint8_t)(rssi.rssi >> 8);
+    m_packed_pckt[m_packed_pckt_length++]=(uint8_t)(rssi.rssi & 255);
+    m_packed_pckt[m_packed_pckt_length++]=(uint8_t)(rssi.phase >> 8);
+
+    if(m_packed_pckt_length == BLE_RFIDRS_PCKT_DATA1_CHAR_LEN)
+        return packed_emit(p_rfidrs);
+
+    return RFIDR_SUCCESS;
+}
+
+//Range report, used during tracking when the iDevice opts in with BLE_RFIDRS_WRTE_STATE_RANGE_REPORTS.
+//The reader pairs up the hop and skip reads of each tag itself (see rfidr_pdoa.c) and sends one packet data 2 notification per pair, with no packet data 1.
+//Packet 2 (range):
+//Bytes 0-11:     EPC
+//Bytes 12-13:    Range in cm, MSB first
+//Byte  14:       Confidence, 0 to 255
+//Byte  15:       Data ID
+
+rfidr_error_t rfidr_push_range_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, uint16_t range, uint8_t confidence)
+{
+    rfidr_report_t    *p_report       =    NULL;
+    uint8_t           choose_i_ant    =    rfidr_rssi_choose_i(search_return_ant);
+
+    if(choose_i_ant == RFIDR_RSSI_CHOOSE_NONE){return RFIDR_ERROR_GENERAL;}
+
+    p_report=report_queue_claim();
+    if(p_report == NULL){return RFIDR_ERROR_BLE_REPORT_TIMEOUT;}
+    p_report->has_pckt_data2=true;
+    memcpy(p_report->pckt_data2,(choose_i_ant == RFIDR_RSSI_CHOOSE_I) ? search_return_ant->i_epc : search_return_ant->q_epc,MAX_EPC_LENGTH_IN_BYTES);
+    p_report->pckt_data2[12]=(uint8_t)(range >> 8);
+    p_report->pckt_data2[13]=(uint8_t)(range & 255);
+    p_report->pckt_data2[14]=confidence;
+    p_report->pckt_data2[15]=m_report_data_id++;
+    report_queue_publish(p_rfidrs);
+
+    return RFIDR_SUCCESS;
+}
+
 //051519 - This code was added in late 2017 to add some robustness to the programming operation,
 //by allowing a readback of the EPC value that was just programmed to the tag.
 //This code was copied over from another function and should be revised at some point, for example it does not require a ble_rfidrs_t argument
@@ -304,7 +625,7 @@ rfidr_error_t rfidr_pull_and_check_read_data(rfidr_target_epc_t target)
 {
     uint16_t    radio_sram_addr                                 =    (RX_RAM_ADDR_OFFSET_READ << 4);    //Read from the "READ" section of RX RAM - after a read command is issued.
     uint8_t     loop_bytes                                      =    0;                                 //A loop variable.
-    uint8_t     recovery_byte                                   =    0;                                 //A storage byte that we use to recover data from memory.
+    uint8_t     recovery_bytes[RX_BYTES_READ]                   =    {0};                               //Storage bytes that we use to recover data from memory (1 header bit + EPC + RN + CRC).
     uint8_t     recovered_epc_bytes[MAX_EPC_LENGTH_IN_BYTES]    =    {0};                               //The EPC data read back from the tag.
     uint8_t     original_epc_bytes[MAX_EPC_LENGTH_IN_BYTES]     =    {0};                               //The EPC data that was intended to be programmed onto the tag.
     uint64_t    recovered_epc_bits_msb                          =    0;                                 //The most significant 64 bits (8 bytes) of the EPC data recovered from the tag.
@@ -315,45 +636,34 @@ rfidr_error_t rfidr_pull_and_check_read_data(rfidr_target_epc_t target)
     //data. So the bytes that we pull out have to be re-formed.
 
     radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_READ << 4)+1;    //We require an offset of 1 to start the memory read after the byte containing the #bits to expect in the tag reply.
-    spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr++, 0);
-    spi_cntrlr_send_recv();
-    spi_cntrlr_read_rx(&recovery_byte);
+    //Pull the whole reply (header bit, 96 EPC bits, handle and CRC-16) out of RX RAM in one burst, then re-form the EPC below.
+    //The CRC-16 of a read reply covers the header bit, the data and the handle, so a corrupt reply is rejected before we even look at the EPC.
+    spi_cntrlr_read_burst(RFIDR_RDIO_MEM, RFIDR_SPI_RXRAM, radio_sram_addr, RX_BYTES_READ, recovery_bytes);
+    if(!rfidr_crc16_check(recovery_bytes,RX_BITS_READ)){return RFIDR_ERROR_EPC_CRC;}
 
     //Get the first 7 bits and start assembling the EPC
-    recovered_epc_bits_msb |= (uint64_t)(recovery_byte & 127) << 57;
+    recovered_epc_bits_msb |= (uint64_t)(recovery_bytes[0] & 127) << 57;
 
     //Get the next 56 bits (7 bytes) and continue assembling the EPC
     for(loop_bytes=0;loop_bytes < 7;loop_bytes++)
     {
-        spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr++, 0);
-        spi_cntrlr_send_recv();
-        spi_cntrlr_read_rx(&recovery_byte);
-        recovered_epc_bits_msb |= (uint64_t)(recovery_byte & 255) << (49-(loop_bytes<<3));
+        recovered_epc_bits_msb |= (uint64_t)(recovery_bytes[1+loop_bytes] & 255) << (49-(loop_bytes<<3));
     }
 
     //Get the final bit to be included in the 64 most significant bits.
-    spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr++, 0);
-    spi_cntrlr_send_recv();
-    spi_cntrlr_read_rx(&recovery_byte);
-    recovered_epc_bits_msb |= (uint64_t)(recovery_byte >> 7) & 1;
+    recovered_epc_bits_msb |= (uint64_t)(recovery_bytes[8] >> 7) & 1;
 
     //And get the MSB of the 32 LSB and continue assembling the EPC.
-    recovered_epc_bits_lsb |= (uint32_t)(recovery_byte & 127) << 25;
+    recovered_epc_bits_lsb |= (uint32_t)(recovery_bytes[8] & 127) << 25;
 
     //Get the next 24 bits of the LSB continue assembling the EPC.
     for(loop_bytes=0;loop_bytes < 3;loop_bytes++)
     {
-        spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr++, 0);
-        spi_cntrlr_send_recv();
-        spi_cntrlr_read_rx(&recovery_byte);
-        recovered_epc_bits_lsb |= (uint32_t)(recovery_byte & 255) << (17-(loop_bytes<<3));
+        recovered_epc_bits_lsb |= (uint32_t)(recovery_bytes[9+loop_bytes] & 255) << (17-(loop_bytes<<3));
     }
 
     //Get the final bit to be included in the 32-bit LSB and finish assembling the EPC.
-    spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr++, 0);
-    spi_cntrlr_send_recv();
-    spi_cntrlr_read_rx(&recovery_byte);
-    recovered_epc_bits_lsb |= (uint32_t)(recovery_byte >> 7) & 1;
+    recovered_epc_bits_lsb |= (uint32_t)(recovery_bytes[12] >> 7) & 1;
 
     //Build the bytes up in an array - msb
     for(loop_bytes=0;loop_bytes < 8;loop_bytes++)
@@ -385,21 +695,15 @@ rfidr_error_t rfidr_pull_and_check_read_data(rfidr_target_epc_t target)
 
 rfidr_error_t rfidr_read_main_magnitude(int32_t * main_magnitude, rfidr_read_rxram_type_t read_type)
 {
-    uint16_t        radio_sram_addr     =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+2; //The address of the main path magnitude in RX RAM when PCEPC data is received.
-    uint8_t         loop_bytes          =    0;    //Note - the offset of 2 above is only in the case of initialization - this won't need to change with a dummy
-    uint8_t         recovery_byte[4]    =    {0};    //tag provided that we address it with the wrong address during initialization (we do - we use 0 EPC).
+    uint16_t        radio_sram_addr     =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+RX_PCEPC_OFFSET_MAIN_MAG; //The address of the main path magnitude in RX RAM when PCEPC data is received.
+    uint8_t         recovery_byte[4]    =    {0};
 
     //Get Main magnitude bits
     //Data was loaded into FPGA RX RADIO RAM as MagMain[LSByte] MagMain[LSByte-1] MagMain[MSByte-1] MagMain[MSByte] MagAlt[LSByte] MagAlt[LSByte-1] MagAlt[MSByte-1] MagAlt[MSByte]
     *main_magnitude = 0;
-    for(loop_bytes=0;loop_bytes < 4;loop_bytes++)
-    {
-        //radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+2+loop_bytes+(read_type==READ_RXRAM_REGULAR ? 16 : 0); //Note this offset of 2 is only for the case of initialization where there are no CRC bits
-        radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+18+loop_bytes;
-        spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr, 0);
-        spi_cntrlr_send_recv();
-        spi_cntrlr_read_rx(&recovery_byte[loop_bytes]);
-    }
+    //radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+2+(read_type==READ_RXRAM_REGULAR ? 16 : 0); //Note this offset of 2 is only for the case of initialization where there are no CRC bits
+    //The four magnitude bytes are contiguous, so they are pulled out in a single burst.
+    spi_cntrlr_read_burst(RFIDR_RDIO_MEM, RFIDR_SPI_RXRAM, radio_sram_addr, 4, recovery_byte);
 
     *main_magnitude = (int32_t)(((uint32_t)recovery_byte[0] << 0)+((uint32_t)recovery_byte[1] << 8)+((uint32_t)recovery_byte[2] << 16)+((uint32_t)recovery_byte[3] << 24));
 
@@ -408,48 +712,89 @@ rfidr_error_t rfidr_read_main_magnitude(int32_t * main_magnitude, rfidr_read_rxr
 
 rfidr_error_t rfidr_read_alt_magnitude(int32_t * alt_magnitude, rfidr_read_rxram_type_t read_type)
 {
-    uint16_t        radio_sram_addr     =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+6; //The address of the alt path magnitude in RX RAM when PCEPC data is received.
-    uint8_t         loop_bytes          =    0; //Note - the offset of 6 above is only in the case of initialization - this won't need to change with a dummy
-    uint8_t         recovery_byte[4]    =    {0}; //tag provided that we address it with the wrong address during initialization (we do - we use 0 EPC).
+    uint16_t        radio_sram_addr     =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+RX_PCEPC_OFFSET_ALT_MAG; //The address of the alt path magnitude in RX RAM when PCEPC data is received.
+    uint8_t         recovery_byte[4]    =    {0};
 
     //Get Alt magnitude bits
     //Data was loaded into FPGA RX RADIO RAM as MagMain[LSByte] MagMain[LSByte-1] MagMain[MSByte-1] MagMain[MSByte] MagAlt[LSByte] MagAlt[LSByte-1] MagAlt[MSByte-1] MagAlt[MSByte]
     *alt_magnitude=0;
-    for(loop_bytes=0;loop_bytes < 4;loop_bytes++)
-    {
-        //radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+6+loop_bytes+(read_type==READ_RXRAM_REGULAR ? 16 : 0); //Note this offset of 6 is only for the case of initialization where there are no CRC bits
-        radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+22+loop_bytes;
-        spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr, 0);
-        spi_cntrlr_send_recv();
-        spi_cntrlr_read_rx(&recovery_byte[loop_bytes]);
-    }
+    //radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+6+(read_type==READ_RXRAM_REGULAR ? 16 : 0); //Note this offset of 6 is only for the case of initialization where there are no CRC bits
+    //The four magnitude bytes are contiguous, so they are pulled out in a single burst.
+    spi_cntrlr_read_burst(RFIDR_RDIO_MEM, RFIDR_SPI_RXRAM, radio_sram_addr, 4, recovery_byte);
 
     *alt_magnitude = (int32_t)(((uint32_t)recovery_byte[0] << 0)+((uint32_t)recovery_byte[1] << 8)+((uint32_t)recovery_byte[2] << 16)+((uint32_t)recovery_byte[3] << 24));
 
     return RFIDR_SUCCESS;
 }
 
+//Check the CRC-16 of a PC+EPC+CRC reply as it sits in RX RAM.
+//The 5 MSBs of the PC hold the length of the PC+EPC in words, not counting the PC itself (Sec 6.3.2.1.2.2 of the spec).
+//A tag with a shorter EPC puts its CRC-16 earlier in the reply, so check up to wherever it actually is.
+//If the tag claims a longer EPC than we captured, the CRC-16 is not in RX RAM and the reply cannot be checked, so let it through.
+static bool rfidr_check_pcepc_crc(const uint8_t * p_pcepc_bytes)
+{
+    if((p_pcepc_bytes[0] >> 3) > (MAX_EPC_LENGTH_IN_BYTES >> 1)){return true;}
+
+    return rfidr_crc16_check(p_pcepc_bytes,(uint16_t)(((p_pcepc_bytes[0] >> 3) << 4)+32));
+}
+
 rfidr_error_t rfidr_read_epc(uint8_t * epc, rfidr_read_rxram_type_t read_type)
 {
-    uint16_t         radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+3;
-    uint8_t          loop_bytes         =    0;
-    uint8_t          recovery_byte      =    0;
-    rfidr_error_t    error_code         =    RFIDR_SUCCESS;
+    uint16_t         radio_sram_addr                =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+RX_PCEPC_OFFSET_DATA;
+    uint8_t          pcepc_bytes[RX_BYTES_PCEPC]    =    {0};
+    rfidr_error_t    error_code                     =    RFIDR_SUCCESS;
     
-    //Get EPC bits, ignoring PC and CRC bits, from RX RAM and load them into the buffer for containing the first BTLE packet back to the iDevice.
-    for(loop_bytes=0;loop_bytes < MAX_EPC_LENGTH_IN_BYTES;loop_bytes++)
+    //Get PC, EPC and CRC bits from RX RAM, then load the EPC bits into the buffer for containing the first BTLE packet back to the iDevice.
+    //The PC, EPC and CRC bytes are contiguous in RX RAM, so they are pulled out in a single burst.
+    if(read_type==READ_RXRAM_REGULAR)
     {
-        if(read_type==READ_RXRAM_REGULAR)
-        {
-            radio_sram_addr    =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+3+loop_bytes;
-            spi_cntrlr_set_tx(RFIDR_RDIO_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, radio_sram_addr, 0);
-            spi_cntrlr_send_recv();
-            spi_cntrlr_read_rx(&recovery_byte);
-            *(epc+loop_bytes)=recovery_byte;
-        }
-        else
-            *(epc+loop_bytes)=0x00;    
+        error_code=spi_cntrlr_read_burst(RFIDR_RDIO_MEM, RFIDR_SPI_RXRAM, radio_sram_addr, RX_BYTES_PCEPC, pcepc_bytes);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+
+        memcpy(epc, &pcepc_bytes[2], MAX_EPC_LENGTH_IN_BYTES);
+
+        if(!rfidr_check_pcepc_crc(pcepc_bytes)){return RFIDR_ERROR_EPC_CRC;}
     }
+    else
+        memset(epc, 0, MAX_EPC_LENGTH_IN_BYTES);
     
     return error_code;
 }
+
+//Pull the whole tag record out of the PCEPC section of RX RAM. This is the per-tag hot path during inventory and tracking:
+//the PC+EPC+CRC, exit code and both magnitudes are contiguous, so one burst replaces separate EPC and magnitude reads.
+//For a PLL check there is no real tag reply, so the EPC is zeroed and no CRC check is made, just as with rfidr_read_epc.
+rfidr_error_t rfidr_read_tag_record(rfidr_tag_record_t * p_record, rfidr_read_rxram_type_t read_type)
+{
+    uint16_t         radio_sram_addr                        =    (RX_RAM_ADDR_OFFSET_PCEPC << 4)+RX_PCEPC_OFFSET_DATA;
+    uint8_t          record_bytes[RX_PCEPC_RECORD_LENGTH]   =    {0};
+    const uint8_t *  p_mag                                  =    NULL;
+    rfidr_error_t    error_code                             =    RFIDR_SUCCESS;
+
+    error_code=spi_cntrlr_read_burst(RFIDR_RDIO_MEM, RFIDR_SPI_RXRAM, radio_sram_addr, RX_PCEPC_RECORD_LENGTH, record_bytes);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    //The magnitudes were loaded into FPGA RX RADIO RAM LSByte first.
+    p_mag                  =    &record_bytes[RX_PCEPC_OFFSET_MAIN_MAG-RX_PCEPC_OFFSET_DATA];
+    p_record->main_mag     =    (int32_t)(((uint32_t)p_mag[0] << 0)+((uint32_t)p_mag[1] << 8)+((uint32_t)p_mag[2] << 16)+((uint32_t)p_mag[3] << 24));
+    p_mag                  =    &record_bytes[RX_PCEPC_OFFSET_ALT_MAG-RX_PCEPC_OFFSET_DATA];
+    p_record->alt_mag      =    (int32_t)(((uint32_t)p_mag[0] << 0)+((uint32_t)p_mag[1] << 8)+((uint32_t)p_mag[2] << 16)+((uint32_t)p_mag[3] << 24));
+    p_record->exit_code    =    record_bytes[RX_PCEPC_OFFSET_EXIT_CODE-RX_PCEPC_OFFSET_DATA];
+
+    //The PC and CRC go over the air MSB first.
+    p_record->pc           =    (uint16_t)((record_bytes[0] << 8) | record_bytes[1]);
+    p_record->crc          =    (uint16_t)((record_bytes[RX_BYTES_PCEPC-2] << 8) | record_bytes[RX_BYTES_PCEPC-1]);
+
+    if(read_type==READ_RXRAM_REGULAR)
+    {
+        memcpy(p_record->epc, &record_bytes[2], MAX_EPC_LENGTH_IN_BYTES);
+        p_record->crc_pass    =    rfidr_check_pcepc_crc(record_bytes);
+    }
+    else
+    {
+        memset(p_record->epc, 0, MAX_EPC_LENGTH_IN_BYTES);
+        p_record->crc_pass    =    true;
+    }
+
+    return p_record->crc_pass ? RFIDR_SUCCESS : RFIDR_ERROR_EPC_CRC;
+}
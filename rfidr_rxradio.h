@@ -53,6 +53,20 @@ typedef struct
     int32_t        q_alt_mag;
 } rfidr_return_t;
 
+//Everything the FPGA leaves in the PCEPC section of RX RAM for one singulated tag, decoded.
+//The fields are ordered so that the struct packs with no padding (26 bytes).
+
+typedef struct
+{
+    int32_t        main_mag;                            //Main integrator magnitude.
+    int32_t        alt_mag;                             //Alt integrator magnitude.
+    uint16_t       pc;                                  //Protocol control word sent ahead of the EPC.
+    uint16_t       crc;                                 //CRC-16 as received (the last 16 bits of the PC+EPC+CRC section).
+    uint8_t        epc[MAX_EPC_LENGTH_IN_BYTES];
+    uint8_t        exit_code;                           //Exit code of the FPGA data recovery state machine.
+    bool           crc_pass;                            //True if the CRC-16 checked out (or could not be checked, see rfidr_read_tag_record).
+} rfidr_tag_record_t;
+
 typedef enum
 {
     TARGET_APP_SPECD_EPC,
@@ -78,10 +92,54 @@ rfidr_error_t load_rfidr_rxram_default(void);
 
 //function for pushing data over bluetooth LE back to the phone
 //This will need to happen every time we get a PCEPC done IRQ event
+//The data is queued and sent from the SoftDevice event handler; this only blocks if the queue is full
 //returns RFIDR_SUCCESS on successful field set
 
 rfidr_error_t rfidr_push_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, rfidr_return_t * search_return_cal, uint8_t recover_frequency_slot, uint8_t num_failed_runs, uint8_t hopskip_nonce, rfidr_ble_push_t ble_push);
 
+//function for adding one tag to the packed multi-tag report (see rfidr_rxradio.c for the format)
+//The report is sent once a packet is full, when the frequency slot changes, or on rfidr_packed_report_flush
+//returns RFIDR_SUCCESS on successful field set
+
+rfidr_error_t rfidr_push_packed_data_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, uint8_t recover_frequency_slot);
+
+//function for sending the range of a tracked tag, as computed by rfidr_pdoa_compute_range, in a single notification (see rfidr_rxradio.c for the format)
+//returns RFIDR_SUCCESS on successful field set, or RFIDR_ERROR_GENERAL if neither run of the tag read passed
+
+rfidr_error_t rfidr_push_range_over_ble(ble_rfidrs_t * p_rfidrs, rfidr_return_t * search_return_ant, uint16_t range, uint8_t confidence);
+
+//function for sending the partly filled packed report, if any
+//returns RFIDR_SUCCESS on successful queueing, RFIDR_ERROR_BLE_REPORT_TIMEOUT if the report queue stayed full
+
+rfidr_error_t rfidr_packed_report_flush(ble_rfidrs_t * p_rfidrs);
+
+//function for clearing the dictionary of EPCs sent in packed reports, to be called whenever an inventory starts
+
+void rfidr_packed_report_reset(void);
+
+//function for setting up the report queue timeout timer, to be called once after APP_TIMER_INIT
+
+void rfidr_report_queue_init(void);
+
+//function for continuing to send queued tag reports once the iDevice acknowledges a packet data 1 indication
+//to be called from the SoftDevice event handler
+
+void rfidr_report_queue_on_data1_confirmation(ble_rfidrs_t * p_rfidrs);
+
+//function for continuing to send queued tag reports once the SoftDevice has freed up TX buffers
+//to be called from the SoftDevice event handler
+
+void rfidr_report_queue_on_tx_complete(ble_rfidrs_t * p_rfidrs);
+
+//function for dropping all queued tag reports, e.g. when the iDevice disconnects
+
+void rfidr_report_queue_reset(void);
+
+//function for waiting until all queued tag reports have been sent and acknowledged (or dropped)
+//returns RFIDR_SUCCESS once the queue is empty, RFIDR_ERROR_BLE_REPORT_TIMEOUT if the iDevice stopped acknowledging and the rest were dropped
+
+rfidr_error_t rfidr_report_queue_flush(void);
+
 //function for pulling read data back from the tag to compare with the epc we intended to write
 //returns RFIDR_SUCCESS on successful field set
 
@@ -102,4 +160,9 @@ rfidr_error_t rfidr_read_alt_magnitude(int32_t * alt_magnitude, rfidr_read_rxram
 
 rfidr_error_t rfidr_read_epc(uint8_t * epc, rfidr_read_rxram_type_t read_type);
 
+//function for pulling the PC, EPC, CRC, exit code and both magnitudes of the last singulated tag out of RX RAM in one SPI burst
+//returns RFIDR_SUCCESS on successful read, RFIDR_ERROR_EPC_CRC if the record was read but its CRC-16 did not check out
+
+rfidr_error_t rfidr_read_tag_record(rfidr_tag_record_t * p_record, rfidr_read_rxram_type_t read_type);
+
 #endif
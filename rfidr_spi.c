@@ -56,18 +56,47 @@
 //#include "nrf_drv_spi.h"
 #include "spi_cntrlr_fast.h"
 #include "nordic_common.h"
+#include "nrf_sdm.h"
+#include "nrf_soc.h"
 #include "rfidr_error.h"
 #include "rfidr_spi.h"
+#include <string.h>
 
  // Number of bytes to transmit and receive from the MCU SPI.
  // This amount of bytes will also be tested to see that the received bytes from peripheral are the same as the transmitted bytes from the cntrlr.
-#define TX_RX_MSG_LENGTH         4
+#define TX_RX_MSG_LENGTH         SPI_FRAME_LENGTH_IN_BYTES
 
 //#if (SPI0_ENABLED == 1)
 
 static uint8_t m_tx_data_spi[TX_RX_MSG_LENGTH]; // SPI cntrlr TX buffer state variable, required for interacting with the SPI peripheral.
 static uint8_t m_rx_data_spi[TX_RX_MSG_LENGTH]; // SPI cntrlr RX buffer state variable, required for interacting with the SPI peripheral.
 
+ // Maximum number of 4-byte frames streamed back to back in one burst.
+ // Longer bursts are broken up into chunks of this size so that the burst buffers stay small.
+#define SPI_BURST_MAX_FRAMES     32
+
+ // Bursts shorter than this are polled rather than driven by the SPI interrupt (see spi_cntrlr_burst_transfer).
+#define SPI_BURST_ASYNC_MIN_FRAMES    SPI_BURST_MAX_FRAMES
+
+static uint8_t m_tx_burst_spi[SPI_BURST_MAX_FRAMES*TX_RX_MSG_LENGTH]; // SPI cntrlr TX buffer for burst transfers.
+static uint8_t m_rx_burst_spi[SPI_BURST_MAX_FRAMES*TX_RX_MSG_LENGTH]; // SPI cntrlr RX buffer for burst transfers.
+static uint8_t m_chk_burst_spi[SPI_BURST_MAX_FRAMES];                  // Read back buffer used to verify robust burst writes.
+
+static volatile bool m_spi_burst_busy = false;            // Set while a burst is being clocked out by the SPI interrupt.
+
+ // Number of FPGA memories addressed over the SPI (one per spi_mem_t value).
+#define SPI_MEM_COUNT            4
+
+static uint16_t m_spi_retry_count[SPI_MEM_COUNT];         // Robust writes that had to be repeated because the read back did not match, per FPGA memory.
+static uint16_t m_spi_failure_count[SPI_MEM_COUNT];       // Robust writes that gave up and returned an error, per FPGA memory.
+static uint8_t  m_spi_frequency = SPI_FREQ_4MBPS;         // SPI clock in use, as an SPI_frequency_t. Set by spi_cntrlr_train_link.
+
+//Saturating add for the link counters, so that a bad link shows up as a pegged counter rather than one that wraps around.
+static void spi_cntrlr_count(uint16_t * p_count, uint16_t amount)
+{
+    *p_count    =    (*p_count > UINT16_MAX-amount) ? UINT16_MAX : (uint16_t)(*p_count+amount);
+}
+
 //Initialize the SPI. 
 uint32_t spi_cntrlr_init(void)
 {
@@ -77,7 +106,7 @@ uint32_t spi_cntrlr_init(void)
                                 .pin_COPI                = SPI0_CONFIG_COPI_PIN,
                                 .pin_CIPO                = SPI0_CONFIG_CIPO_PIN,
                                 .pin_CSN                 = SPI0_CONFIG_PS_PIN,
-                                .frequency               = SPI_FREQ_4MBPS,
+                                .frequency               = m_spi_frequency,
                                 .config.fields.mode      = 0,
                                 .config.fields.bit_order = SPI_BITORDER_MSB_LSB};
 
@@ -88,8 +117,49 @@ uint32_t spi_cntrlr_init(void)
     return NRF_SUCCESS;
 }
 
+//Called from the SPI interrupt once the last frame of a burst has been clocked out.
+static void spi_cntrlr_burst_done(void * p_context)
+{
+    m_spi_burst_busy    =    false;
+}
+
+//Stream num_frames frames from the burst buffers to the FPGA.
+//A frame is only 8us at 4MHz, less than the cost of taking an interrupt per byte, so short bursts such as a tag record (25 frames)
+//or a packet's worth of waveform RAM are polled. Only a full SPI_BURST_MAX_FRAMES chunk, which only long writes and reads produce,
+//is driven by the SPI interrupt while we sleep, and then only from thread mode: sd_app_evt_wait must not be called from an interrupt.
+static rfidr_error_t spi_cntrlr_burst_transfer(uint16_t num_frames)
+{
+    uint8_t    softdevice_enabled    =    0;
+
+    if(num_frames < SPI_BURST_ASYNC_MIN_FRAMES || __get_IPSR() != 0)
+    {
+        if(!spi_cntrlr_tx_rx_frames(SPI0, TX_RX_MSG_LENGTH, num_frames, m_tx_burst_spi, m_rx_burst_spi)){return RFIDR_ERROR_SPI_BURST;}
+        return RFIDR_SUCCESS;
+    }
+
+    //With the SoftDevice running, sleep through sd_app_evt_wait so that it can keep its own bookkeeping of the wake up.
+    m_spi_burst_busy    =    true;
+    if(!spi_cntrlr_tx_rx_frames_async(SPI0, TX_RX_MSG_LENGTH, num_frames, m_tx_burst_spi, m_rx_burst_spi, spi_cntrlr_burst_done, NULL))
+    {
+        m_spi_burst_busy    =    false;
+        return RFIDR_ERROR_SPI_BURST;
+    }
+
+    sd_softdevice_is_enabled(&softdevice_enabled);
+    while(m_spi_burst_busy)
+    {
+        if(softdevice_enabled)
+            sd_app_evt_wait();
+        else
+            __WFE();
+    }
+
+    return RFIDR_SUCCESS;
+}
+
 //Wrapper for NRF SPI transfer. The internal function takes state variables as arguments, simplifying the interface of this file module to
 //other modules in the RFID reader MCU codebase.
+//A single frame is only 8us at 4MHz, which is less than the cost of taking an interrupt per byte, so it is still polled.
 uint32_t spi_cntrlr_send_recv(void)
 {
     uint32_t err_code = NRF_SUCCESS;
@@ -106,66 +176,230 @@ rfidr_error_t spi_cntrlr_read_rx(uint8_t * p_spi_rx_byte)
     return RFIDR_SUCCESS;
 }
 
-//Construct the SPI TX packet based on: 
+//SPI frame header bits, before the whole 23-bit command word is shifted up by 9 to fill the 4-byte frame.
+#define SPI_FRAME_WRITE          (1UL << 22)    /*Write, not read*/
+#define SPI_FRAME_WVFM_MEM       (1UL << 21)    /*This is a waveform memory operation*/
+#define SPI_FRAME_RDIO_MEM       (1UL << 20)    /*This is a radio memory operation*/
+#define SPI_FRAME_TXCN_MEM       (1UL << 19)    /*This is a txcancel memory operation*/
+#define SPI_FRAME_USER_MEM       (1UL << 18)    /*This is a user memory operation*/
+#define SPI_FRAME_RXRAM          (1UL << 17)    /*Operate on the rx half of the radio RAM*/
+
+#define SPI_FRAME_HEADER(bits)   ((uint32_t)(bits) << 9)
+
+//Frame headers for every combination of 1) Which FPGA memory to access, 2) Read/write, 3) RX or TX RAM in the case of the Radio RAM,
+//already shifted into their place in the frame. Indexed as [spi_mem][wr][rxntx], which follows the order of the enums in rfidr_spi.h.
+//The waveform memory can only be read, and only the radio memory has an RX/TX half.
+static const uint32_t m_spi_frame_header[4][2][2] =
+{
+    /*RFIDR_WVFM_MEM*/  {{SPI_FRAME_HEADER(SPI_FRAME_WVFM_MEM),                                        SPI_FRAME_HEADER(SPI_FRAME_WVFM_MEM)},
+                         {SPI_FRAME_HEADER(SPI_FRAME_WVFM_MEM),                                        SPI_FRAME_HEADER(SPI_FRAME_WVFM_MEM)}},
+    /*RFIDR_RDIO_MEM*/  {{SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_RDIO_MEM | SPI_FRAME_RXRAM),    SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_RDIO_MEM)},
+                         {SPI_FRAME_HEADER(SPI_FRAME_RDIO_MEM | SPI_FRAME_RXRAM),                      SPI_FRAME_HEADER(SPI_FRAME_RDIO_MEM)}},
+    /*RFIDR_TXCN_MEM*/  {{SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_TXCN_MEM),                      SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_TXCN_MEM)},
+                         {SPI_FRAME_HEADER(SPI_FRAME_TXCN_MEM),                                        SPI_FRAME_HEADER(SPI_FRAME_TXCN_MEM)}},
+    /*RFIDR_USER_MEM*/  {{SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_USER_MEM),                      SPI_FRAME_HEADER(SPI_FRAME_WRITE | SPI_FRAME_USER_MEM)},
+                         {SPI_FRAME_HEADER(SPI_FRAME_USER_MEM),                                        SPI_FRAME_HEADER(SPI_FRAME_USER_MEM)}}
+};
+
+//Address masks for each FPGA memory, indexed by spi_mem.
+static const uint16_t m_spi_frame_addr_mask[4] =
+{
+    (1<<13) -1,    /*The waveform memory address should be 13 bits */
+    (1<<9)  -1,    /*The radio memory address should be 9 bits */
+    (1<<10) -1,    /*The txcancel memory address should be 10 bits */
+    (1<<3)  -1     /*The user memory address should be 3 bits */
+};
+
+//Look up the frame header for a transaction. spi_mem must already be a valid spi_mem_t.
+__attribute__( ( always_inline ) ) __STATIC_INLINE uint32_t spi_cntrlr_frame_header(spi_mem_t spi_mem, spi_wr_t wr, spi_rxntx_ram_t rxntx)
+{
+    return m_spi_frame_header[spi_mem][wr != RFIDR_SPI_WRITE][rxntx != RFIDR_SPI_RXRAM];
+}
+
+//Fast path: OR the address and data into a header from m_spi_frame_header and split the result into the frame bytes.
+//The address is at bit 8 and the data at bit 0 of the command word, so after the shift by 9 the last frame byte is always zero.
+__attribute__( ( always_inline ) ) __STATIC_INLINE void spi_cntrlr_encode_frame_fast(uint32_t header, uint16_t addr_mask, uint16_t addr, uint8_t data, uint8_t * p_frame)
+{
+    uint32_t temp    =    header | ((uint32_t)(addr & addr_mask) << 17) | ((uint32_t)data << 9);
+
+    p_frame[0]    =    (uint8_t)(temp >> 24);
+    p_frame[1]    =    (uint8_t)(temp >> 16);
+    p_frame[2]    =    (uint8_t)(temp >> 8);
+    p_frame[3]    =    0;
+}
+
+//Construct the SPI TX packet for a single transaction, based on:
 // 1) Which FPGA memory to write to, 2) Read/write, 3) RX or TX RAM in the case of the Radio RAM, 4) RAM Address, 5) Data to write
+//This is the same as spi_cntrlr_encode_frame_fast, written out in one piece since the firmware is built at -O0.
 rfidr_error_t spi_cntrlr_set_tx(spi_mem_t spi_mem, spi_wr_t wr, spi_rxntx_ram_t rxntx, uint16_t addr, uint8_t data)
 {
-    /*Declare a local temp variable to hold the arranged data */
-    uint32_t temp         =    0;
-    uint32_t addr_mask    =     (1<<3) -1; /*The address should be 3 bits */
-    uint32_t byte_mask    =    (1<<8)  -1; /*Byte mask should be 8 bits */
-
-    switch(spi_mem){
-        case RFIDR_WVFM_MEM:
-            addr_mask    =     (1<<13) -1; /*The address should be 13 bits */
-            temp         = temp | (0 << 22); /*Read, not write*/
-            temp         = temp | (1 << 21); /*This is a waveform memory operation*/
-            temp         = temp | ((addr & addr_mask) << 8); /*Load the address*/
-            break;
-        case RFIDR_RDIO_MEM:
-            addr_mask    =     (1<<9) -1; /*The address should be 9 bits */
-            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22); /*Write, not read*/
-            temp         = temp | (0 << 21); /*This is not a waveform memory operation*/
-            temp         = temp | (1 << 20); /*This is a radio memory operation*/
-            temp         = temp | ((rxntx == RFIDR_SPI_RXRAM) << 17); /*Set to operate on tx or rx half of RAM*/
-            temp         = temp | ((addr & addr_mask) << 8); /*Load the address*/
-            break;
-        case RFIDR_TXCN_MEM:
-            addr_mask    =     (1<<10) -1; /*The address should be 10 bits */
-            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22); /*Write, not read*/
-            temp         = temp | (0 << 21); /*This is not a waveform memory operation*/
-            temp         = temp | (0 << 20); /*This is not a radio memory operation*/
-            temp         = temp | (1 << 19); /*This is a txcancel memory operation*/
-            temp         = temp | ((addr & addr_mask) << 8); /*Load the address*/
-            break;
-        case RFIDR_USER_MEM:
-            addr_mask    =     (1<<3) -1; /*The address should be 3 bits */
-            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22); /*Write, not read*/
-            temp         = temp | (0 << 21); /*This is not a waveform memory operation*/
-            temp         = temp | (0 << 20); /*This is not a radio memory operation*/
-            temp         = temp | (0 << 19); /*This is not a txcancel memory operation*/
-            temp         = temp | (1 << 18); /*This is a user memory operation*/
-            temp         = temp | ((addr & addr_mask) << 8); /*Load the address*/
-            break;
-        default:
-            addr_mask    =     (1<<3) -1; /*The address should be 3 bits */
-            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22); /*Write, not read*/
-            temp         = temp | (0 << 21); /*This is not a waveform memory operation*/
-            temp         = temp | (0 << 20); /*This is not a radio memory operation*/
-            temp         = temp | (0 << 19); /*This is not a txcancel memory operation*/
-            temp         = temp | (1 << 18); /*This is a user memory operation*/
-            temp         = temp | ((addr & addr_mask) << 8); /*Load the address*/
-            break;
+    uint32_t temp    =    0;
+
+    //Anything out of range is treated as a user memory access, as the default case of the old switch statement did.
+    if(spi_mem > RFIDR_USER_MEM){spi_mem = RFIDR_USER_MEM;}
+
+    temp                =    m_spi_frame_header[spi_mem][wr != RFIDR_SPI_WRITE][rxntx != RFIDR_SPI_RXRAM]
+                             | ((uint32_t)(addr & m_spi_frame_addr_mask[spi_mem]) << 17) | ((uint32_t)data << 9);
+
+    m_tx_data_spi[0]    =    (uint8_t)(temp >> 24);
+    m_tx_data_spi[1]    =    (uint8_t)(temp >> 16);
+    m_tx_data_spi[2]    =    (uint8_t)(temp >> 8);
+    m_tx_data_spi[3]    =    0;
+
+    return RFIDR_SUCCESS;
+}
+
+//Read a run of consecutive addresses out of the radio or waveform RAM.
+//All of the read frames are built up front and then streamed to the FPGA back to back, so the per-byte cost is just the 32 SPI clocks
+//of each frame rather than a full set_tx/send_recv/read_rx round trip.
+//The FPGA SPI peripheral still latches one command per chip select assertion, so each frame keeps its own CS pulse.
+//User memory is excluded since it holds one-shot and sticky control bits that must be accessed one register at a time.
+rfidr_error_t spi_cntrlr_read_burst(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, uint8_t * p_data)
+{
+    uint16_t         num_frames     =    0;
+    uint16_t         loop_frames    =    0;
+    uint32_t         header         =    0;
+    rfidr_error_t    error_code     =    RFIDR_SUCCESS;
+
+    if(spi_mem != RFIDR_WVFM_MEM && spi_mem != RFIDR_RDIO_MEM)
+    {
+        return RFIDR_ERROR_SPI_BURST;
     }
 
-    temp                = temp | (byte_mask & data);
-    temp                = temp << 9;
+    header    =    spi_cntrlr_frame_header(spi_mem, RFIDR_SPI_READ, rxntx);
 
-    //Load the state variable bytes to be used by the NRF SPI function.
-    m_tx_data_spi[0]    =    (temp >> 24) & byte_mask;
-    m_tx_data_spi[1]    =    (temp >> 16) & byte_mask;
-    m_tx_data_spi[2]    =    (temp >> 8) & byte_mask;
-    m_tx_data_spi[3]    =    (temp >> 0) & byte_mask;
+    while(length > 0)
+    {
+        num_frames    =    (length > SPI_BURST_MAX_FRAMES) ? SPI_BURST_MAX_FRAMES : length;
+
+        for(loop_frames=0;loop_frames < num_frames;loop_frames++)
+        {
+            spi_cntrlr_encode_frame_fast(header, m_spi_frame_addr_mask[spi_mem], start_addr+loop_frames, 0, &m_tx_burst_spi[loop_frames*TX_RX_MSG_LENGTH]);
+        }
+
+        error_code    =    spi_cntrlr_burst_transfer(num_frames);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+
+        //The byte read back from the FPGA sits in the last byte of each frame, just as in spi_cntrlr_read_rx.
+        for(loop_frames=0;loop_frames < num_frames;loop_frames++)
+        {
+            *p_data++    =    m_rx_burst_spi[loop_frames*TX_RX_MSG_LENGTH+3];
+        }
+
+        start_addr    +=    num_frames;
+        length        -=    num_frames;
+    }
+
+    return RFIDR_SUCCESS;
+}
+
+//Write a run of consecutive addresses in the radio RAM.
+//As with the burst read, the frames are streamed back to back. No read back is performed here - callers that require
+//verification should follow up with spi_cntrlr_read_burst over the same range.
+//The waveform RAM is read-only from the MCU side, so only the radio RAM is accepted.
+rfidr_error_t spi_cntrlr_write_burst(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, const uint8_t * p_data)
+{
+    uint16_t         num_frames     =    0;
+    uint16_t         loop_frames    =    0;
+    uint32_t         header         =    0;
+    rfidr_error_t    error_code     =    RFIDR_SUCCESS;
+
+    if(spi_mem != RFIDR_RDIO_MEM)
+    {
+        return RFIDR_ERROR_SPI_BURST;
+    }
+
+    header    =    spi_cntrlr_frame_header(spi_mem, RFIDR_SPI_WRITE, rxntx);
+
+    while(length > 0)
+    {
+        num_frames    =    (length > SPI_BURST_MAX_FRAMES) ? SPI_BURST_MAX_FRAMES : length;
+
+        for(loop_frames=0;loop_frames < num_frames;loop_frames++)
+        {
+            spi_cntrlr_encode_frame_fast(header, m_spi_frame_addr_mask[spi_mem], start_addr+loop_frames, *p_data++, &m_tx_burst_spi[loop_frames*TX_RX_MSG_LENGTH]);
+        }
+
+        error_code    =    spi_cntrlr_burst_transfer(num_frames);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+
+        start_addr    +=    num_frames;
+        length        -=    num_frames;
+    }
+
+    return RFIDR_SUCCESS;
+}
+
+//A robust version of spi_cntrlr_write_burst.
+//Rather than reading back each byte right after writing it, the whole range is streamed in, then read back in bulk.
+//Only the runs of bytes that fail to compare are rewritten, and the range is checked again, up to 3 times before giving up and flagging an error.
+//The work is done in chunks of SPI_BURST_MAX_FRAMES so that the read back buffer stays small.
+rfidr_error_t spi_cntrlr_write_burst_robust(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, const uint8_t * p_data)
+{
+    uint16_t         chunk_length    =    0;
+    uint16_t         loop_bytes      =    0;
+    uint16_t         run_start       =    0;
+    uint8_t          loop_try        =    0;
+    bool             mismatch        =    false;
+    rfidr_error_t    error_code      =    RFIDR_SUCCESS;
+
+    while(length > 0)
+    {
+        chunk_length    =    (length > SPI_BURST_MAX_FRAMES) ? SPI_BURST_MAX_FRAMES : length;
+
+        error_code      =    spi_cntrlr_write_burst(spi_mem, rxntx, start_addr, chunk_length, p_data);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+
+        for(loop_try=0;loop_try < 3;loop_try++)
+        {
+            //Read back the whole chunk in one burst.
+            error_code    =    spi_cntrlr_read_burst(spi_mem, rxntx, start_addr, chunk_length, m_chk_burst_spi);
+            if(error_code != RFIDR_SUCCESS){return error_code;}
+
+            //Look for runs of bytes that don't match and rewrite just those runs.
+            mismatch    =    false;
+            loop_bytes  =    0;
+            while(loop_bytes < chunk_length)
+            {
+                if(m_chk_burst_spi[loop_bytes] == p_data[loop_bytes])
+                {
+                    loop_bytes++;
+                    continue;
+                }
+
+                mismatch     =    true;
+                run_start    =    loop_bytes;
+                while(loop_bytes < chunk_length && m_chk_burst_spi[loop_bytes] != p_data[loop_bytes])
+                {
+                    loop_bytes++;
+                }
+                spi_cntrlr_count(&m_spi_retry_count[spi_mem], loop_bytes-run_start);
+                error_code    =    spi_cntrlr_write_burst(spi_mem, rxntx, start_addr+run_start, loop_bytes-run_start, p_data+run_start);
+                if(error_code != RFIDR_SUCCESS){return error_code;}
+            }
+
+            if(!mismatch)
+            {
+                break;
+            }
+        }
+
+        //If the last pass still had to rewrite something, the rewrite itself has not been checked yet, so check it one final time.
+        if(mismatch)
+        {
+            error_code    =    spi_cntrlr_read_burst(spi_mem, rxntx, start_addr, chunk_length, m_chk_burst_spi);
+            if(error_code != RFIDR_SUCCESS){return error_code;}
+            if(memcmp(m_chk_burst_spi, p_data, chunk_length))
+            {
+                spi_cntrlr_count(&m_spi_failure_count[spi_mem], 1);
+                return RFIDR_ERROR_SPI_WRITE_TX;
+            }
+        }
+
+        start_addr    +=    chunk_length;
+        p_data        +=    chunk_length;
+        length        -=    chunk_length;
+    }
 
     return RFIDR_SUCCESS;
 }
@@ -185,8 +419,10 @@ rfidr_error_t spi_cntrlr_write_tx_robust(spi_mem_t spi_mem, spi_rxntx_ram_t rxnt
         {
             return RFIDR_SUCCESS;
         }
+        spi_cntrlr_count(&m_spi_retry_count[spi_mem > RFIDR_USER_MEM ? RFIDR_USER_MEM : spi_mem], 1);
         loop_try++;
     }
+    spi_cntrlr_count(&m_spi_failure_count[spi_mem > RFIDR_USER_MEM ? RFIDR_USER_MEM : spi_mem], 1);
     return RFIDR_ERROR_SPI_WRITE_TX;
 }
 
@@ -302,6 +538,7 @@ rfidr_error_t spi_cntrlr_write_sx1257_robust(uint8_t sx1257_addr, uint8_t sx1257
         spi_cntrlr_send_recv();
         if(m_rx_data_spi[3] != sx1257_data )
         {
+            spi_cntrlr_count(&m_spi_failure_count[RFIDR_USER_MEM], 1);    //The SX1257 bridge lives in the user memory.
             return RFIDR_ERROR_SPI_WRITE_SX1257_4;
         }
         else
@@ -374,4 +611,282 @@ rfidr_error_t spi_cntrlr_read_sx1257_robust(uint8_t sx1257_addr, uint8_t * sx125
 
 }
 
+//Run one SX1257 register access through the FPGA SPI bridge: load the address (and, for a write, the data), kick the bridge,
+//poll for done and deassert the kick. The bridge normally finishes within the first poll.
+//For a read the data byte is not loaded, since the SX1257 ignores it and it would be overwritten by the returned byte anyway.
+static rfidr_error_t spi_cntrlr_sx1257_bridge_access(uint8_t sx1257_addr_masked, bool load_data, uint8_t sx1257_data, rfidr_error_t timeout_error)
+{
+    uint8_t        loop_try_inner                =    0;
+
+    //Write SX1257 WNR bit + ADDR to SPI cntrlr passthrough address byte
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_ADDR_ADDR, sx1257_addr_masked);
+    spi_cntrlr_send_recv();
+    if(load_data)
+    {
+        //Write SX1257 DATA to SPI cntrlr passthrough data byte
+        spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_DATA_ADDR, sx1257_data);
+        spi_cntrlr_send_recv();
+    }
+    //Write spi ready address with just a 2
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 2);
+    spi_cntrlr_send_recv();
+
+    while (1)
+    {
+        //Check to see that the FPGA cntrlr SPI done register indicates that it is done
+        spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 0);
+        spi_cntrlr_send_recv();
+        if(((m_rx_data_spi[3] >> 5) & 1) == 1 )
+        {
+            break;
+        }
+        loop_try_inner++;
+        if(loop_try_inner > 3)
+        {
+            return timeout_error;
+        }
+    }
+
+    //Write spi ready deassert
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 0);
+    spi_cntrlr_send_recv();
+
+    return RFIDR_SUCCESS;
+}
+
+//A function for writing a list of SX1257 registers through the SPI bridge in the FPGA.
+//Compared with calling spi_cntrlr_write_sx1257_robust once per register, the bridge status is checked once for the whole list,
+//each register is written with a single kick of the bridge, and all of the registers are read back and compared in one pass at the end.
+//Registers which fail to compare are written and checked again, up to 3 times in total.
+//The registers are written in list order, which matters for registers such as the frequency words that take effect as a group.
+rfidr_error_t spi_cntrlr_write_sx1257_list(const sx1257_reg_t * p_regs, uint8_t num_regs)
+{
+    uint32_t       pending_regs                  =    0;    //One bit per list entry that still has to be written and verified.
+    uint8_t        loop_try                      =    0;
+    uint8_t        loop_regs                     =    0;
+    rfidr_error_t  error_code                    =    RFIDR_SUCCESS;
+
+    if(num_regs > SX1257_LIST_MAX_REGS){return RFIDR_ERROR_SPI_WRITE_SX1257_5;}
+    if(num_regs == 0){return RFIDR_SUCCESS;}
+
+    //Check to see that pending and done registers are properly set
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 0);
+    spi_cntrlr_send_recv();
+    if(((m_rx_data_spi[3] >> 5) & 3) != 0 )
+    {
+        return RFIDR_ERROR_SPI_WRITE_SX1257_1;
+    }
+
+    pending_regs    =    (1UL << num_regs) - 1;
+
+    for(loop_try=0;loop_try < 3;loop_try++)
+    {
+        //Write pass. There is only 7-bit address space in the SX1257. MSB is the read/write bit.
+        for(loop_regs=0;loop_regs < num_regs;loop_regs++)
+        {
+            if(!((pending_regs >> loop_regs) & 1)){continue;}
+            error_code    =    spi_cntrlr_sx1257_bridge_access((p_regs[loop_regs].addr & 127) | 128, true, p_regs[loop_regs].data, RFIDR_ERROR_SPI_WRITE_SX1257_2);
+            if(error_code != RFIDR_SUCCESS){return error_code;}
+        }
+
+        //Verify pass. Read back returned data from SX1257 for each register just written.
+        for(loop_regs=0;loop_regs < num_regs;loop_regs++)
+        {
+            if(!((pending_regs >> loop_regs) & 1)){continue;}
+            error_code    =    spi_cntrlr_sx1257_bridge_access(p_regs[loop_regs].addr & 127, false, 0, RFIDR_ERROR_SPI_WRITE_SX1257_3);
+            if(error_code != RFIDR_SUCCESS){return error_code;}
+
+            spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_RTRN_ADDR, 0);
+            spi_cntrlr_send_recv();
+            if(m_rx_data_spi[3] == p_regs[loop_regs].data)
+            {
+                pending_regs    &=    ~(1UL << loop_regs);
+            }
+            else
+            {
+                spi_cntrlr_count(&m_spi_retry_count[RFIDR_USER_MEM], 1);    //The SX1257 bridge lives in the user memory.
+            }
+        }
+
+        if(pending_regs == 0)
+        {
+            return RFIDR_SUCCESS;
+        }
+    }
+
+    spi_cntrlr_count(&m_spi_failure_count[RFIDR_USER_MEM], 1);
+    return RFIDR_ERROR_SPI_WRITE_SX1257_4;
+}
+
+//SPI clock rates tried during link training, fastest first.
+static const SPI_frequency_t m_spi_training_freqs[]    =    {SPI_FREQ_8MBPS, SPI_FREQ_4MBPS, SPI_FREQ_2MBPS, SPI_FREQ_1MBPS};
+
+//Bytes written to and read back from the FPGA during link training: all zeros, all ones, alternating bits and a walking one.
+static const uint8_t m_spi_training_patterns[]         =    {0x00, 0xFF, 0xAA, 0x55, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+#define USER_MEM_SPI_TRAINING_ADDR       3    //Address of the waveform offset register in FPGA SPI peripheral user memory.
+#define SPI_TRAINING_PASSES              8    //Number of times the pattern list is run at each rate.
+#define SPI_CHECK_PASSES                 1    //Number of times the pattern list is run to confirm a rate remembered from an earlier training.
+#define SPI_TRAINING_READS               16   //Number of read-only frames a rate has to get right before it is trusted with writes.
+
+//Read the scratch register back several times at the current SPI clock and check that it holds the value read at the default rate.
+//A write frame whose address byte is corrupted can land on any user memory register, including the SX1257 bridge kick at address 2,
+//so a rate has to get reads right before the training patterns are written at it.
+static bool spi_cntrlr_link_reads_clean(uint8_t expected)
+{
+    uint8_t          loop_read        =    0;
+
+    for(loop_read=0;loop_read < SPI_TRAINING_READS;loop_read++)
+    {
+        spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, 0);
+        spi_cntrlr_send_recv();
+        if(m_rx_data_spi[3] != expected){return false;}
+    }
+
+    return true;
+}
+
+//Put the SX1257 bridge back to idle once training is done, at the rate that was picked.
+//Should a corrupted training frame have kicked the bridge anyway, this deasserts the kick just as a normal bridge access does,
+//and checks that the pending and done bits have cleared. load_sx1257_default rewrites every SX1257 register after training.
+static rfidr_error_t spi_cntrlr_idle_sx1257_bridge(void)
+{
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 0);
+    spi_cntrlr_send_recv();
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SX1257_STAT_ADDR, 0);
+    spi_cntrlr_send_recv();
+
+    return (((m_rx_data_spi[3] >> 5) & 3) == 0) ? RFIDR_SUCCESS : RFIDR_ERROR_SPI_LINK;
+}
+
+//Run the training patterns through the scratch register at the current SPI clock and count the mismatches.
+//Each pattern is written and then read back, as in spi_cntrlr_write_tx_robust. Only the read is checked, since the byte that comes back
+//during a write frame is not defined to be an echo of the data. Consecutive patterns differ, so a read that returns stale data is caught too.
+static uint16_t spi_cntrlr_count_link_errors(uint8_t passes)
+{
+    uint8_t          loop_pass        =    0;
+    uint8_t          loop_pattern     =    0;
+    uint16_t         error_count      =    0;
+
+    for(loop_pass=0;loop_pass < passes;loop_pass++)
+    {
+        for(loop_pattern=0;loop_pattern < sizeof(m_spi_training_patterns);loop_pattern++)
+        {
+            spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, m_spi_training_patterns[loop_pattern]);
+            spi_cntrlr_send_recv();
+            spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, 0);
+            spi_cntrlr_send_recv();
+            if(m_rx_data_spi[3] != m_spi_training_patterns[loop_pattern]){error_count++;}
+        }
+    }
+
+    return error_count;
+}
+
+//Find the fastest SPI clock at which the FPGA link is clean.
+//At each candidate rate, starting with the fastest, the scratch user memory register is first read back with read-only frames.
+//Only if those all come back right are the training patterns written to it several times over.
+//Each write is verified by reading the register back. The first rate with no errors at all is kept.
+//The waveform offset register is used as the scratch register since it is a plain 8-bit register that only matters when a waveform is captured.
+//Its contents are saved beforehand at the default rate and restored afterwards.
+//If no rate passes, the link is left at the default 4MHz and an error is returned.
+rfidr_error_t spi_cntrlr_train_link(void)
+{
+    uint8_t          saved_byte       =    0;
+    uint8_t          loop_freq        =    0;
+    bool             found_freq       =    false;
+    rfidr_error_t    error_code       =    RFIDR_SUCCESS;
+
+    m_spi_frequency    =    SPI_FREQ_4MBPS;
+    spi_cntrlr_set_frequency(SPI0, SPI_FREQ_4MBPS);
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, 0);
+    spi_cntrlr_send_recv();
+    saved_byte    =    m_rx_data_spi[3];
+
+    for(loop_freq=0;loop_freq < sizeof(m_spi_training_freqs)/sizeof(m_spi_training_freqs[0]) && !found_freq;loop_freq++)
+    {
+        spi_cntrlr_set_frequency(SPI0, m_spi_training_freqs[loop_freq]);
+
+        if(spi_cntrlr_link_reads_clean(saved_byte) && spi_cntrlr_count_link_errors(SPI_TRAINING_PASSES) == 0)
+        {
+            m_spi_frequency    =    (uint8_t)m_spi_training_freqs[loop_freq];
+            found_freq         =    true;
+        }
+    }
+
+    if(!found_freq)
+    {
+        m_spi_frequency    =    SPI_FREQ_4MBPS;
+    }
+    spi_cntrlr_set_frequency(SPI0, (SPI_frequency_t)m_spi_frequency);
+
+    error_code    =    spi_cntrlr_write_tx_robust(RFIDR_USER_MEM, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, saved_byte);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+    error_code    =    spi_cntrlr_idle_sx1257_bridge();
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    return found_freq ? RFIDR_SUCCESS : RFIDR_ERROR_SPI_LINK;
+}
+
+//Go straight to an SPI clock found by an earlier link training, after a single clean pass of the training patterns at that rate.
+//This is the warm boot shortcut. If the rate is not one training would pick, or the pass sees any error, the link is left at the default 4MHz.
+rfidr_error_t spi_cntrlr_check_link(uint16_t freq_khz)
+{
+    uint8_t          saved_byte       =    0;
+    uint8_t          loop_freq        =    0;
+    bool             found_freq       =    false;
+    rfidr_error_t    error_code       =    RFIDR_SUCCESS;
+
+    for(loop_freq=0;loop_freq < sizeof(m_spi_training_freqs)/sizeof(m_spi_training_freqs[0]);loop_freq++)
+    {
+        if((uint16_t)(((uint32_t)m_spi_training_freqs[loop_freq] * 125) / 2) == freq_khz){break;}
+    }
+    if(loop_freq >= sizeof(m_spi_training_freqs)/sizeof(m_spi_training_freqs[0])){return RFIDR_ERROR_SPI_LINK;}
+
+    m_spi_frequency    =    SPI_FREQ_4MBPS;
+    spi_cntrlr_set_frequency(SPI0, SPI_FREQ_4MBPS);
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, 0);
+    spi_cntrlr_send_recv();
+    saved_byte    =    m_rx_data_spi[3];
+
+    spi_cntrlr_set_frequency(SPI0, m_spi_training_freqs[loop_freq]);
+    if(spi_cntrlr_link_reads_clean(saved_byte) && spi_cntrlr_count_link_errors(SPI_CHECK_PASSES) == 0)
+    {
+        m_spi_frequency    =    (uint8_t)m_spi_training_freqs[loop_freq];
+        found_freq         =    true;
+    }
+    spi_cntrlr_set_frequency(SPI0, (SPI_frequency_t)m_spi_frequency);
+
+    error_code    =    spi_cntrlr_write_tx_robust(RFIDR_USER_MEM, RFIDR_SPI_TXRAM, (uint16_t)USER_MEM_SPI_TRAINING_ADDR, saved_byte);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+    error_code    =    spi_cntrlr_idle_sx1257_bridge();
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    return found_freq ? RFIDR_SUCCESS : RFIDR_ERROR_SPI_LINK;
+}
+
+//Report the SPI clock chosen by link training, in kHz.
+uint16_t spi_cntrlr_read_link_freq_khz(void)
+{
+    //SPI_FREQ_125KBPS is 0x02 and each doubling of the rate doubles the code, so the code is the rate in units of 62.5kHz.
+    return (uint16_t)(((uint32_t)m_spi_frequency * 125) / 2);
+}
+
+//Read the retry and failure counters kept for one FPGA memory.
+rfidr_error_t spi_cntrlr_read_link_stats(spi_mem_t spi_mem, uint16_t * p_retries, uint16_t * p_failures)
+{
+    if(spi_mem > RFIDR_USER_MEM){return RFIDR_ERROR_GENERAL;}
+
+    *p_retries     =    m_spi_retry_count[spi_mem];
+    *p_failures    =    m_spi_failure_count[spi_mem];
+
+    return RFIDR_SUCCESS;
+}
+
+void spi_cntrlr_clear_link_stats(void)
+{
+    memset(m_spi_retry_count, 0, sizeof(m_spi_retry_count));
+    memset(m_spi_failure_count, 0, sizeof(m_spi_failure_count));
+}
+
 //#endif
@@ -90,6 +90,22 @@ typedef enum
   RFIDR_SPI_TXRAM
 } spi_rxntx_ram_t;
 
+//One SX1257 register address/data pair, for batched writes through the FPGA SPI bridge.
+
+typedef struct
+{
+  uint8_t addr;
+  uint8_t data;
+} sx1257_reg_t;
+
+//Maximum number of registers in one batched SX1257 write.
+
+#define SX1257_LIST_MAX_REGS    16
+
+//Number of bytes in each SPI frame. The byte read back from the FPGA is the last byte of the frame.
+
+#define SPI_FRAME_LENGTH_IN_BYTES    4
+
 //function for initializing the spi cntrlr
 //returns NRF_SUCCESS on successful SPI initialization
 
@@ -110,6 +126,21 @@ rfidr_error_t spi_cntrlr_read_rx(uint8_t * p_spi_rx_byte);
 
 rfidr_error_t spi_cntrlr_set_tx(spi_mem_t spi_mem, spi_wr_t wr, spi_rxntx_ram_t rxntx, uint16_t addr, uint8_t data);
 
+//function for reading a run of consecutive radio or waveform RAM addresses in one burst
+//returns RFIDR_SUCCESS on successful SPI burst read
+
+rfidr_error_t spi_cntrlr_read_burst(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, uint8_t * p_data);
+
+//function for writing a run of consecutive radio RAM addresses in one burst
+//returns RFIDR_SUCCESS on successful SPI burst write
+
+rfidr_error_t spi_cntrlr_write_burst(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, const uint8_t * p_data);
+
+//function for writing a run of consecutive radio RAM addresses in one burst, followed by a bulk read back and rewrite of any mismatched bytes
+//returns RFIDR_SUCCESS on successful SPI burst write
+
+rfidr_error_t spi_cntrlr_write_burst_robust(spi_mem_t spi_mem, spi_rxntx_ram_t rxntx, uint16_t start_addr, uint16_t length, const uint8_t * p_data);
+
 //function for making a robust SPI write to general memories
 //returns RFIDR_SUCCESS on successful SPI TX buffer write
 
@@ -120,10 +151,39 @@ rfidr_error_t spi_cntrlr_write_tx_robust(spi_mem_t spi_mem, spi_rxntx_ram_t rxnt
 
 rfidr_error_t spi_cntrlr_write_sx1257_robust(uint8_t addr, uint8_t data);
 
+//function for making a robust SPI write of a list of SX1257 registers, verified together at the end
+//returns RFIDR_SUCCESS on successful write of every register in the list
+
+rfidr_error_t spi_cntrlr_write_sx1257_list(const sx1257_reg_t * p_regs, uint8_t num_regs);
+
 //function for making a robust SPI read check to the SX1257
 //returns NRF_SUCCESS Successful SPI TX buffer set
 
 rfidr_error_t spi_cntrlr_read_sx1257_robust(uint8_t addr, uint8_t * data);
 
+//function for finding the fastest SPI clock at which a known pattern can be written to and read back from FPGA user memory without error
+//returns RFIDR_SUCCESS if a clean rate was found, RFIDR_ERROR_SPI_LINK if none was and the default rate is kept
+
+rfidr_error_t spi_cntrlr_train_link(void);
+
+//function for confirming that an SPI clock found by an earlier link training is still clean, and using it if so
+//returns RFIDR_SUCCESS if the rate passed, RFIDR_ERROR_SPI_LINK if it did not and the default rate is kept
+
+rfidr_error_t spi_cntrlr_check_link(uint16_t freq_khz);
+
+//function for reading back the SPI clock in use
+//returns the SPI clock in kHz
+
+uint16_t spi_cntrlr_read_link_freq_khz(void);
+
+//function for reading the robust write retry and failure counters for one FPGA memory
+//returns RFIDR_SUCCESS on successful read
+
+rfidr_error_t spi_cntrlr_read_link_stats(spi_mem_t spi_mem, uint16_t * p_retries, uint16_t * p_failures);
+
+//function for zeroing the robust write retry and failure counters for all FPGA memories
+
+void spi_cntrlr_clear_link_stats(void);
+
 #endif // RFIDR_SPI_H__
 
@@ -44,12 +44,19 @@
 #include "nrf_adc.h"
 #include "nrf_delay.h"
 #include "nrf_error.h"
+#include "rfidr_agc.h"
+#include "rfidr_chplan.h"
+#include "rfidr_config.h"
+#include "rfidr_dwell.h"
 #include "rfidr_error.h"
 #include "rfidr_gpio.h"
+#include "rfidr_pdoa.h"
 #include "rfidr_rxradio.h"
 #include "rfidr_spi.h"
 #include "rfidr_state.h"
 #include "rfidr_sx1257.h"
+#include "rfidr_tagtable.h"
+#include "rfidr_txcal.h"
 #include "rfidr_txradio.h"
 #include "rfidr_user.h"
 #include "rfidr_waveform.h"
@@ -64,10 +71,12 @@ static rfidr_state_t    m_rfidr_state                            =    IDLE_UNCON
 static rfidr_state_t    m_rfidr_state_next                       =    IDLE_UNCONFIGURED;    //Transition to next state when we can
 static bool             m_received_irq_flag                      =    false;
 static bool             m_received_hvc_read_state_flag           =    false;
-static bool             m_received_hvc_pckt_data1_flag           =    false;
 static bool             m_dtc_state_flag                         =    false;
 static bool             m_track_tag_state_flag                   =    false;
 static bool             m_adc_returned_flag                      =    false;                //To be set to true when adc returns data.
+static bool             m_packed_reports_flag                    =    false;                //The iDevice asked for inventory results in the packed multi-tag format.
+static bool             m_dedup_reports_flag                     =    false;                //The iDevice asked to hear about each tag only when it is new or has changed.
+static bool             m_range_reports_flag                     =    false;                //The iDevice asked for on-reader PDOA ranges during tracking.
 static uint16_t         m_num_inv_tags_found                     =    0;
 static uint8_t          m_return_state_code                      =    0;
 static uint8_t          m_hopskip_nonce                          =    0;    //A number to help the iDevice keep track of which hop/skip pairs are associated.
@@ -157,10 +166,12 @@ void    rfidr_state_init(void)
     m_rfidr_state_next                       =    IDLE_UNCONFIGURED;    //State variable to hold the state to transition to the next time run_rfidr_state_machine is called.
     m_received_irq_flag                      =    false;                //Indicates when an IRQ has been received from the FPGA.
     m_received_hvc_read_state_flag           =    false;                //Indicates when an indication ACK has been received on the BTLE "Read State" characteristic.
-    m_received_hvc_pckt_data1_flag           =    false;                //Indicates when an indication ACK has been received on the BTLE "Data 1" characteristic.
     m_dtc_state_flag                         =    false;                //Indicates when we are being kept in the DTC state to operate the reader in testing mode.
     m_track_tag_state_flag                   =    false;                //Indicates when we are being kept in a tag tracking state to continually track a set of tags.
     m_adc_returned_flag                      =    false;                //Indicates whether the ADC has returned a value or not.
+    m_packed_reports_flag                    =    false;                //Indicates whether the iDevice opted in to packed multi-tag inventory reports.
+    m_dedup_reports_flag                     =    false;                //Indicates whether the iDevice opted in to deduplicated inventory reports.
+    m_range_reports_flag                     =    false;                //Indicates whether the iDevice opted in to on-reader PDOA range reports.
     m_num_inv_tags_found                     =    0;                    //Keep track of how many tags are found in an inventory - to be used while tracking tags.
     m_return_state_code                      =    0;                    //Not really used, we can delete this on the next major code overhaul.
     m_hopskip_nonce                          =    0;                    //We will increment each time we hop frequencies but not skip frequencies.
@@ -189,11 +200,73 @@ void    rfidr_state_received_read_state_confirmation(void)
     m_received_hvc_read_state_flag            =    true;
 }
 
-//This function sets a state variable flag denoting that the NRF BTLE SoftDevice has received an indication ACK from the iDevice for a packet data 1 characteristic write.
+//This function records whether the iDevice asked for inventory results in the packed multi-tag format along with its last state request.
 
-void    rfidr_state_received_pckt_data1_confirmation(void)
+void    rfidr_state_set_packed_reports(bool packed_reports)
 {
-    m_received_hvc_pckt_data1_flag            =    true;
+    m_packed_reports_flag                     =    packed_reports;
+}
+
+//This function records whether the iDevice asked to only hear about new or changed tags during inventory along with its last state request.
+
+void    rfidr_state_set_dedup_reports(bool dedup_reports)
+{
+    m_dedup_reports_flag                      =    dedup_reports;
+}
+
+//This function records whether the iDevice asked for ranges computed on the reader, rather than raw hop/skip data, during tracking.
+
+void    rfidr_state_set_range_reports(bool range_reports)
+{
+    m_range_reports_flag                      =    range_reports;
+}
+
+//Refresh the SPI link statistics characteristic with the current SPI clock and the per-memory retry and failure counts.
+//The values are packed as 16b LSB-first words: clock in kHz, then retries and failures for each spi_mem_t in enum order.
+static void update_spi_stats_char(ble_rfidrs_t *p_rfidrs)
+{
+    uint8_t     stats[BLE_RFIDRS_SPI_STATS_CHAR_LEN]    =    {0};
+    uint16_t    link_freq_khz                           =    0;
+    uint16_t    retries                                 =    0;
+    uint16_t    failures                                =    0;
+    uint8_t     loop_mem                                =    0;
+
+    link_freq_khz    =    spi_cntrlr_read_link_freq_khz();
+    stats[0]         =    (uint8_t)(link_freq_khz & 255);
+    stats[1]         =    (uint8_t)(link_freq_khz >> 8);
+
+    for(loop_mem=RFIDR_WVFM_MEM;loop_mem<=RFIDR_USER_MEM;loop_mem++)
+    {
+        spi_cntrlr_read_link_stats((spi_mem_t)loop_mem,&retries,&failures);
+        stats[2+4*loop_mem]    =    (uint8_t)(retries & 255);
+        stats[3+4*loop_mem]    =    (uint8_t)(retries >> 8);
+        stats[4+4*loop_mem]    =    (uint8_t)(failures & 255);
+        stats[5+4*loop_mem]    =    (uint8_t)(failures >> 8);
+    }
+
+    ble_rfidrs_spi_stats_set(p_rfidrs,stats,BLE_RFIDRS_SPI_STATS_CHAR_LEN);    //Only fails if the service is not up yet, in which case there is no one to read it anyway.
+}
+
+//Refresh the PLL lock statistics characteristic with the SX1257 PLL settle time histogram and the number of lock timeouts.
+//The values are packed as 16b LSB-first words, histogram bins first.
+static void update_pll_stats_char(ble_rfidrs_t *p_rfidrs)
+{
+    uint8_t     stats[BLE_RFIDRS_PLL_STATS_CHAR_LEN]    =    {0};
+    uint16_t    hist[SX1257_LOCK_HIST_BINS]             =    {0};
+    uint16_t    timeouts                                =    0;
+    uint8_t     loop_bin                                =    0;
+
+    get_sx1257_lock_stats(hist,&timeouts);
+
+    for(loop_bin=0;loop_bin<SX1257_LOCK_HIST_BINS;loop_bin++)
+    {
+        stats[2*loop_bin]      =    (uint8_t)(hist[loop_bin] & 255);
+        stats[2*loop_bin+1]    =    (uint8_t)(hist[loop_bin] >> 8);
+    }
+    stats[2*SX1257_LOCK_HIST_BINS]      =    (uint8_t)(timeouts & 255);
+    stats[2*SX1257_LOCK_HIST_BINS+1]    =    (uint8_t)(timeouts >> 8);
+
+    ble_rfidrs_pll_stats_set(p_rfidrs,stats,BLE_RFIDRS_PLL_STATS_CHAR_LEN);    //Only fails if the service is not up yet, in which case there is no one to read it anyway.
 }
 
 //This function informs the iDevice of any state transition and hence serves as a "bookend" function in the run_rfidr_state_machine function
@@ -201,12 +274,37 @@ static void rfidr_state_bookend_function(ble_rfidrs_t *p_rfidrs)
 {
     uint32_t    nrf_error_code                =    NRF_SUCCESS;
 
+    update_spi_stats_char(p_rfidrs);
+    update_pll_stats_char(p_rfidrs);
+    //Tag reports go out as indications too, and only one indication may be outstanding.
+    //If the iDevice has stopped acknowledging them, they are dropped after a timeout rather than holding up the state change.
+    //The log message is a notification, so it does not have to wait for an acknowledgement either.
+    if(rfidr_report_queue_flush() != RFIDR_SUCCESS){send_log_message(p_rfidrs,"Tag reports timed out, rest dropped");}
     m_received_hvc_read_state_flag            =    false;
     nrf_error_code=ble_rfidrs_read_state_send(p_rfidrs,decode_rfidr_state(m_rfidr_state),BLE_RFIDRS_READ_STATE_CHAR_LEN);
     if (nrf_error_code != NRF_ERROR_INVALID_STATE){APP_ERROR_CHECK(nrf_error_code);}
     while(m_received_hvc_read_state_flag == false){}
 }
 
+//Report how many TX RAM bytes this state wrote over SPI and how many it skipped because the TX RAM shadow already held them.
+//Likewise for SX1257 register reads and writes and the SX1257 register shadow.
+static void report_shadow_stats(ble_rfidrs_t *p_rfidrs)
+{
+    char        short_message[20]            =    {0};
+    uint32_t    bytes_written                =    0;
+    uint32_t    bytes_skipped                =    0;
+    uint32_t    transactions                 =    0;
+    uint32_t    avoided                      =    0;
+
+    read_tx_ram_shadow_stats(&bytes_written,&bytes_skipped);
+    snprintf(short_message,sizeof(short_message),"TxW:%6d S:%6d",(int)bytes_written,(int)bytes_skipped);
+    send_short_message(p_rfidrs, short_message);
+
+    read_sx1257_shadow_stats(&transactions,&avoided);
+    snprintf(short_message,sizeof(short_message),"SxT:%6d S:%6d",(int)transactions,(int)avoided);
+    send_short_message(p_rfidrs, short_message);
+}
+
 //We got an error - send a message to the iDevice, shut down the PA to avoid damage, and return to unconfigured state.
 //The intent is to go back to the unconfigured state if we get an error during initialization.
 
@@ -364,15 +462,14 @@ uint32_t    read_rfidr_state(rfidr_state_t    * p_rfidr_state)
 //We run this routine when we are sure that the FPGA is putting all "zeros" through the DACs.
 //In this fashion, minimizing the RF output power is tantamount to maximizing the modulation depth of
 //of the reader when we are doing DSB-ASK modulation.
+//Note that the MAX2204 power detector takes about 1ms to completely settle, which dictates how fast we can measure a point.
 
-static rfidr_error_t tx_offset_calibration_core(ble_rfidrs_t *p_rfidrs,uint8_t loop_tx_cal_sdm,uint8_t loop_tx_cal_zgn)
+static rfidr_error_t tx_offset_calibration_core(uint8_t loop_tx_cal_sdm, uint8_t loop_tx_cal_zgn, uint16_t *p_power)
 {
     rfidr_error_t    rfidr_error_code                        =    RFIDR_SUCCESS;
     
-    rfidr_error_code = set_tx_sdm_offset(loop_tx_cal_sdm);
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, set sdm offset","",rfidr_error_code); return rfidr_error_code;}
-    rfidr_error_code = set_tx_zgn_offset(loop_tx_cal_zgn);
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, set zgn offset","",rfidr_error_code); return rfidr_error_code;}
+    rfidr_error_code = set_tx_offsets(loop_tx_cal_sdm,loop_tx_cal_zgn);
+        if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
     nrf_delay_us(100);
     rfidr_enable_pa();
     nrf_delay_us(800);
@@ -380,157 +477,38 @@ static rfidr_error_t tx_offset_calibration_core(ble_rfidrs_t *p_rfidrs,uint8_t l
     nrf_adc_start();
     while(m_adc_returned_flag == false){}
     rfidr_disable_pa();
+    *p_power = m_last_adc_sample;
     
     return RFIDR_SUCCESS;
 }
 
-//Note that the MAX2204 power detector takes about 1ms to completely settle, which will dictate how fast we can 
-//actuate the algorithm.
-//Also the FCC requirement to hop every 400ms means that we need to complete this operation within 400ms.
-//Luckily it appears we have time to do this, but not with a lot of margin.
-//We won't use a full gradient descent scheme since we really need to find the minimum value to ensure maximum modulation depth.
-//We'll just brute force the approach since we should have just enough time to do this.
+//Calibrate the TX offsets for the channel the SX1257 is tuned to with the coarse-to-fine search in rfidr_txcal.c, and leave them set.
+//From cold this measures about 32 points instead of 256. Calling it again on a calibrated channel only re-measures the 9 points around its cached offsets.
+//Make sure the PA is off when calling this.
 
-static rfidr_error_t tx_offset_calibration_brute_force(ble_rfidrs_t *p_rfidrs)
+static rfidr_error_t tx_offset_calibration_channel(uint8_t frequency_slot, rfidr_txcal_result_t *p_result)
 {
     rfidr_error_t    rfidr_error_code                        =    RFIDR_SUCCESS;
-    uint8_t          loop_tx_cal_sdm                         =    0;
-    uint8_t          loop_tx_cal_zgn                         =    0;
-    uint8_t          sdm_offset_best                         =    8;
-    uint8_t          zgn_offset_best                         =    8;
-    uint16_t         meas_power_best                         =    9999;
-    uint8_t          recover_frequency_slot                  =    12;
-    char             short_message[20]                       =    {0};
 
-    rfidr_error_code=hop_sx1257_frequency(&recover_frequency_slot); m_hopskip_nonce++;
-    //rfidr_error_code=set_sx1257_frequency(12); m_hopskip_nonce++;
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, freq. hop.","",rfidr_error_code); return rfidr_error_code;}
+    rfidr_error_code = rfidr_txcal_run(frequency_slot,tx_offset_calibration_core,p_result);
+        if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
 
-    rfidr_disable_pa();
-
-    for (loop_tx_cal_sdm = 0; loop_tx_cal_sdm < 16; loop_tx_cal_sdm++)
-    {
-        for (loop_tx_cal_zgn = 0; loop_tx_cal_zgn < 16; loop_tx_cal_zgn++)
-        {
-            rfidr_error_code = tx_offset_calibration_core(p_rfidrs,loop_tx_cal_sdm,loop_tx_cal_zgn);
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, tx cal core","",rfidr_error_code); return rfidr_error_code;}
-
-            //sprintf(short_message,"CAL S:%02d Z:%02d O:%04d",loop_tx_cal_sdm,loop_tx_cal_zgn,m_last_adc_sample);
-            //send_short_message(p_rfidrs, short_message);
-            if(m_last_adc_sample < meas_power_best)
-            {
-                meas_power_best = m_last_adc_sample;
-                sdm_offset_best = loop_tx_cal_sdm;
-                zgn_offset_best = loop_tx_cal_zgn;
-            }
-        }
-    }
-    rfidr_disable_pa();
-    rfidr_error_code = set_tx_sdm_offset(sdm_offset_best);
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, final set sdm offset","",rfidr_error_code); return rfidr_error_code;}
-    rfidr_error_code = set_tx_zgn_offset(zgn_offset_best);
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, final set zgn offset","",rfidr_error_code); return rfidr_error_code;}
-    sprintf(short_message,"CAL S:%02d Z:%02d O:%04d",sdm_offset_best,zgn_offset_best,meas_power_best);
-    send_short_message(p_rfidrs, short_message);
-
-    return rfidr_error_code;
+    return set_tx_offsets(p_result->sdm_offset,p_result->zgn_offset);
 }
 
-static rfidr_error_t tx_offset_calibration_gradient(ble_rfidrs_t *p_rfidrs)
-{
-    #define          MAX_GRAD_CAL_ITERS                           96
-    
-    rfidr_error_t    rfidr_error_code                        =    RFIDR_SUCCESS;
-    int8_t           sdm_val_curr                            =    10;
-    int8_t           zgn_val_curr                            =    10;
-    int8_t           sdm_val_dir                             =    1;
-    int8_t           zgn_val_dir                             =    1;
-    uint16_t         result_curr                             =    9999;
-    bool             sdm_p_improve                           =    false;
-    bool             sdm_n_improve                           =    false;
-    bool             zgn_p_improve                           =    false;
-    bool             zgn_n_improve                           =    false;
-    uint8_t          recover_frequency_slot                  =    12;
-    uint8_t          iter_curr                               =    0;
-    char             short_message[20]                       =    {0};
+//Set the TX offsets for a channel we have just hopped to. Channels we have seen before get their cached offsets,
+//and new ones are calibrated starting from the nearest channel that has been. Make sure the PA is off when calling this.
 
-    rfidr_error_code=hop_sx1257_frequency(&recover_frequency_slot); m_hopskip_nonce++;
-    //rfidr_error_code=set_sx1257_frequency(12); m_hopskip_nonce++;
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, freq. hop.","",rfidr_error_code); return rfidr_error_code;}
-
-    while(iter_curr++ <= MAX_GRAD_CAL_ITERS)
-    {
-         sprintf(short_message,"S:%02d Z:%02d O:%03d I:%02d",(uint8_t)(sdm_val_curr%16),(uint8_t)(sdm_val_curr%16),result_curr,iter_curr);
-            send_short_message(p_rfidrs, short_message);
-        //Assuming "dir" is still the correct representation of the gradient, continue down the gradient.
-        rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr+sdm_val_dir)%16),(uint8_t)((zgn_val_curr+zgn_val_dir)%16));
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, gradient step","",rfidr_error_code); return rfidr_error_code;}
-        //If indeed we are still going down the gradient, update values. Don't change "dir" (the representation of the gradient).
-        if(m_last_adc_sample < result_curr)
-        {
-            result_curr    =    m_last_adc_sample;
-            sdm_val_curr   =    (sdm_val_curr+sdm_val_dir)%16;
-            zgn_val_curr   =    (zgn_val_curr+zgn_val_dir)%16;
-            continue; //Move to the next iteration of the loop.
-        }
-        else //We need to reestablish the gradient.
-        {
-            rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr+1)%16),(uint8_t)((zgn_val_curr+0)%16));
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, ip grad test","",rfidr_error_code); return rfidr_error_code;}
-            sdm_p_improve  =    m_last_adc_sample < result_curr;
-            
-            rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr-1)%16),(uint8_t)((zgn_val_curr+0)%16));
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, im grad test","",rfidr_error_code); return rfidr_error_code;}
-            sdm_n_improve  =    m_last_adc_sample < result_curr;
-            
-            rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr+0)%16),(uint8_t)((zgn_val_curr+1)%16));
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, qp grad test","",rfidr_error_code); return rfidr_error_code;}
-            zgn_p_improve  =    m_last_adc_sample < result_curr;
-            
-            rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr+0)%16),(uint8_t)((zgn_val_curr-1)%16));
-                if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, qm grad test","",rfidr_error_code); return rfidr_error_code;}
-            zgn_n_improve  =    m_last_adc_sample < result_curr;
-            
-            if(sdm_p_improve)
-                sdm_val_dir    =    1;
-            else if (sdm_n_improve)
-                sdm_val_dir    =    -1;
-            else
-                sdm_val_dir    =    0;
-            
-            if(zgn_p_improve)
-                zgn_val_dir    =    1;
-            else if (zgn_n_improve)
-                zgn_val_dir    =    -1;
-            else
-                zgn_val_dir    =    0;
-            
-            
-            if(sdm_val_dir == 0 && zgn_val_dir == 0)
-                break; //Break out of the loop. We've found the local minimum.
-            else
-            {
-                rfidr_error_code = tx_offset_calibration_core(p_rfidrs,(uint8_t)((sdm_val_curr+sdm_val_dir)%16),(uint8_t)((zgn_val_curr+zgn_val_dir)%16));
-                    if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, gradient reestablish","",rfidr_error_code); return rfidr_error_code;}
-
-                    result_curr    =    m_last_adc_sample;
-                    sdm_val_curr   =    (sdm_val_curr+sdm_val_dir)%16;
-                    zgn_val_curr   =    (zgn_val_curr+zgn_val_dir)%16;
-                    continue; //Move to the next iteration of the loop.
-                    //We assume that this operation did in fact reduce the error.
-            }
-        }
-    }
+static rfidr_error_t tx_offset_apply_channel(uint8_t frequency_slot)
+{
+    rfidr_txcal_result_t    tx_cal_result;
+    uint8_t                 sdm_offset                       =    0;
+    uint8_t                 zgn_offset                       =    0;
 
-    rfidr_disable_pa();
-    rfidr_error_code = set_tx_sdm_offset((uint8_t)(sdm_val_curr%16));
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, final set sdm offset","",rfidr_error_code); return rfidr_error_code;}
-    rfidr_error_code = set_tx_zgn_offset((uint8_t)(zgn_val_curr%16));
-        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tx cal, final set zgn offset","",rfidr_error_code); return rfidr_error_code;}
-    sprintf(short_message,"S:%02d Z:%02d O:%03d I:%02d",(uint8_t)(sdm_val_curr%16),(uint8_t)(sdm_val_curr%16),result_curr,iter_curr);
-    send_short_message(p_rfidrs, short_message);
+    if(rfidr_txcal_lookup(frequency_slot,&sdm_offset,&zgn_offset))
+        return set_tx_offsets(sdm_offset,zgn_offset);
 
-    return rfidr_error_code;
+    return tx_offset_calibration_channel(frequency_slot,&tx_cal_result);
 }
 
 //This function performs the core initialization routine as directed by the iDevice app.
@@ -538,6 +516,8 @@ static rfidr_error_t initialization_core(ble_rfidrs_t *p_rfidrs, char *error_inf
 {
     rfidr_error_t    rfidr_error_code                        =    RFIDR_SUCCESS;
     uint8_t          blank_epc[MAX_EPC_LENGTH_IN_BYTES]      =    {0};
+    char             short_message[20]                       =    {0};
+    rfidr_txcal_result_t    tx_cal_result;
     
     //GPIOTE is not initialized here but is initialized as part of the top level main entry
     //SPI MASTER is not initialized here but is initialized as part of the top level main entry
@@ -553,18 +533,28 @@ static rfidr_error_t initialization_core(ble_rfidrs_t *p_rfidrs, char *error_inf
     rfidr_reset_fpga();
     rfidr_reset_radio();    //was just enable the radio but it should come up already
     nrf_delay_ms(100);
+    //Find the fastest clean SPI clock before doing anything else over the link. If nothing passes, the link stays at the default 4MHz.
+    //If flash has the clock we found last time, just confirm it still works.
+    spi_cntrlr_clear_link_stats();
+    rfidr_error_code=rfidr_config_warm() ? spi_cntrlr_check_link(rfidr_config_spi_link_khz()) : RFIDR_ERROR_SPI_LINK;
+    if(rfidr_error_code != RFIDR_SUCCESS){rfidr_error_code=spi_cntrlr_train_link();}
+        if(rfidr_error_code != RFIDR_SUCCESS){send_log_message(p_rfidrs,"SPI link training failed, using 4MHz");}
+    sprintf(short_message,"SPI link: %4d kHz",(int)spi_cntrlr_read_link_freq_khz());
+    send_short_message(p_rfidrs, short_message);
     //rfidr_enable_xo();    //Maybe we don't actually want to be enabling the XO after the FPGA is pulled out of reset
     rfidr_txradio_init();    //This function sets up TX RADIO state variables within the MCU firmware.
     set_app_specd_target_epc(p_rfidrs,blank_epc,MAX_EPC_LENGTH_IN_BYTES);    //This function sets up a target EPC within the MCU firmware for SELECT-based tag SEARCH operations.
     set_app_specd_program_epc(p_rfidrs,blank_epc);    //This function sets up a new EPC for programming onto a tag during PROGRAM operations.
     rfidr_error_code=load_sx1257_default();    //This function sets up the registers in the SX1257. We try to shake around the PLL a bit to help it converge properly.
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"load sx1257 default",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+    //On the first initialization after power on, pick up the TX offsets and AGC gains kept in flash. The plan is in place now, so they line up with its channels.
+    if(rfidr_config_restore_tables()){send_log_message(p_rfidrs,"Restored calibration from flash");}
     rfidr_sel_ant0();    //Once again we default to ant0 on 11/21/19
     rfidr_error_code=load_rfidr_rxram_default(); //Load RX RAM. At this point, loading data consists of expected receive packet lengths.
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"load rfidr_rxram_default",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
     rfidr_error_code=load_rfidr_txram_default(); //Load TX RAM. This loads all of the default TX packet opcodes into the FPGA TX RAM.
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"load_rfidr_txram_default",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-    rfidr_error_code=set_sx1257_frequency(12);
+    rfidr_error_code=set_sx1257_frequency(rfidr_chplan_center_channel());
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"set frequency",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
     //Check that clk36 from the SX1257 is valid. This may be currently disabled to save LUT, as it never really failed.
     //If it is disabled, this may need to be revisited on account of seeming clk36-related initialization failures on the FPGA.
@@ -576,12 +566,20 @@ static rfidr_error_t initialization_core(ble_rfidrs_t *p_rfidrs, char *error_inf
     //check that clk36 is indeed running, wait a bit before we do this.
         if(!is_clk_36_running()){handle_error(p_rfidrs,error_info,"clk 36 not running",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
     //enable the irq - I don't think that we need to do this explicitly
-    rfidr_error_code = tx_offset_calibration_brute_force(p_rfidrs);
-    //rfidr_error_code = tx_offset_calibration_gradient(p_rfidrs);
+    //Calibrate on the channel we just tuned to. If we have been initialized before, this only checks around the offsets found then.
+    rfidr_disable_pa();
+    rfidr_error_code = tx_offset_calibration_channel(rfidr_chplan_center_channel(),&tx_cal_result);
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"tx offset cal",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+    sprintf(short_message,"CAL S%02d Z%02d O%04d",tx_cal_result.sdm_offset,tx_cal_result.zgn_offset,tx_cal_result.power);
+    send_short_message(p_rfidrs, short_message);
+    sprintf(short_message,"CAL points: %3d",tx_cal_result.num_points);
+    send_short_message(p_rfidrs, short_message);
     //set_tx_sdm_offset(5); //Set offsets for TX to maximize modulation depth of the reader TX waveforms.
     //set_tx_zgn_offset(10);
 
+    //Keep what we found for the next power on. Losing this only costs a cold start next time, so don't fail the initialization over it.
+    if(rfidr_config_save(spi_cntrlr_read_link_freq_khz()) != RFIDR_SUCCESS){send_log_message(p_rfidrs,"Could not save config to flash");}
+
 
     rfidr_enable_led1(); //Enabled LED1 to show that we are entering a configured state.
     send_log_message(p_rfidrs,"Initialization function complete!");
@@ -601,8 +599,13 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
     rfidr_error_t    rfidr_error_code                        =    RFIDR_SUCCESS;
     uint8_t          loop_iq                                 =    0;
     uint8_t          loop_load                               =    0;
+    uint8_t          lna_gain                                =    0xD4;
     char             short_message[20]                       =    {0};
 
+    //The dummy tag and the PLL check are wired in at a fixed level, so they stay at 0xD4. A real tag starts at the gain the AGC settled on for this channel.
+    if(target_epc == TARGET_APP_SPECD_EPC || target_epc == TARGET_LAST_INV_EPC)
+        lna_gain=rfidr_agc_gain(get_sx1257_frequency_slot());
+
     //Set return variable to default values
     
     return_struct->i_pass=false;
@@ -612,8 +615,8 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
         return_struct->i_epc[loop_load]=0;
         return_struct->q_epc[loop_load]=0;
     }
-    return_struct->i_lna_gain=0xD4;
-    return_struct->q_lna_gain=0xD4;
+    return_struct->i_lna_gain=lna_gain;
+    return_struct->q_lna_gain=lna_gain;
     return_struct->i_main_mag=0;
     return_struct->i_alt_mag=0;
     return_struct->q_main_mag=0;
@@ -686,7 +689,8 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
         //We also set the flag in the FPGA to use the select packet on the first packet to be sent out.
         rfidr_error_code=set_use_select_pkt();
             if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"setting select packet",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-        set_sx1257_lna_gain((uint8_t)(0xD4)); //Reset the gain
+        rfidr_error_code=set_sx1257_lna_gain(lna_gain); //Reset the gain
+            if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"setting lna gain",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
         
         //Set the FPGA IRQ flag to false so that we can wait for it.
         m_received_irq_flag    =    false;
@@ -717,7 +721,8 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
                 if(return_epc==RETURN_EPC_YES)
                 {
                     rfidr_error_code=rfidr_read_epc(return_struct->i_epc,(target_epc==TARGET_PLL_EPC) ? READ_RXRAM_PLLCHECK : READ_RXRAM_REGULAR);
-                        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"checking I EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        if(rfidr_error_code == RFIDR_ERROR_EPC_CRC){send_short_message(p_rfidrs, "Search I CRC Fail"); return_struct->i_pass=false;}
+                        else if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"checking I EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                 }
                 if(return_mag==RETURN_MAG_YES)
                 {
@@ -745,7 +750,8 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
                 if(return_epc==RETURN_EPC_YES)
                 {
                     rfidr_error_code=rfidr_read_epc(return_struct->q_epc,(target_epc==TARGET_PLL_EPC) ? READ_RXRAM_PLLCHECK : READ_RXRAM_REGULAR);
-                        if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"checking Q EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        if(rfidr_error_code == RFIDR_ERROR_EPC_CRC){send_short_message(p_rfidrs, "Search Q CRC Fail"); return_struct->q_pass=false;}
+                        else if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"checking Q EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                 }
                 if(return_mag==RETURN_MAG_YES)
                 {
@@ -785,6 +791,43 @@ static rfidr_error_t search_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfidr
     return rfidr_error_code;
 } // static void search_core
 
+//Move an inventory round that is running out of dwell time to a channel that has some to spare.
+//Dropping the PA powers the tags down and ends the round, so we start a fresh Query on the new channel.
+//In S2 and S3, tags that have already been inventoried keep their B flag through the gap and stay quiet.
+//If every channel is used up, the PA stays off and we wait for the oldest transmit time to leave the dwell window.
+static rfidr_error_t hop_for_dwell(uint8_t *p_frequency_slot, uint16_t guard_ms)
+{
+    #define    DWELL_WAIT_MS    10
+
+    rfidr_error_t    rfidr_error_code    =    RFIDR_SUCCESS;
+    uint8_t          loop_hop            =    0;
+    uint8_t          sdm_offset          =    0;
+    uint8_t          zgn_offset          =    0;
+
+    rfidr_error_code=rfidr_disable_pa();
+    if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
+
+    while(rfidr_dwell_remaining_ms() < guard_ms)
+    {
+        if(loop_hop++ >= rfidr_chplan_num_channels()){nrf_delay_ms(DWELL_WAIT_MS); loop_hop=0;}
+
+        rfidr_error_code=hop_sx1257_frequency(p_frequency_slot); m_hopskip_nonce++;
+        if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
+    }
+
+    //Only use offsets we already have. Calibrating here would spend the transmit time we just hopped to get.
+    if(rfidr_txcal_lookup(*p_frequency_slot,&sdm_offset,&zgn_offset))
+    {
+        rfidr_error_code=set_tx_offsets(sdm_offset,zgn_offset);
+        if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
+    }
+
+    rfidr_error_code=rfidr_enable_pa();
+    if(rfidr_error_code != RFIDR_SUCCESS){return rfidr_error_code;}
+
+    return set_alt_radio_fsm_loop();
+}
+
 static rfidr_error_t end_inventory(ble_rfidrs_t *p_rfidrs, char *error_info)
 {
     rfidr_error_t    rfidr_error_code    =    RFIDR_SUCCESS;
@@ -823,7 +866,9 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
     //In general, we'll be using Session S2 or S3 so that we can power down the PA and frequency hop in between query rounds.
 
     #define    QUERY_ROUND_LIMIT    36    //Somewhat arbitrary
-    #define    MAX_QUERY_Q          6    //We want to limit this to limit frequency dwell time so we don't have to hop in the middle of a query round.
+    #define    MAX_QUERY_Q          15   //The Gen2 maximum. Dwell time is now policed by rfidr_dwell.c, which hops in the middle of a query round if it has to.
+    #define    INV_DWELL_GUARD_MS   40   //Hop once the channel has less than this left, enough for one slot including a tag read and BTLE indication.
+    #define    INV_SLOT_MS          2    //Rough length of one slot with the PA on, used to cap Q below.
 
     rfidr_error_t            rfidr_error_code          =    RFIDR_SUCCESS;    //An output error code.
     uint8_t                  loop_query_q              =    0;                //Loop iteration value between query rounds.
@@ -832,11 +877,14 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
     uint16_t                 loop_q_iter               =    0;                //Loop iteration variable for within the query round.
     uint8_t                  q_value                   =    0;                //Create a variable to hold the current value of Query Q so that we can take clear steps to sanitize it.
     uint8_t                  recover_frequency_slot    =    0;                //A variable to fish out what frequency slot we hopped to in rfidr_sx1257.c.
+    uint8_t                  lna_gain                  =    0xD4;             //The LNA gain rfidr_agc.c picked for the channel we are on.
     uint8_t                  epc1_length_in_bytes      =    0;                //Variable to fish out what the application specified EPC length is.
     //uint8_t                epc2_length_in_bytes      =    0;                //Variable to fish out what the software-specified EPC length is.
     char                     short_message[20]         =    {0};              //An array to hold a short message to be sent back to the iDevice.
     bool                     query_adj_burn_flag       =    false;            //We demo the Query Adjacent packet here by using it once. This flag lets us just do it once.
     rfidr_select_target_t    target                    =    TARGET_S2;        //The session flag to be targeted by the select packet.
+    rfidr_tag_record_t       tag_record;                                      //Everything the FPGA recovered from the last singulated tag.
+    rfidr_tag_update_t       tag_update                =    TAG_TABLE_NEW;    //Whether the last tag read told us anything new.
         
     m_num_inv_tags_found                               =    0;                //Use a state variable for this now, so that other functions can use the info.
 
@@ -862,6 +910,9 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
     set_query_sel(SEL_PSL);          //121320 - We'll check for select flag to ensure exclusivity of this inventory test.
     set_query_session(session);      //Query packet will target the session specified by the calling function. //No possible error, so don't check.
     set_query_target(TARGET_A);      //Query packet will target flags with their session flag set to A. //No possible error, so don't check.
+    prepare_query_packet();          //Compute the fixed part of the query packet up front, so that each Q change below only patches a few TX RAM bytes.
+    rfidr_packed_report_reset();     //The iDevice starts a fresh EPC dictionary with each inventory. //No possible error, so don't check.
+    rfidr_tag_table_reset();         //Likewise, every tag is new again. //No possible error, so don't check.
 
     //Load a select packet into the FPGA TX RAM with an EPC that we want to act as a select mask.
     //In other words, all of the packets with this tag EPC value will have their session flags set to "A" and all others will have the flags set to "B".
@@ -902,7 +953,7 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
     rfidr_error_code=set_use_select_pkt();
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"setting select packet",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
-    set_sx1257_lna_gain((uint8_t)(0xD4));    //Reset the LNA gain. Not sure if we want it here or within the I/Q loop below as of 120719.
+    //The LNA gain is set per query round from rfidr_agc.c once we know which channel the round is on.
 
     //Set query q and load the appropriate query packet. This needs to be done each time Q is changed.
     //We dynamically check the length of the Q vector instead of hard coding it by waiting for the NULL (0) character in the Q vector string.
@@ -918,13 +969,23 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
         //We need to hop frequencies on a regular basis to comply with FCC section 15.247.
         //We can't transmit on a given frequency for greater than 0.4s in a 10 second period.
         //Each query rep interval lasts about 2ms and during this time we have the PA on almost the whole time.
-        //Given that we should not hop between I and Q variants (we want to search both I and Q for a given frequency),
-        //we really need to set Q <= 6. In addition, we need to try having the PA on only when absolutely necessary for RFID traffic.
+        //We used to cap Q at 6 so that a round would always fit in one dwell. Now we hop at the start of each round for frequency diversity,
+        //and rfidr_dwell.c tells us within the round if the channel is running out of transmit time.
+        //In addition, we need to try having the PA on only when absolutely necessary for RFID traffic.
         //In other words, turn off the PA for BTLE transfers and moving data off of the FPGA.
         
-        rfidr_error_code=set_query_q(q_value);                    //Make sure we convert Q to an integer only value less than 16.
         rfidr_error_code=hop_sx1257_frequency(&recover_frequency_slot); m_hopskip_nonce++;
             if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"hopping frequency",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+        //A hop in the middle of a round starts the round over, so a round which cannot fit in one channel's dwell limit would never finish.
+        //Cap Q to what the plan we just hopped on allows. This also bounds a round if the dwell accounting ever goes wrong.
+        while(q_value > 0 && (((uint32_t)1 << q_value)+1)*INV_SLOT_MS > (uint32_t)(rfidr_chplan_max_dwell_ms()-INV_DWELL_GUARD_MS)){q_value--;}
+        rfidr_error_code=set_query_q(q_value);                    //Make sure we convert Q to an integer only value less than 16.
+            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"setting query q",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+        lna_gain=rfidr_agc_gain(recover_frequency_slot);
+        rfidr_error_code=set_sx1257_lna_gain(lna_gain);            //Start the round at the gain this channel settled on last time.
+            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"setting lna gain",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+        rfidr_error_code=tx_offset_apply_channel(recover_frequency_slot);    //The PA is still off here, so a new channel can be calibrated.
+            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"tx offset cal",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
         rfidr_error_code=load_query_packet_only(FLAGSWAP_NO);
             if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"loading query",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
@@ -958,6 +1019,18 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
             {   //The <= is to ensure no tag backscatters RN16 again at a query.
                 //set_sx1257_lna_gain((uint8_t)(0xD4)); //Don't reset the LNA gain. The idea is that convergence won't change a whole lot in between rounds.
 
+                //If this channel can't fit another slot, restart the round on one that can.
+                if(rfidr_dwell_remaining_ms() < INV_DWELL_GUARD_MS)
+                {
+                    rfidr_agc_end_round(recover_frequency_slot);    //What we saw so far was on the old channel.
+                    rfidr_error_code=hop_for_dwell(&recover_frequency_slot,INV_DWELL_GUARD_MS);
+                        if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"hopping for dwell time",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                    lna_gain=rfidr_agc_gain(recover_frequency_slot);
+                    rfidr_error_code=set_sx1257_lna_gain(lna_gain);
+                        if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"setting lna gain",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                    loop_q_iter=0;
+                }
+
                 //Set the FPGA IRQ flag to false so we can wait for the IRQ.
                 m_received_irq_flag    =    false;
                 //Now that the FPGA is loaded with settings and commands, tell it to execute those commands.
@@ -982,9 +1055,6 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
                 //When the FPGA state machine gets another "go_radio" it will start executing again.
                 if(read_radio_exit_code()==0)
                 {
-                    m_num_inv_tags_found++;
-                        if(m_num_inv_tags_found >= max_tags){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"inventoried more than max # tags",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                    
                     return_struct->i_pass=false;
                     return_struct->q_pass=false;
                     for(loop_load=0; loop_load < MAX_EPC_LENGTH_IN_BYTES; loop_load++)
@@ -992,8 +1062,8 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
                         return_struct->i_epc[loop_load]=0;
                         return_struct->q_epc[loop_load]=0;
                     }
-                    return_struct->i_lna_gain=0xD4;
-                    return_struct->q_lna_gain=0xD4;
+                    return_struct->i_lna_gain=lna_gain;         //Lets RSSI refer the magnitudes back to the 0xD4 gain everything else uses.
+                    return_struct->q_lna_gain=lna_gain;
                     return_struct->i_main_mag=0;
                     return_struct->i_alt_mag=0;
                     return_struct->q_main_mag=0;
@@ -1001,33 +1071,53 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
                     
                     if(loop_iq==0)
                     {
-                        return_struct->i_pass=true;
-                        rfidr_error_code=rfidr_read_epc(return_struct->i_epc,READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                        rfidr_error_code=set_last_inv_epc(return_struct->i_epc);
+                        rfidr_error_code=rfidr_read_tag_record(&tag_record,READ_RXRAM_REGULAR);
+                            if(rfidr_error_code != RFIDR_SUCCESS && rfidr_error_code != RFIDR_ERROR_EPC_CRC){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"reading I tag record", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        rfidr_agc_observe(&tag_record);                //Failed decodes count too - they tell the AGC the gain is off.
+                        return_struct->i_pass=tag_record.crc_pass;    //A corrupt reply is dropped, not reported.
+                        memcpy(return_struct->i_epc,tag_record.epc,MAX_EPC_LENGTH_IN_BYTES);
+                        return_struct->i_main_mag=tag_record.main_mag;
+                        return_struct->i_alt_mag=tag_record.alt_mag;
+                        if(return_struct->i_pass)
+                            rfidr_error_code=set_last_inv_epc(return_struct->i_epc);
                             //There should be no error here, since this is strictly an MCU internal operation.
-                        rfidr_error_code=rfidr_read_main_magnitude(&(return_struct->i_main_mag),READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I - Main Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                        rfidr_error_code=rfidr_read_alt_magnitude(&(return_struct->i_alt_mag),READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I - Alt Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                     }
                     else
                     {
-                        return_struct->q_pass=true;
-                        rfidr_error_code=rfidr_read_epc(return_struct->q_epc,READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                        rfidr_error_code=set_last_inv_epc(return_struct->q_epc);
-                                //There should be no error here, since this is strictly an MCU internal operation.
-                        rfidr_error_code=rfidr_read_main_magnitude(&(return_struct->q_main_mag),READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q - Main Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                        rfidr_error_code=rfidr_read_alt_magnitude(&(return_struct->q_alt_mag),READ_RXRAM_REGULAR);
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q - Alt Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        rfidr_error_code=rfidr_read_tag_record(&tag_record,READ_RXRAM_REGULAR);
+                            if(rfidr_error_code != RFIDR_SUCCESS && rfidr_error_code != RFIDR_ERROR_EPC_CRC){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"reading Q tag record", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        rfidr_agc_observe(&tag_record);
+                        return_struct->q_pass=tag_record.crc_pass;    //A corrupt reply is dropped, not reported.
+                        memcpy(return_struct->q_epc,tag_record.epc,MAX_EPC_LENGTH_IN_BYTES);
+                        return_struct->q_main_mag=tag_record.main_mag;
+                        return_struct->q_alt_mag=tag_record.alt_mag;
+                        if(return_struct->q_pass)
+                            rfidr_error_code=set_last_inv_epc(return_struct->q_epc);
+                            //There should be no error here, since this is strictly an MCU internal operation.
                     }
                     
-                    m_received_hvc_pckt_data1_flag            =    false;
-                    rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct,return_struct,recover_frequency_slot,255,m_hopskip_nonce,BLE_PUSH_MINIMAL);
-                        if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"pushing pckt data over ble",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                    while(m_received_hvc_pckt_data1_flag == false){}
+                    //Only spend a BLE indication on the tag if its PC+EPC passed the CRC-16 check.
+                    //m_num_inv_tags_found counts different tags, not reads, so that tracking can size its query rounds to the tag population.
+                    if(return_struct->i_pass || return_struct->q_pass)
+                    {
+                        tag_update=rfidr_tag_table_update(return_struct,recover_frequency_slot);
+                        m_num_inv_tags_found=rfidr_tag_table_unique_count();
+
+                        if(!m_dedup_reports_flag || tag_update != TAG_TABLE_UNCHANGED)
+                        {
+                            if(m_packed_reports_flag)
+                            {
+                                rfidr_error_code=rfidr_push_packed_data_over_ble(p_rfidrs,return_struct,recover_frequency_slot);
+                            }
+                            else
+                            {
+                                rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct,return_struct,recover_frequency_slot,255,m_hopskip_nonce,BLE_PUSH_MINIMAL);
+                            }
+                                if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"pushing pckt data over ble",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                        }
+
+                        if(m_num_inv_tags_found >= max_tags){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"inventoried more than max # tags",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                    }
                 }
 
                 //If we've just transmitted a Query Adjust packet, reload the Query Rep TX RADIO RAM with a regular Query Rep packet and continue.
@@ -1042,12 +1132,32 @@ static rfidr_error_t inventory_core(ble_rfidrs_t *p_rfidrs, char *error_info, rf
         //Disable PA. Can't have too many of these, but PA enable/disable should move within the innermost loop to not leave PA on needlessly during BTLE and SPI transfers.
         rfidr_error_code=rfidr_disable_pa();
         if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"disabling pa: ",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+
+        //Let the AGC decide on this channel's gain for next time from how the I and Q passes went. //No possible error, so don't check.
+        rfidr_agc_end_round(recover_frequency_slot);
+
+        //Don't sit on a partly filled packed report past the end of the query round.
+        if(m_packed_reports_flag)
+        {
+            rfidr_error_code=rfidr_packed_report_flush(p_rfidrs);
+            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"pushing pckt data over ble",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+        }
+
+        //When repeat reads are being suppressed, let the iDevice know how busy the reader has been once per query round.
+        if(m_dedup_reports_flag)
+        {
+            sprintf(short_message,"Tags%03d Reads%05d",(int)(m_num_inv_tags_found % 1000),(int)(rfidr_tag_table_total_reads() % 100000));
+            send_short_message(p_rfidrs, short_message);
+        }
         
     } //for loop_query_q
     
     rfidr_error_code=end_inventory(p_rfidrs,"End Inv.");
         if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"ending inventory",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
+    //Inventory calibrates channels as it first hops to them, so save those for the next power on.
+    if(rfidr_config_save(spi_cntrlr_read_link_freq_khz()) != RFIDR_SUCCESS){send_log_message(p_rfidrs,"Could not save config to flash");}
+
     rfidr_enable_led1(); //Stop LED toggling
 
     //Finally report the number of tags we found. iDevice software will report how long it took to find them.
@@ -1098,6 +1208,8 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
     uint8_t                  q_value                                       =    0;        //What is the query Q value for a given query round, in bytes.
     uint8_t                  recover_frequency_slot                        =    0;        //A variable to fish out what frequency slot we hopped to in rfidr_sx1257.c.
     uint8_t                  skip_frequency_slot                           =    0;        //A variable to hold what frequency we will skip to for PDOA ranging.
+    uint8_t                  agc_frequency_slot                            =    0;        //The slot we are tracking on after the hop or skip, whose gain rfidr_agc.c keeps.
+    uint8_t                  lna_gain                                      =    0xD4;     //The LNA gain rfidr_agc.c picked for that slot.
     uint8_t                  epc_length_in_bytes                           =    0;        //Variable to fish out what the application specified EPC length is.
     uint8_t                  session_flag_flip_limit                       =    1;        //Flip the session flag after these numbers of tags have been found.
     uint8_t                  num_tracked_tags_found                        =    0;        //Track how many successes we are having. When we have enough, flip the session flag target.
@@ -1107,6 +1219,8 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
                                                                                 //This is not robust coding practice, but will speed up tags reads for the current UM goals.
     char                    short_message[20]                              =    {0};    //An array to hole a short message back to the iDevice.
     rfidr_select_target_t    target                                        =    TARGET_S0;
+    rfidr_tag_record_t       tag_record;                                            //Everything the FPGA recovered from the last singulated tag.
+    rfidr_pdoa_range_t       pdoa_range;                                            //Range of a tag worked out from its hop and skip reads.
 
     //EPC values of less than or equal to 12 bytes can be used here.
     //EPC values of greater than 12 bytes will be truncated by the called function.
@@ -1118,6 +1232,7 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
     //Note that the inventory core function natively searches for the app-specd EPC.
 
     rfidr_sel_ant0(); //Switch to ant0 in order to use the main antenna for operations on actual tags.
+    rfidr_pdoa_reset(); //Forget hop reads left over from the last time we tracked.
 
     if(mode == TRACK_APP_SPECD)
     {
@@ -1210,15 +1325,11 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
             }
             else    //Now we frequency skip.
             {
-                if(recover_frequency_slot >= 22)    //If we are at the uppermost edge of the frequency band, we can't hop 'up'.
-                    skip_frequency_slot = recover_frequency_slot-(3-loop_cal_fails_outer);     //So we hop 3 down instead.
-                    //This will result in slots 22, 23, 24 being unfairly weighted, so we'll need a better algorithm later if we want FCC certification.
-                    //If we are failing at the skip frequency, we need to try another nearby frequency.
-                    //App software should handle the different hop/skip delta frequency.
-                else
-                    skip_frequency_slot = recover_frequency_slot+(3-loop_cal_fails_outer);    //In general, we will skip by moving to the next third highest frequency slot.
-                    //If we are failing at the skip frequency, we need to try another nearby frequency.
-                    //App software should handle the different hop/skip delta frequency.
+                //In general, we will skip by moving to the next third highest channel, or the third lowest if we are at the uppermost edge of the channel plan.
+                //This will result in the top channels being unfairly weighted, so we'll need a better algorithm later if we want FCC certification.
+                //If we are failing at the skip frequency, we need to try another nearby frequency.
+                //App software should handle the different hop/skip delta frequency.
+                skip_frequency_slot = rfidr_chplan_skip_channel(recover_frequency_slot,3-loop_cal_fails_outer);
 
                 rfidr_error_code=set_sx1257_frequency(skip_frequency_slot);    //Set the frequency slot.
                     if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"skipping frequency",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
@@ -1233,7 +1344,7 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
             //so in that case it should never fail.
             for(loop_cal_fails_inner=0; loop_cal_fails_inner < NUM_ALLOWED_INNER_CAL_FAILS; loop_cal_fails_inner++)
             {
-                rfidr_error_code=search_core(p_rfidrs, "track-searching", SESSION_S0, TARGET_CAL_EPC, RETURN_EPC_NO, RETURN_MAG_YES, RETURN_LNA_GAIN_NO, return_struct_cal);
+                rfidr_error_code=search_core(p_rfidrs, "track-searching", SESSION_S0, TARGET_CAL_EPC, RETURN_EPC_NO, RETURN_MAG_YES, RETURN_LNA_GAIN_YES, return_struct_cal);    //PDOA needs the gain of the cal read to refer its magnitudes back.
                     if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"PDOA cal",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
                 if(return_struct_cal->i_pass == true || return_struct_cal->q_pass == true){break;} //If we passed search, break the loop.
@@ -1285,6 +1396,7 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
         set_query_session(session);      //Query packet will target the session specified by the calling function. //No possible error, so don't check.
         set_query_target(TARGET_A);      //Query packet will target flags with their session flag set to A. //No possible error, so don't check.
         set_query_q(0);                  //Set query q to a fixed value for now, this will be overwritten later.
+        prepare_query_packet();          //Compute the fixed part of the query packet up front, so that each Q change below only patches a few TX RAM bytes.
         query_a_flag = true;             //Set this to true to initialize this at the beginning of every loop.
 
         //Load a full query packet
@@ -1340,7 +1452,11 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
         rfidr_error_code=set_use_select_pkt();
             if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"setting select packet",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
-        set_sx1257_lna_gain((uint8_t)(0xD4));                     //Reset the LNA gain. Not sure if we want it here or within the I/Q loop below as of 120719.
+        //Start at the gain this slot settled on last time. The calibration search above ran at 0xD4.
+        agc_frequency_slot=get_sx1257_frequency_slot();
+        lna_gain=rfidr_agc_gain(agc_frequency_slot);
+        rfidr_error_code=set_sx1257_lna_gain(lna_gain);
+            if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,error_info,"setting lna gain",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
         //Set query q and load the appropriate query packet. This needs to be done each time Q is changed.
         //In this case, we want to set Q to be consistent with the number of tags from the last inventory.
@@ -1423,8 +1539,8 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
                             return_struct_ant->i_epc[loop_load]=0;
                             return_struct_ant->q_epc[loop_load]=0;
                         }
-                        return_struct_ant->i_lna_gain=0xD4;
-                        return_struct_ant->q_lna_gain=0xD4;
+                        return_struct_ant->i_lna_gain=lna_gain;
+                        return_struct_ant->q_lna_gain=lna_gain;
                         return_struct_ant->i_main_mag=0;
                         return_struct_ant->i_alt_mag=0;
                         return_struct_ant->q_main_mag=0;
@@ -1432,41 +1548,60 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
 
                         if(loop_iq==0)
                         {
-                                return_struct_ant->i_pass=true;
-                                rfidr_error_code=rfidr_read_epc(return_struct_ant->i_epc,READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                                rfidr_error_code=rfidr_read_main_magnitude(&(return_struct_ant->i_main_mag),READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I - Main Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                                rfidr_error_code=rfidr_read_alt_magnitude(&(return_struct_ant->i_alt_mag),READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking I - Alt Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                                rfidr_error_code=rfidr_read_tag_record(&tag_record,READ_RXRAM_REGULAR);
+                                    if(rfidr_error_code != RFIDR_SUCCESS && rfidr_error_code != RFIDR_ERROR_EPC_CRC){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"reading I tag record", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                                rfidr_agc_observe(&tag_record);                   //Failed decodes count too - they tell the AGC the gain is off.
+                                return_struct_ant->i_pass=tag_record.crc_pass;    //A corrupt reply is dropped, not reported.
+                                memcpy(return_struct_ant->i_epc,tag_record.epc,MAX_EPC_LENGTH_IN_BYTES);
+                                return_struct_ant->i_main_mag=tag_record.main_mag;
+                                return_struct_ant->i_alt_mag=tag_record.alt_mag;
+                                rfidr_error_code=get_sx1257_lna_gain(&(return_struct_ant->i_lna_gain));    //The gain the read was actually taken at, for RSSI and PDOA confidence.
+                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"getting I LNA gain", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                             }
                             else
                             {
-                                return_struct_ant->q_pass=true;
-                                rfidr_error_code=rfidr_read_epc(return_struct_ant->q_epc,READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q EPC", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                                rfidr_error_code=rfidr_read_main_magnitude(&(return_struct_ant->q_main_mag),READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q - Main Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                                rfidr_error_code=rfidr_read_alt_magnitude(&(return_struct_ant->q_alt_mag),READ_RXRAM_REGULAR);
-                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"checking Q - Alt Mag",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                                rfidr_error_code=rfidr_read_tag_record(&tag_record,READ_RXRAM_REGULAR);
+                                    if(rfidr_error_code != RFIDR_SUCCESS && rfidr_error_code != RFIDR_ERROR_EPC_CRC){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"reading Q tag record", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                                rfidr_agc_observe(&tag_record);
+                                return_struct_ant->q_pass=tag_record.crc_pass;    //A corrupt reply is dropped, not reported.
+                                memcpy(return_struct_ant->q_epc,tag_record.epc,MAX_EPC_LENGTH_IN_BYTES);
+                                return_struct_ant->q_main_mag=tag_record.main_mag;
+                                return_struct_ant->q_alt_mag=tag_record.alt_mag;
+                                rfidr_error_code=get_sx1257_lna_gain(&(return_struct_ant->q_lna_gain));
+                                    if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"getting Q LNA gain", rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                             }
 
-                            m_received_hvc_pckt_data1_flag            =    false;
-                            //We need to tell the iDevice whether the data being sent over corresponds to a hop (first PDOA value) or a skip (second PDOA value).
-                            //Note that if we are getting data from a frequency hop, the skip flag is "true" because the next time around it will
-                            //be time to skip.
-                            
-                            if(frequency_skip_flag == true) //Remember if we are at a hop we will have already set this flag to true
-                            {
-                                rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct_ant,return_struct_cal,recover_frequency_slot,255,m_hopskip_nonce,BLE_PUSH_SUPPLEMENT);
-                            }
-                            else
+                            //The tag's flag has been flipped either way, but only spend a BLE indication on it if its PC+EPC passed the CRC-16 check.
+                            if(return_struct_ant->i_pass || return_struct_ant->q_pass)
                             {
-                                rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct_ant,return_struct_cal,skip_frequency_slot,loop_cal_fails_outer,m_hopskip_nonce,BLE_PUSH_SUPPLEMENT);
+                                //We need to tell the iDevice whether the data being sent over corresponds to a hop (first PDOA value) or a skip (second PDOA value).
+                                //Note that if we are getting data from a frequency hop, the skip flag is "true" because the next time around it will
+                                //be time to skip.
+                                
+                                if(m_range_reports_flag)
+                                {
+                                    //If the iDevice wants ranges, the hop read is only remembered, and the skip read is turned into a range with it.
+                                    //A read with no partner (the tag was missed at the hop, or the table was full) is simply dropped.
+                                    if(frequency_skip_flag == true)
+                                    {
+                                        rfidr_pdoa_store_hop(return_struct_ant,return_struct_cal,recover_frequency_slot,m_hopskip_nonce);
+                                    }
+                                    else if(rfidr_pdoa_compute_range(return_struct_ant,return_struct_cal,skip_frequency_slot,m_hopskip_nonce,&pdoa_range) == RFIDR_SUCCESS)
+                                    {
+                                        rfidr_error_code=rfidr_push_range_over_ble(p_rfidrs,return_struct_ant,pdoa_range.range,pdoa_range.confidence);
+                                    }
+                                }
+                                else if(frequency_skip_flag == true) //Remember if we are at a hop we will have already set this flag to true
+                                {
+                                    rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct_ant,return_struct_cal,recover_frequency_slot,255,m_hopskip_nonce,BLE_PUSH_SUPPLEMENT);
+                                }
+                                else
+                                {
+                                    rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,return_struct_ant,return_struct_cal,skip_frequency_slot,loop_cal_fails_outer,m_hopskip_nonce,BLE_PUSH_SUPPLEMENT);
+                                }
+
+                                if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"pushing pckt data over ble",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
                             }
-
-                            if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"pushing pckt data over ble",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
-                            while(m_received_hvc_pckt_data1_flag == false){}
                         }
 
                     } //for loop_q_iter
@@ -1495,6 +1630,14 @@ static rfidr_error_t tracking_core(ble_rfidrs_t *p_rfidrs, char *error_info, rfi
                 rfidr_error_code=rfidr_disable_pa();
                 if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"disabling pa: ",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
 
+                //Let the AGC step this slot's gain from how the I and Q passes went. The PA is off, so the next round can start at the new gain.
+                if(rfidr_agc_end_round(agc_frequency_slot))
+                {
+                    lna_gain=rfidr_agc_gain(agc_frequency_slot);
+                    rfidr_error_code=set_sx1257_lna_gain(lna_gain);
+                        if(rfidr_error_code != RFIDR_SUCCESS){end_inventory(p_rfidrs,"End Inv."); handle_error(p_rfidrs,error_info,"setting lna gain",rfidr_error_code); return RFIDR_ERROR_GENERAL;}
+                }
+
             } //for loop_query_q
 
         //Need to end inventory so that we can do search after we hop frequencies.
@@ -1705,6 +1848,8 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
     rfidr_tracking_mode_t    tracking_mode                           =    TRACK_LAST_INV;
 
     m_rfidr_state=m_rfidr_state_next;
+    clear_tx_ram_shadow_stats();
+    clear_sx1257_shadow_stats();
 
     switch(m_rfidr_state)
     {
@@ -1853,18 +1998,16 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
             sprintf(short_message,"FreqSlot1: %3d",(int)recover_frequency_slot);
                     send_short_message(p_rfidrs, short_message);
 
-            m_received_hvc_pckt_data1_flag            =    false;
             rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,&return_struct_ant,&return_struct_cal,recover_frequency_slot,255,m_hopskip_nonce,BLE_PUSH_SUPPLEMENT);
                 if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"searching, pushing first run pckt data over ble","",rfidr_error_code); break;}
-            while(m_received_hvc_pckt_data1_flag == false){}
 
             //Fifth, if the last run passed, we run a small loop where we check adjacent frequencies so that we can run PDOA.
             //For the moment we will only hop +/- 1MHz (1 code) from the frequency we just hopped to.
             //In order to resolve distances up to 25 meters, we can only hop up to 1.5MHz in this step, otherwise we will get ranging aliasing.
 
             if(recover_frequency_slot<3)
-                search_hop_vector[0]=recover_frequency_slot+3;    //Only hop 3 frequencies up - we are not allowed to hop one frequency down
-            else if (recover_frequency_slot>21)
+                search_hop_vector[0]=rfidr_chplan_skip_channel(recover_frequency_slot,3);    //Only hop 3 frequencies up - we are not allowed to hop one frequency down
+            else if (recover_frequency_slot+3 >= rfidr_chplan_num_channels())
                 search_hop_vector[0]=recover_frequency_slot-3;    //Only hop 3 frequencies down - we are not allowed to hop one frequency up
             else
             {
@@ -1873,9 +2016,9 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
             }
 
             //Here, we try to obtain tag reads at frequencies adjacent to the original one so that we can perform PDOA without distance aliasing up to a bit more than 25 meters.
-            //Use for loop instead of while so that the first and last successful loop hop can be saved. We use 255 as a sentinel value in search_hop_vector but anything over 24 is invalid so we test against that.
-            //Note that while in principle we can center 26 1MHz channels from 902.5MHz to 927.5MHz, we chose 25 channels in rfidr_sx1257.c.
-            for(loop_hop=0;search_hop_vector[loop_hop] < 25;loop_hop++)
+            //Use for loop instead of while so that the first and last successful loop hop can be saved. We use 255 as a sentinel value in search_hop_vector but anything past the last channel of the plan is invalid so we test against that.
+            //Note that while in principle we can center 26 1MHz channels from 902.5MHz to 927.5MHz, we chose 25 channels for the default plan in rfidr_chplan.c.
+            for(loop_hop=0;search_hop_vector[loop_hop] < rfidr_chplan_num_channels();loop_hop++)
             {
                 return_struct_cal.i_pass =  return_struct_cal.q_pass = return_struct_ant.i_pass =  return_struct_ant.q_pass = false; //Set these so that we fail through if we don't get a pass value.
 
@@ -1920,12 +2063,12 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
                 sprintf(short_message,"FreqSlot2: %3d",(int)search_hop_vector[loop_hop]);
                 send_short_message(p_rfidrs, short_message);
 
-                m_received_hvc_pckt_data1_flag            =    false;
                 rfidr_error_code=rfidr_push_data_over_ble(p_rfidrs,&return_struct_ant,&return_struct_cal,search_hop_vector[loop_hop],loop_hop, m_hopskip_nonce, BLE_PUSH_SUPPLEMENT);
                 if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"searching, pushing second run pckt data over ble","",rfidr_error_code); break;}
-                while(m_received_hvc_pckt_data1_flag == false){}
             }
 
+            report_shadow_stats(p_rfidrs);
+
             //Next state is IDLE_CONFIGURED, transition automatically and immediately.
             m_rfidr_state_next=IDLE_CONFIGURED;
             m_rfidr_state=IDLE_CONFIGURED;
@@ -1947,6 +2090,8 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
             //We need to power down the PA while we are doing SPI and BTLE operations without losing tag inventory flag state.
 
                 if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"inventorying, error within inventory_core","",rfidr_error_code); break;}
+
+            report_shadow_stats(p_rfidrs);
             //Change state back to IDLE_CONFIGURED and report this to the iDevice with an indication.
             m_rfidr_state_next=IDLE_CONFIGURED;
             m_rfidr_state=IDLE_CONFIGURED;
@@ -1971,6 +2116,8 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
             rfidr_error_code=tracking_core(p_rfidrs, "tracking", SESSION_S2, tracking_mode, &return_struct_ant, &return_struct_cal);
 
                 if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"tracking state, error within tracking_core","",rfidr_error_code); break;}
+
+            report_shadow_stats(p_rfidrs);
             //Change state back to IDLE_CONFIGURED and report this to the iDevice with an indication.
             m_rfidr_state_next=IDLE_CONFIGURED;
             m_rfidr_state=IDLE_CONFIGURED;
@@ -2087,6 +2234,8 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
             rfidr_error_code=program_core(p_rfidrs, "programming", SESSION_S0, m_rfidr_state==PROGRAMMING_LAST_INV_TAG ? TARGET_LAST_INV_EPC : TARGET_APP_SPECD_EPC, content, &return_struct_ant);
                 if(rfidr_error_code != RFIDR_SUCCESS){handle_error(p_rfidrs,"programming, error at programming","",rfidr_error_code); break;}
 
+            report_shadow_stats(p_rfidrs);
+
             m_rfidr_state_next=IDLE_CONFIGURED;
             m_rfidr_state=IDLE_CONFIGURED;
 
@@ -2118,6 +2267,7 @@ void run_rfidr_state_machine(ble_rfidrs_t *p_rfidrs)
 
             rfidr_reset_fpga();
             rfidr_reset_radio();    //These always return success, so don't check them
+            invalidate_tx_ram_shadow();    //The FPGA reset wiped the TX RAM.
 
             rfidr_error_code=spi_cntrlr_read_sx1257_robust(0x11, &spi_return_byte); //Changed to 2-argument version on 5/23/19 to clean up code
             if(rfidr_error_code == RFIDR_SUCCESS)
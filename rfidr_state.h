@@ -105,7 +105,11 @@ void        rfidr_state_received_irq(void);
 
 void        rfidr_state_received_read_state_confirmation(void);
 
-void        rfidr_state_received_pckt_data1_confirmation(void);
+void        rfidr_state_set_packed_reports(bool packed_reports);
+
+void        rfidr_state_set_dedup_reports(bool dedup_reports);
+
+void        rfidr_state_set_range_reports(bool range_reports);
 
 uint32_t    write_rfidr_state_next(ble_rfidrs_t *p_rfidrs, rfidr_state_t    l_rfidr_state_next);
 
@@ -34,15 +34,31 @@
 #include "nordic_common.h"
 #include "nrf_delay.h"
 #include "nrf_error.h"
+#include "rfidr_agc.h"
+#include "rfidr_chplan.h"
+#include "rfidr_dwell.h"
 #include "rfidr_error.h"
 #include "rfidr_spi.h"
+#include "rfidr_sx1257.h"
+#include "rfidr_txcal.h"
 #include <math.h>
 #include <string.h>
 #include <unistd.h>
 
-#define    FREQUENCY_CODE_BASE    0x00CB5555
-
-static    uint8_t    m_sx1257_frequency_slot    =    12;    //Start at 915MHz (13th slot out of 25)
+#define    SX1257_REG_RX_FREQ_MSB         0x01    //RX frequency is 0x01-0x03 and TX frequency is 0x04-0x06, MSB first.
+#define    SX1257_REG_LNA_GAIN            0x0C
+#define    SX1257_REG_MODE_STATUS         0x11    //Bit 1 is RX PLL lock and bit 0 is TX PLL lock.
+#define    SX1257_NUM_REGS                32      //Every register we touch lives below 0x20, so one bit of a uint32_t each says whether the shadow holds it.
+#define    SX1257_FREQ_REGS               (0x3FUL << SX1257_REG_RX_FREQ_MSB)
+//The status register reports live PLL state, so it is never shadowed.
+//The FPGA gain loop can move the LNA gain during a radio run, so set_go_radio_oneshot drops it from the shadow with
+//invalidate_sx1257_lna_gain_shadow. Between runs the shadow holds it again once it has been written or read back.
+#define    SX1257_VOLATILE_REGS           (1UL << SX1257_REG_MODE_STATUS)
+#define    SX1257_PLL_LOCKED              0x03
+#define    SX1257_LOCK_MAX_POLLS          64      //A few ms of status reads. Lock normally takes well under the 250us we used to wait blindly.
+
+static    uint8_t    m_sx1257_frequency_slot    =    0;    //Channel of the active channel plan (see rfidr_chplan.c) that we last hopped to.
+static    uint8_t    m_sx1257_tuned_slot        =    0;    //Channel we last tuned to, by a hop or a skip.
 
 //In order to ease coding, we predefine a number of operational frequencies that the reader can hop to.
 //As of 6/19/2019, we haven't done any hopping, so this hasn't been tested yet, although we do know that
@@ -50,39 +66,186 @@ static    uint8_t    m_sx1257_frequency_slot    =    12;    //Start at 915MHz (1
 
 //As of 11/25/2019, we've tested hopping and it seems to work OK.
 
-//Frequency resolution is 68.66455Hz per bit, so each slot is about 1MHz away from its adjacent slots.
-static uint32_t    sx1257_frequency_decode(uint8_t slot)
+//As of 10/16/2026, the frequencies come from the regional channel plan selected by the iDevice, with the original 25 1MHz slots from 903MHz as the default.
+//RX and TX use the same frequency code.
+
+//The SX1257 registers as last written or read, so that writing a value a register already holds, or reading back a register
+//we already know, costs no bridge transaction. rfidr_reset_radio invalidates it, and a failed write invalidates what it touched.
+static    uint8_t    m_sx1257_regs[SX1257_NUM_REGS]       =    {0};
+static    uint32_t   m_sx1257_regs_valid                  =    0;    //Bit n set means m_sx1257_regs[n] matches the SX1257.
+static    uint32_t   m_sx1257_bridge_transactions         =    0;    //Register reads and writes sent over the bridge.
+static    uint32_t   m_sx1257_bridge_avoided              =    0;    //Register reads and writes served from the shadow instead.
+
+//How long the PLLs have taken to lock after each frequency change, so that we can see how much dead air each hop costs.
+static    uint16_t   m_sx1257_lock_hist[SX1257_LOCK_HIST_BINS]    =    {0};
+static    uint16_t   m_sx1257_lock_timeouts                       =    0;
+
+static bool sx1257_shadow_holds(uint8_t addr, uint8_t data)
+{
+    return addr < SX1257_NUM_REGS && ((m_sx1257_regs_valid >> addr) & 1) && m_sx1257_regs[addr] == data;
+}
+
+static void sx1257_shadow_store(uint8_t addr, uint8_t data)
+{
+    if(addr >= SX1257_NUM_REGS || ((SX1257_VOLATILE_REGS >> addr) & 1)){return;}
+
+    m_sx1257_regs[addr]     =    data;
+    m_sx1257_regs_valid    |=    1UL << addr;
+}
+
+//Write one SX1257 register through the bridge, unless the shadow says it already holds data.
+static rfidr_error_t    write_sx1257_reg(uint8_t addr, uint8_t data)
+{
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+
+    if(sx1257_shadow_holds(addr,data)){m_sx1257_bridge_avoided++; return RFIDR_SUCCESS;}
+
+    m_sx1257_bridge_transactions++;
+    error_code    =    spi_cntrlr_write_sx1257_robust(addr,data);
+    if(error_code != RFIDR_SUCCESS)
+    {
+        if(addr < SX1257_NUM_REGS){m_sx1257_regs_valid &= ~(1UL << addr);}
+        return error_code;
+    }
+
+    sx1257_shadow_store(addr,data);
+    return RFIDR_SUCCESS;
+}
+
+//Read one SX1257 register, from the shadow if it holds the register and through the bridge otherwise.
+static rfidr_error_t    read_sx1257_reg(uint8_t addr, uint8_t * data)
+{
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+
+    if(addr < SX1257_NUM_REGS && ((m_sx1257_regs_valid >> addr) & 1))
+    {
+        *data    =    m_sx1257_regs[addr];
+        m_sx1257_bridge_avoided++;
+        return RFIDR_SUCCESS;
+    }
+
+    m_sx1257_bridge_transactions++;
+    error_code    =    spi_cntrlr_read_sx1257_robust(addr,data);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    sx1257_shadow_store(addr,*data);
+    return RFIDR_SUCCESS;
+}
+
+//Poll the SX1257 mode status register until both PLLs report lock, and log how many polls this took.
+//The wait is counted in polls rather than read off RTC1, which only runs while an app timer is pending and only resolves 30.5us.
+//Each poll is one bridge read, which takes a few tens of us, so the histogram resolves about as finely as we can look anyway.
+static rfidr_error_t    wait_sx1257_pll_lock(void)
 {
-    switch(slot)
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+    uint8_t          status        =    0;
+    uint8_t          loop_poll     =    0;
+    uint8_t          bin           =    0;
+
+    for(loop_poll=0;loop_poll < SX1257_LOCK_MAX_POLLS;loop_poll++)
     {
-        case(0):    return    FREQUENCY_CODE_BASE-0x0002AAAA;    break;
-        case(1):    return    FREQUENCY_CODE_BASE-0x000271C7;    break;
-        case(2):    return    FREQUENCY_CODE_BASE-0x000238E3;    break;
-        case(3):    return    FREQUENCY_CODE_BASE-0x00020000;    break;
-        case(4):    return    FREQUENCY_CODE_BASE-0x0001C71C;    break;
-        case(5):    return    FREQUENCY_CODE_BASE-0x00018E38;    break;
-        case(6):    return    FREQUENCY_CODE_BASE-0x00015555;    break;
-        case(7):    return    FREQUENCY_CODE_BASE-0x00011C71;    break;
-        case(8):    return    FREQUENCY_CODE_BASE-0x0000E38E;    break;
-        case(9):    return    FREQUENCY_CODE_BASE-0x0000AAAA;    break;
-        case(10):   return    FREQUENCY_CODE_BASE-0x000071C7;    break;
-        case(11):   return    FREQUENCY_CODE_BASE-0x000038E3;    break;
-        case(12):   return    FREQUENCY_CODE_BASE+0x00000000;    break;
-        case(13):   return    FREQUENCY_CODE_BASE+0x000038E3;    break;
-        case(14):   return    FREQUENCY_CODE_BASE+0x000071C7;    break;
-        case(15):   return    FREQUENCY_CODE_BASE+0x0000AAAA;    break;
-        case(16):   return    FREQUENCY_CODE_BASE+0x0000E38E;    break;
-        case(17):   return    FREQUENCY_CODE_BASE+0x00011C71;    break;
-        case(18):   return    FREQUENCY_CODE_BASE+0x00015555;    break;
-        case(19):   return    FREQUENCY_CODE_BASE+0x00018E38;    break;
-        case(20):   return    FREQUENCY_CODE_BASE+0x0001C71C;    break;
-        case(21):   return    FREQUENCY_CODE_BASE+0x00020000;    break;
-        case(22):   return    FREQUENCY_CODE_BASE+0x000238E3;    break;
-        case(23):   return    FREQUENCY_CODE_BASE+0x000271C7;    break;
-        case(24):   return    FREQUENCY_CODE_BASE+0x0002AAAA;    break;
-        default:    return    FREQUENCY_CODE_BASE+0x00000000;    break;
+        error_code    =    read_sx1257_reg(SX1257_REG_MODE_STATUS,&status);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+
+        if((status & SX1257_PLL_LOCKED) == SX1257_PLL_LOCKED)
+        {
+            bin    =    (uint8_t)MIN(loop_poll,SX1257_LOCK_HIST_BINS-1);
+            if(m_sx1257_lock_hist[bin] < 0xFFFF){m_sx1257_lock_hist[bin]++;}
+            return RFIDR_SUCCESS;
+        }
     }
-    return    FREQUENCY_CODE_BASE+0x00000000;
+
+    if(m_sx1257_lock_timeouts < 0xFFFF){m_sx1257_lock_timeouts++;}
+    return RFIDR_ERROR_SX1257_PLL_LOCK;
+}
+
+void get_sx1257_lock_stats(uint16_t * hist, uint16_t * timeouts)
+{
+    memcpy(hist,m_sx1257_lock_hist,sizeof(m_sx1257_lock_hist));
+    *timeouts    =    m_sx1257_lock_timeouts;
+}
+
+rfidr_error_t read_sx1257_shadow_stats(uint32_t * p_transactions, uint32_t * p_avoided)
+{
+    *p_transactions    =    m_sx1257_bridge_transactions;
+    *p_avoided         =    m_sx1257_bridge_avoided;
+
+    return RFIDR_SUCCESS;
+}
+
+void clear_sx1257_shadow_stats(void)
+{
+    m_sx1257_bridge_transactions    =    0;
+    m_sx1257_bridge_avoided         =    0;
+}
+
+//Program the RX and TX frequency registers for a slot, writing only what differs from the shadow, in one batched bridge transaction.
+//If any byte of a triplet changes, the LSB is written too, since the PLL retunes on the LSB write.
+//Returns once the PLLs have locked, unless nothing needed writing.
+static rfidr_error_t    write_sx1257_frequency_slot(uint8_t slot)
+{
+    const uint8_t    *p_code          =    rfidr_chplan_channel_regs(slot);
+    sx1257_reg_t     freq_regs[6];
+    uint8_t          num_regs         =    0;
+    uint8_t          loop_chain       =    0;
+    uint8_t          loop_byte        =    0;
+    uint8_t          addr             =    0;
+    bool             chain_changed    =    false;
+    rfidr_error_t    error_code       =    RFIDR_SUCCESS;
+
+    rfidr_dwell_set_channel(slot);    //Charge any transmit time from here on to the new channel.
+    m_sx1257_tuned_slot    =    slot;
+
+    for(loop_chain=0;loop_chain < 2;loop_chain++)
+    {
+        chain_changed=false;
+        for(loop_byte=0;loop_byte < 3;loop_byte++)
+        {
+            chain_changed|=!sx1257_shadow_holds((uint8_t)(SX1257_REG_RX_FREQ_MSB+loop_chain*3+loop_byte),p_code[loop_byte]);
+        }
+        if(!chain_changed){continue;}
+
+        for(loop_byte=0;loop_byte < 3;loop_byte++)
+        {
+            addr    =    (uint8_t)(SX1257_REG_RX_FREQ_MSB+loop_chain*3+loop_byte);
+            if(loop_byte == 2 || !sx1257_shadow_holds(addr,p_code[loop_byte]))
+            {
+                freq_regs[num_regs].addr    =    addr;
+                freq_regs[num_regs].data    =    p_code[loop_byte];
+                num_regs++;
+            }
+        }
+    }
+
+    m_sx1257_bridge_transactions    +=    num_regs;
+    m_sx1257_bridge_avoided         +=    6-num_regs;
+    if(num_regs == 0){return RFIDR_SUCCESS;}
+
+    error_code    =    spi_cntrlr_write_sx1257_list(freq_regs, num_regs);
+    if(error_code != RFIDR_SUCCESS)
+    {
+        m_sx1257_regs_valid    &=    ~SX1257_FREQ_REGS;
+        return error_code;
+    }
+
+    for(loop_byte=0;loop_byte < 6;loop_byte++)
+    {
+        sx1257_shadow_store((uint8_t)(SX1257_REG_RX_FREQ_MSB+loop_byte),p_code[loop_byte % 3]);
+    }
+
+    return wait_sx1257_pll_lock();
+}
+
+//Forget the register shadow so that the next write to each register goes over the bridge. rfidr_reset_radio calls this.
+void invalidate_sx1257_shadow(void)
+{
+    m_sx1257_regs_valid    =    0;
+}
+
+//Forget the shadowed LNA gain, since the FPGA gain loop may be about to change it.
+void invalidate_sx1257_lna_gain_shadow(void)
+{
+    m_sx1257_regs_valid    &=    ~(1UL << SX1257_REG_LNA_GAIN);
 }
 
 //This is code for loading the registers of the SX1257 after it is reset.
@@ -93,71 +256,77 @@ static uint32_t    sx1257_frequency_decode(uint8_t slot)
 rfidr_error_t    load_sx1257_default(void)
 {
     rfidr_error_t    error_code            =    RFIDR_SUCCESS;
-    uint32_t         sx1257_freq_code      =    0x00CB5555;    //915MHz
-    uint32_t         sx1257_freq_code_rx   =    0x00CB5555;    //915MHz
+    const uint8_t    *p_code               =    NULL;
+
+    if(rfidr_chplan_apply_pending()){rfidr_dwell_replan(); rfidr_agc_reset(); rfidr_txcal_reset();}    //Pick up the channel plan if the iDevice has changed it, or load the default one if this is the first time through.
+    m_sx1257_frequency_slot       =    rfidr_chplan_center_channel();    //915MHz for the default plan.
+    rfidr_dwell_set_channel(m_sx1257_frequency_slot);
+    m_sx1257_tuned_slot           =    m_sx1257_frequency_slot;
+    p_code                        =    rfidr_chplan_channel_regs(m_sx1257_frequency_slot);
 
-    m_sx1257_frequency_slot    =    12;    //915MHz
-    sx1257_freq_code=sx1257_frequency_decode(m_sx1257_frequency_slot);    //Should return 0x00CB5555
+    //This is also our recovery path, and the PLL 'jiggling' below depends on every write happening, so start from an empty shadow.
+    invalidate_sx1257_shadow();
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x00,0x00);    //Turn off everything on the SX1257.
+    error_code    =    write_sx1257_reg(0x00,0x00);    //Turn off everything on the SX1257.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x00,0x01);    //Turn on the SX1257 PDS and oscillator.
+    error_code    =    write_sx1257_reg(0x00,0x01);    //Turn on the SX1257 PDS and oscillator.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x08,0x28);    //-18dBFS (0x36) is high gain (1W out). This is just a random value we use during initialization.
+    error_code    =    write_sx1257_reg(0x08,0x28);    //-18dBFS (0x36) is high gain (1W out). This is just a random value we use during initialization.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0A,0x00);    //Set TX PLL BW to 75kHz and set TX ANA BW to 213kHz (min) to improve emissions mask performance as much as possible. Was 0x60 for 26dBm operation.
+    error_code    =    write_sx1257_reg(0x0A,0x00);    //Set TX PLL BW to 75kHz and set TX ANA BW to 213kHz (min) to improve emissions mask performance as much as possible. Was 0x60 for 26dBm operation.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0B,0x05);    //Use 64 TX FIR_DAC taps. This minimizes the bandwidth of the TX digital filter and improves emissions mask performance as much as possible.
+    error_code    =    write_sx1257_reg(0x0B,0x05);    //Use 64 TX FIR_DAC taps. This minimizes the bandwidth of the TX digital filter and improves emissions mask performance as much as possible.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0C,0xD4);    //Set LNA/RX gain to the minimum useful value (0xD4). Other useful values are 0x94 (medium) and 0x34 (high). Make sure Zin=50 ohms.
+    error_code    =    write_sx1257_reg(0x0C,0xD4);    //Set LNA/RX gain to the minimum useful value (0xD4). Other useful values are 0x94 (medium) and 0x34 (high). Make sure Zin=50 ohms.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0D,0xF5);    //Maximize RX ADC bandwidth so allow the highest possible BLF. Set oscillator freq. to 36MHz.  Set RX roofing filter BW to 500kHz.
+    error_code    =    write_sx1257_reg(0x0D,0xF5);    //Maximize RX ADC bandwidth so allow the highest possible BLF. Set oscillator freq. to 36MHz.  Set RX roofing filter BW to 500kHz.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0E,0x06);    //RX PLL bandwidth to the min at 75kHz. Was 0x06 for +26dBm operation. Disable RX ADC temp measurement mode.
+    error_code    =    write_sx1257_reg(0x0E,0x06);    //RX PLL bandwidth to the min at 75kHz. Was 0x06 for +26dBm operation. Disable RX ADC temp measurement mode.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x10,0x00);    //Disable CLK_OUT, use XTAL (this means an XTAL or an OSC on the XTAL port), no loopback.
+    error_code    =    write_sx1257_reg(0x10,0x00);    //Disable CLK_OUT, use XTAL (this means an XTAL or an OSC on the XTAL port), no loopback.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x01,(uint8_t)((sx1257_freq_code_rx>>16) & 255));//Set RX frequency MSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x01,p_code[0]);    //Set RX frequency MSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x02,(uint8_t)((sx1257_freq_code_rx>>8) & 255));    //Set RX frequency MidSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x02,p_code[1]);    //Set RX frequency MidSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x03,(uint8_t)((sx1257_freq_code_rx>>0) & 255));    //Set RX frequency LSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x03,p_code[2]);    //Set RX frequency LSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x04,(uint8_t)((sx1257_freq_code>>16) & 255));    //Set TX frequency MSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x04,p_code[0]);    //Set TX frequency MSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x05,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set TX frequency MidSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x05,p_code[1]);    //Set TX frequency MidSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x06,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set TX frequency LSB - start at 915MHz.
+    error_code    =    write_sx1257_reg(0x06,p_code[2]);    //Set TX frequency LSB - start at the center channel.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
-
     //Turn on gradually - try to avoid tonal behavior from arising
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x00,0x03);    //Turn on the SX1257 RX front end and RX PLL.
+    error_code    =    write_sx1257_reg(0x00,0x03);    //Turn on the SX1257 RX front end and RX PLL.
     if(error_code != RFIDR_SUCCESS){return error_code;}
     nrf_delay_ms(100);
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x00,0x07);    //Turn on the SX1257 TX front end and PLL (except TX PA driver).
+    error_code    =    write_sx1257_reg(0x00,0x07);    //Turn on the SX1257 TX front end and PLL (except TX PA driver).
     if(error_code != RFIDR_SUCCESS){return error_code;}
     nrf_delay_ms(100);
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x10,0x02);    //Enable CLK_OUT, use XTAL (this means an XTAL or an OSC on the XTAL port), no loopback.
+    error_code    =    write_sx1257_reg(0x10,0x02);    //Enable CLK_OUT, use XTAL (this means an XTAL or an OSC on the XTAL port), no loopback.
     if(error_code != RFIDR_SUCCESS){return error_code;}
     nrf_delay_ms(100);
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x00,0x0F);    //Turn on the SX1257 TX PA driver LAST.
+    error_code    =    write_sx1257_reg(0x00,0x0F);    //Turn on the SX1257 TX PA driver LAST.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
-    return RFIDR_SUCCESS;
+    return wait_sx1257_pll_lock();    //After the waits above this should pass straight away, but now we know the PLLs came up.
 }
 
 //Set the SX1257 LNA gain using an SPI write.
+//The write is skipped if the gain was last written or read back as the same value and no radio run has happened since,
+//which covers the usual reset to 0xD4 after a read that the FPGA gain loop left at 0xD4.
 rfidr_error_t    set_sx1257_lna_gain(uint8_t lna_gain)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0C,lna_gain);    //The three values found to be useful during characterization of the SX1257
-    if(error_code != RFIDR_SUCCESS){return error_code;}                  //are 0xD4 (low gain - needed to fit max. TX leakage through SX1257 receiver), 
-                                                                         //0x94 (med gain), and 0x34 (high gain - needed for min. sensitivity).
+    error_code    =    write_sx1257_reg(SX1257_REG_LNA_GAIN,lna_gain);    //The three values found to be useful during characterization of the SX1257
+    if(error_code != RFIDR_SUCCESS){return error_code;}                   //are 0xD4 (low gain - needed to fit max. TX leakage through SX1257 receiver), 
+                                                                          //0x94 (med gain), and 0x34 (high gain - needed for min. sensitivity).
     return RFIDR_SUCCESS;
 }
 
@@ -166,9 +335,9 @@ rfidr_error_t    get_sx1257_lna_gain(uint8_t * lna_gain)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_read_sx1257_robust(0x0C,lna_gain);    //The three values found to be useful during characterization of the SX1257
-    if(error_code != RFIDR_SUCCESS){return error_code;}                 //are 0xD4 (low gain - needed to fit max. TX leakage through SX1257 receiver), 
-                                                                        //0x94 (med gain), and 0x34 (high gain - needed for min. sensitivity).
+    error_code    =    read_sx1257_reg(SX1257_REG_LNA_GAIN,lna_gain);    //The three values found to be useful during characterization of the SX1257
+    if(error_code != RFIDR_SUCCESS){return error_code;}                  //are 0xD4 (low gain - needed to fit max. TX leakage through SX1257 receiver), 
+                                                                         //0x94 (med gain), and 0x34 (high gain - needed for min. sensitivity).
     return RFIDR_SUCCESS;
 }
 
@@ -177,7 +346,7 @@ rfidr_error_t    set_sx1257_tx_power_low(void)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x08,0x34);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
+    error_code    =    write_sx1257_reg(0x08,0x34);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
@@ -188,7 +357,7 @@ rfidr_error_t    set_sx1257_tx_power_med(void)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x08,0x34);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
+    error_code    =    write_sx1257_reg(0x08,0x34);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
@@ -198,7 +367,7 @@ rfidr_error_t    set_sx1257_tx_power_med(void)
 rfidr_error_t    set_sx1257_tx_power_high(void)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x08,0x36);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
+    error_code    =    write_sx1257_reg(0x08,0x36);        //-18dBFS (0x36) is high gain and results in ~30dBm output power. 0x34 results in ~26dBm output power.
 
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
@@ -210,7 +379,7 @@ rfidr_error_t    set_sx1257_rx_gain_low()
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0C,0xD4);
+    error_code    =    write_sx1257_reg(SX1257_REG_LNA_GAIN,0xD4);
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
@@ -221,7 +390,7 @@ rfidr_error_t    set_sx1257_rx_gain_med(void)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0C,0x94);
+    error_code    =    write_sx1257_reg(SX1257_REG_LNA_GAIN,0x94);
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
@@ -232,7 +401,7 @@ rfidr_error_t    set_sx1257_rx_gain_high(void)
 {
     rfidr_error_t error_code            =    RFIDR_SUCCESS;
 
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x0C,0x34);
+    error_code    =    write_sx1257_reg(SX1257_REG_LNA_GAIN,0x34);
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
@@ -243,20 +412,21 @@ rfidr_error_t    set_sx1257_rx_gain_high(void)
 //If TX PA and/or predriver is pulling on the PLL, it may pull it into a good phase relationship if it needs to reconverge
 rfidr_error_t    set_sx1257_fix_tones(void)
 {
-    rfidr_error_t error_code            =    RFIDR_SUCCESS;
-    uint32_t        sx1257_freq_code    =    0x00CB5565;
-
-    sx1257_freq_code=sx1257_frequency_decode(m_sx1257_frequency_slot);
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x01,(uint8_t)((sx1257_freq_code>>16) & 255));   //Set RX frequency MSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x02,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set RX frequency MidSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x03,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set RX frequency LSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    
-    nrf_delay_us(250);
-
-    return RFIDR_SUCCESS;
+    rfidr_error_t    error_code            =    RFIDR_SUCCESS;
+    const uint8_t    *p_code               =    rfidr_chplan_channel_regs(m_sx1257_frequency_slot);
+    sx1257_reg_t     freq_regs[3]          =    {{SX1257_REG_RX_FREQ_MSB+0,p_code[0]},     //Set RX frequency MSB.
+                                                 {SX1257_REG_RX_FREQ_MSB+1,p_code[1]},     //Set RX frequency MidSB.
+                                                 {SX1257_REG_RX_FREQ_MSB+2,p_code[2]}};    //Set RX frequency LSB.
+
+    //Rewrite just the RX frequency registers. The point is to force a relock, so this deliberately bypasses the shadow.
+    m_sx1257_bridge_transactions    +=    3;
+    error_code    =    spi_cntrlr_write_sx1257_list(freq_regs, 3);
+    if(error_code != RFIDR_SUCCESS){m_sx1257_regs_valid &= ~SX1257_FREQ_REGS; return error_code;}
+    sx1257_shadow_store(SX1257_REG_RX_FREQ_MSB+0,p_code[0]);
+    sx1257_shadow_store(SX1257_REG_RX_FREQ_MSB+1,p_code[1]);
+    sx1257_shadow_store(SX1257_REG_RX_FREQ_MSB+2,p_code[2]);
+
+    return wait_sx1257_pll_lock();
 }
 
 
@@ -265,30 +435,20 @@ rfidr_error_t    set_sx1257_fix_tones(void)
 rfidr_error_t    hop_sx1257_frequency(uint8_t * p_sx1257_frequency_slot)
 {
     rfidr_error_t    error_code            =    RFIDR_SUCCESS;
-    uint32_t         sx1257_freq_code      =    0x00CB5555;
+
+    //A new channel plan only ever takes effect here, so that the skip that follows a hop is always on the same plan as the hop.
+    //Channel numbers mean something else on the new plan, so the AGC gains and TX offsets start over and the dwell accounting is carried over conservatively.
+    if(rfidr_chplan_apply_pending()){rfidr_dwell_replan(); rfidr_agc_reset(); rfidr_txcal_reset();}
 
     //For debugging, comment these out
-    m_sx1257_frequency_slot    = (m_sx1257_frequency_slot+7) % 25;
-    //m_sx1257_frequency_slot = 12;
-    sx1257_freq_code=sx1257_frequency_decode(m_sx1257_frequency_slot);
+    m_sx1257_frequency_slot    = rfidr_chplan_next_channel();
+    //m_sx1257_frequency_slot = rfidr_chplan_center_channel();
 
     *p_sx1257_frequency_slot=m_sx1257_frequency_slot;
 
-    //Rewrite SX1257 PLL-related registers.
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x01,(uint8_t)((sx1257_freq_code>>16) & 255));    //Set RX frequency MSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x02,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set RX frequency MidSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x03,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set RX frequency LSB - start at 915MHz.
+    //Rewrite the SX1257 PLL-related registers that change.
+    error_code    =    write_sx1257_frequency_slot(m_sx1257_frequency_slot);
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x04,(uint8_t)((sx1257_freq_code>>16) & 255));    //Set TX frequency MSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x05,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set TX frequency MidSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x06,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set TX frequency LSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    
-    nrf_delay_us(250);
 
     return RFIDR_SUCCESS;
 }
@@ -298,26 +458,15 @@ rfidr_error_t    hop_sx1257_frequency(uint8_t * p_sx1257_frequency_slot)
 rfidr_error_t    set_sx1257_frequency(uint8_t sx1257_frequency_slot)
 {
     rfidr_error_t    error_code            =    RFIDR_SUCCESS;
-    uint32_t         sx1257_freq_code      =    0x00CB5555;
 
-    //For debugging, just examine the central frequency
-    sx1257_freq_code=sx1257_frequency_decode(sx1257_frequency_slot);
-    
-    //Rewrite SX1257 PLL-related registers.
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x01,(uint8_t)((sx1257_freq_code>>16) & 255));    //Set RX frequency MSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x02,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set RX frequency MidSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x03,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set RX frequency LSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x04,(uint8_t)((sx1257_freq_code>>16) & 255));    //Set TX frequency MSB - start at 915MHz.
+    //Rewrite the SX1257 PLL-related registers that change.
+    error_code    =    write_sx1257_frequency_slot(sx1257_frequency_slot);
     if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x05,(uint8_t)((sx1257_freq_code>>8) & 255));    //Set TX frequency MidSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    spi_cntrlr_write_sx1257_robust(0x06,(uint8_t)((sx1257_freq_code>>0) & 255));    //Set TX frequency LSB - start at 915MHz.
-    if(error_code != RFIDR_SUCCESS){return error_code;}
-    
-    nrf_delay_us(250);
 
     return RFIDR_SUCCESS;
 }
+
+uint8_t    get_sx1257_frequency_slot(void)
+{
+    return m_sx1257_tuned_slot;
+}
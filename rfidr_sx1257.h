@@ -42,6 +42,8 @@
 #include "nrf51_bitfields.h"
 #include "rfidr_error.h"
 
+#define SX1257_LOCK_HIST_BINS          8          //PLL settle time histogram bins. Bin n counts locks seen on status poll n+1, and the last bin also catches everything slower.
+
 //function for a default load of the SX1257
 //returns RFIDR_SUCCESS on successful load of the SX1257
 
@@ -102,4 +104,33 @@ rfidr_error_t hop_sx1257_frequency(uint8_t * p_sx1257_frequency_slot);
 
 rfidr_error_t set_sx1257_frequency(uint8_t sx1257_frequency_slot);
 
+//function for finding which frequency slot the SX1257 is tuned to, whether by a hop or by setting it
+//returns the slot, a channel of the active channel plan
+
+uint8_t get_sx1257_frequency_slot(void);
+
+//function for discarding the MCU-side shadow of the SX1257 registers, e.g. after the SX1257 has been reset
+//the next write to each register will then go over the bridge even if it repeats the last value
+
+void invalidate_sx1257_shadow(void);
+
+//function for discarding the shadowed LNA gain, since the FPGA gain loop may change it during a radio run
+//set_go_radio_oneshot calls this before each run.
+
+void invalidate_sx1257_lna_gain_shadow(void);
+
+//function for reading how many SX1257 register reads and writes went over the bridge and how many the shadow made unnecessary
+//returns RFIDR_SUCCESS on successful read
+
+rfidr_error_t read_sx1257_shadow_stats(uint32_t * p_transactions, uint32_t * p_avoided);
+
+//function for zeroing the SX1257 bridge transaction counters
+
+void clear_sx1257_shadow_stats(void);
+
+//function for reading how long the SX1257 PLLs have taken to lock after each frequency change since power up
+//hist receives SX1257_LOCK_HIST_BINS counts, binned by status polls and each saturating at 65535; timeouts receives the number of waits that gave up
+
+void get_sx1257_lock_stats(uint16_t * hist, uint16_t * timeouts);
+
 #endif
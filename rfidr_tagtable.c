@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Tag Table                                            //
+//                                                                              //
+// Filename: rfidr_tagtable.c                                                   //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains a table of the unique tags seen during an inventory, so//
+//    that a tag which is re-read over and over only needs to be reported to the//
+//    iDevice when it first shows up or when its signal changes markedly. EPCs  //
+//    are hashed into a fixed table and collisions are resolved by linear       //
+//    probing. There is no deletion; the table is emptied as a whole.           //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_tagtable.h"
+#include <string.h>
+
+#define TAG_TABLE_MASK              (RFIDR_TAG_TABLE_SIZE-1)
+#define TAG_TABLE_OVERFLOW_MASK     (RFIDR_TAG_TABLE_OVERFLOW_BITS-1)
+
+static rfidr_tag_entry_t    m_tag_table[RFIDR_TAG_TABLE_SIZE];
+static uint16_t             m_tag_table_count          =    0;    //Entries in use.
+static uint16_t             m_tag_table_overflow       =    0;    //Tags which did not fit, each counted on its first read only.
+static uint8_t              m_tag_table_overflow_seen[RFIDR_TAG_TABLE_OVERFLOW_BITS/8];    //One bit per EPC hash value of the tags counted in m_tag_table_overflow.
+static uint32_t             m_tag_table_total_reads    =    0;
+
+//FNV-1a, which is cheap on a Cortex-M0 and spreads EPCs well even when they differ only in their last few bytes.
+uint32_t rfidr_epc_hash(const uint8_t * epc)
+{
+    uint32_t    hash          =    2166136261UL;
+    uint8_t     loop_bytes    =    0;
+
+    for(loop_bytes=0;loop_bytes < MAX_EPC_LENGTH_IN_BYTES;loop_bytes++)
+    {
+        hash    =    (hash ^ epc[loop_bytes]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+void rfidr_tag_table_reset(void)
+{
+    memset(m_tag_table,0,sizeof(m_tag_table));
+    memset(m_tag_table_overflow_seen,0,sizeof(m_tag_table_overflow_seen));
+    m_tag_table_count          =    0;
+    m_tag_table_overflow       =    0;
+    m_tag_table_total_reads    =    0;
+}
+
+//Find the entry holding epc, or failing that the empty entry where it would go.
+//Since the table is never more than RFIDR_TAG_TABLE_MAX_FILL full, there is always an empty entry to stop the probe.
+static rfidr_tag_entry_t * tag_table_probe(const uint8_t * epc)
+{
+    uint8_t    index    =    (uint8_t)(rfidr_epc_hash(epc) & TAG_TABLE_MASK);
+
+    while(m_tag_table[index].in_use && memcmp(m_tag_table[index].epc,epc,MAX_EPC_LENGTH_IN_BYTES) != 0)
+    {
+        index=(index+1) & TAG_TABLE_MASK;
+    }
+
+    return &m_tag_table[index];
+}
+
+rfidr_tag_update_t rfidr_tag_table_update(const rfidr_return_t * p_return, uint8_t frequency_slot)
+{
+    rfidr_tag_entry_t    *p_entry       =    NULL;
+    const uint8_t        *epc           =    NULL;
+    uint16_t             delta          =    0;
+    uint16_t             overflow_bit   =    0;
+    rfidr_rssi_t         rssi;
+
+    rfidr_rssi_from_return(p_return,&rssi);    //The caller only hands us reads that passed, so this cannot fail.
+    epc=(rssi.choose_i == RFIDR_RSSI_CHOOSE_I) ? p_return->i_epc : p_return->q_epc;
+
+    m_tag_table_total_reads++;
+
+    p_entry=tag_table_probe(epc);
+
+    if(!p_entry->in_use)
+    {
+        if(m_tag_table_count >= RFIDR_TAG_TABLE_MAX_FILL)
+        {
+            //Without this filter, a tag which is re-read over and over would count as a new tag on every read and trip max_tags early.
+            //The filter can undercount, but never counts one tag twice.
+            overflow_bit=(uint16_t)(rfidr_epc_hash(epc) & TAG_TABLE_OVERFLOW_MASK);
+            if(!((m_tag_table_overflow_seen[overflow_bit >> 3] >> (overflow_bit & 7)) & 1))
+            {
+                m_tag_table_overflow_seen[overflow_bit >> 3]    |=    (uint8_t)(1 << (overflow_bit & 7));
+                m_tag_table_overflow++;
+            }
+            return TAG_TABLE_FULL;
+        }
+
+        memcpy(p_entry->epc,epc,MAX_EPC_LENGTH_IN_BYTES);
+        p_entry->in_use           =    true;
+        p_entry->read_count       =    1;
+        p_entry->best_rssi        =    rssi.rssi;
+        p_entry->last_rssi        =    rssi.rssi;
+        p_entry->reported_rssi    =    rssi.rssi;
+        p_entry->last_phase       =    rssi.phase;
+        p_entry->last_slot        =    frequency_slot;
+        p_entry->last_seen        =    m_tag_table_total_reads;
+        m_tag_table_count++;
+        return TAG_TABLE_NEW;
+    }
+
+    if(p_entry->read_count < 0xFFFF){p_entry->read_count++;}
+    if(rssi.rssi > p_entry->best_rssi){p_entry->best_rssi=rssi.rssi;}
+    p_entry->last_rssi     =    rssi.rssi;
+    p_entry->last_phase    =    rssi.phase;
+    p_entry->last_slot     =    frequency_slot;
+    p_entry->last_seen     =    m_tag_table_total_reads;
+
+    delta=(rssi.rssi > p_entry->reported_rssi) ? (rssi.rssi-p_entry->reported_rssi) : (p_entry->reported_rssi-rssi.rssi);
+    if(delta > RFIDR_TAG_TABLE_RSSI_DELTA)
+    {
+        p_entry->reported_rssi=rssi.rssi;
+        return TAG_TABLE_CHANGED;
+    }
+
+    return TAG_TABLE_UNCHANGED;
+}
+
+const rfidr_tag_entry_t * rfidr_tag_table_lookup(const uint8_t * epc)
+{
+    rfidr_tag_entry_t    *p_entry    =    tag_table_probe(epc);
+
+    return p_entry->in_use ? p_entry : NULL;
+}
+
+uint16_t rfidr_tag_table_unique_count(void)
+{
+    return m_tag_table_count+m_tag_table_overflow;
+}
+
+uint32_t rfidr_tag_table_total_reads(void)
+{
+    return m_tag_table_total_reads;
+}
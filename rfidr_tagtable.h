@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Tag Table                                            //
+//                                                                              //
+// Filename: rfidr_tagtable.h                                                   //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains a table of the unique tags seen during an inventory, so//
+//    that a tag which is re-read over and over only needs to be reported to the//
+//    iDevice when it first shows up or when its signal changes markedly.       //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR tag table functions
+//This file provides an open-addressing hash table of EPCs with per-tag read statistics
+
+#ifndef RFIDR_TAGTABLE_H__
+#define RFIDR_TAGTABLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_error.h"
+#include "rfidr_rssi.h"
+#include "rfidr_rxradio.h"
+
+#define RFIDR_TAG_TABLE_SIZE        32        //Must be a power of 2. Each entry costs 28 bytes of RAM, and the application only has 8kB next to the SoftDevice.
+#define RFIDR_TAG_TABLE_MAX_FILL    24        //Stop adding tags at 3/4 full so that linear probing stays short.
+#define RFIDR_TAG_TABLE_RSSI_DELTA  (2 << 8)  //A tag is reported again once its RSSI has moved by more than 2dB (Q8.8).
+#define RFIDR_TAG_TABLE_OVERFLOW_BITS 256     //Must be a power of 2. Bits in the filter which counts tags that did not fit in the table, costing 1 byte of RAM per 8.
+
+typedef struct
+{
+    uint8_t        epc[MAX_EPC_LENGTH_IN_BYTES];
+    uint32_t       last_seen;                           //rfidr_tag_table_total_reads at the last read. RTC1 is not used since app_timer stops it whenever no timer is pending.
+    uint16_t       best_rssi;                           //Largest RSSI seen for this tag, in dB as Q8.8.
+    uint16_t       last_rssi;                           //RSSI at the last read.
+    uint16_t       reported_rssi;                       //RSSI at the last time this tag was reported to the iDevice.
+    uint16_t       last_phase;                          //Phase at the last read, 65536 to a full circle.
+    uint16_t       read_count;                          //Saturates at 65535.
+    uint8_t        last_slot;                           //Frequency slot of the last read.
+    bool           in_use;
+} rfidr_tag_entry_t;
+
+typedef enum
+{
+    TAG_TABLE_NEW,                                      //First read of this tag since the last reset. Report it.
+    TAG_TABLE_CHANGED,                                  //The RSSI has moved by more than RFIDR_TAG_TABLE_RSSI_DELTA since the tag was last reported. Report it.
+    TAG_TABLE_UNCHANGED,                                //Nothing the iDevice doesn't already know.
+    TAG_TABLE_FULL                                      //Not in the table and there is no room for it. Report it, since we can't tell if it's new.
+} rfidr_tag_update_t;
+
+//function for computing a 32-bit hash of an EPC
+//returns the FNV-1a hash of the MAX_EPC_LENGTH_IN_BYTES bytes at epc
+
+uint32_t rfidr_epc_hash(const uint8_t * epc);
+
+//function for emptying the tag table, to be called whenever an inventory starts
+
+void rfidr_tag_table_reset(void);
+
+//function for recording a successful tag read, using the I or Q run picked by rfidr_rssi_choose_i
+//returns whether the tag is new, has changed, is unchanged, or could not be added
+
+rfidr_tag_update_t rfidr_tag_table_update(const rfidr_return_t * p_return, uint8_t frequency_slot);
+
+//function for looking up a tag by EPC
+//returns a pointer to the tag's entry, or NULL if the tag is not in the table
+
+const rfidr_tag_entry_t * rfidr_tag_table_lookup(const uint8_t * epc);
+
+//function for reading out how many different tags have been read since the last reset
+//tags which did not fit in the table are counted once each by hash, so two of them which collide in the filter are counted as one
+
+uint16_t rfidr_tag_table_unique_count(void);
+
+//function for reading out how many tag reads there have been since the last reset
+
+uint32_t rfidr_tag_table_total_reads(void);
+
+#endif
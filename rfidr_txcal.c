@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware TX Offset Calibration                                //
+//                                                                              //
+// Filename: rfidr_txcal.c                                                      //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the TX offset calibration search. Each point costs     //
+//    about 1ms of PA and power detector settling, so rather than sweep all 256 //
+//    offset pairs we sample a coarse grid and refine around the best point with//
+//    a pattern search, first in steps of two and then of one. Leakage changes  //
+//    smoothly with the offsets, so this lands on the same minimum as the       //
+//    exhaustive sweep in a fraction of the points. The result is cached per    //
+//    channel, and a later calibration of the same channel only checks the eight//
+//    neighbours of the cached offsets.                                         //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "rfidr_txcal.h"
+#include <string.h>
+
+#define TXCAL_COARSE_STEP          4        //Coarse grid pitch. The grid sits at 2, 6, 10 and 14 so that a step 2 search from it reaches every offset.
+#define TXCAL_NO_CHANNEL           0xFF
+
+typedef struct
+{
+    uint8_t        sdm_offset;
+    uint8_t        zgn_offset;
+    uint16_t       power;
+    uint8_t        num_points;
+    uint8_t        measured[RFIDR_TXCAL_NUM_OFFSETS*RFIDR_TXCAL_NUM_OFFSETS/8];    //Bitmap of offset pairs already measured in this search.
+} txcal_search_t;
+
+static uint8_t     m_txcal_offsets[RFIDR_CHPLAN_MAX_CHANNELS];                    //SDM offset in the high nibble and zero-gen offset in the low nibble, as in the FPGA register.
+static uint8_t     m_txcal_valid[RFIDR_TXCAL_VALID_BYTES];                        //Bitmap of channels with a valid entry in m_txcal_offsets.
+
+static bool txcal_is_valid(uint8_t channel)
+{
+    return (m_txcal_valid[channel >> 3] >> (channel & 7)) & 1;
+}
+
+//Measure one offset pair, unless it has already been measured in this search.
+//Any point measured earlier lost to the best point at the time, and the best point only ever improves, so it can't win now either.
+static rfidr_error_t txcal_try(txcal_search_t * p_search, rfidr_txcal_measure_t measure, int8_t sdm_offset, int8_t zgn_offset)
+{
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+    uint8_t          index         =    0;
+    uint16_t         power         =    0;
+
+    if(sdm_offset < 0 || sdm_offset >= RFIDR_TXCAL_NUM_OFFSETS || zgn_offset < 0 || zgn_offset >= RFIDR_TXCAL_NUM_OFFSETS){return RFIDR_SUCCESS;}
+
+    index=(uint8_t)(sdm_offset*RFIDR_TXCAL_NUM_OFFSETS+zgn_offset);
+    if((p_search->measured[index >> 3] >> (index & 7)) & 1){return RFIDR_SUCCESS;}
+    p_search->measured[index >> 3] |= (uint8_t)(1 << (index & 7));
+
+    error_code=measure((uint8_t)sdm_offset,(uint8_t)zgn_offset,&power);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+    p_search->num_points++;
+
+    if(power < p_search->power)
+    {
+        p_search->power         =    power;
+        p_search->sdm_offset    =    (uint8_t)sdm_offset;
+        p_search->zgn_offset    =    (uint8_t)zgn_offset;
+    }
+
+    return RFIDR_SUCCESS;
+}
+
+//Move to the best of the eight neighbours at distance step until none of them improves on the current point.
+static rfidr_error_t txcal_pattern_search(txcal_search_t * p_search, rfidr_txcal_measure_t measure, int8_t step)
+{
+    rfidr_error_t    error_code    =    RFIDR_SUCCESS;
+    int8_t           sdm_center    =    0;
+    int8_t           zgn_center    =    0;
+    int8_t           loop_sdm      =    0;
+    int8_t           loop_zgn      =    0;
+
+    do
+    {
+        sdm_center=(int8_t)p_search->sdm_offset;
+        zgn_center=(int8_t)p_search->zgn_offset;
+
+        for(loop_sdm=-step;loop_sdm <= step;loop_sdm+=step)
+        {
+            for(loop_zgn=-step;loop_zgn <= step;loop_zgn+=step)
+            {
+                error_code=txcal_try(p_search,measure,sdm_center+loop_sdm,zgn_center+loop_zgn);
+                if(error_code != RFIDR_SUCCESS){return error_code;}
+            }
+        }
+    } while(p_search->sdm_offset != (uint8_t)sdm_center || p_search->zgn_offset != (uint8_t)zgn_center);
+
+    return RFIDR_SUCCESS;
+}
+
+//Find the calibrated channel closest in frequency to this one, or TXCAL_NO_CHANNEL if there are none.
+static uint8_t txcal_nearest_channel(uint8_t channel)
+{
+    uint8_t    loop_distance    =    0;
+
+    for(loop_distance=1;loop_distance < RFIDR_CHPLAN_MAX_CHANNELS;loop_distance++)
+    {
+        if(channel >= loop_distance && txcal_is_valid(channel-loop_distance)){return channel-loop_distance;}
+        if(channel+loop_distance < RFIDR_CHPLAN_MAX_CHANNELS && txcal_is_valid(channel+loop_distance)){return channel+loop_distance;}
+    }
+
+    return TXCAL_NO_CHANNEL;
+}
+
+void rfidr_txcal_reset(void)
+{
+    memset(m_txcal_valid,0,sizeof(m_txcal_valid));
+}
+
+bool rfidr_txcal_lookup(uint8_t channel, uint8_t * p_sdm_offset, uint8_t * p_zgn_offset)
+{
+    if(channel >= RFIDR_CHPLAN_MAX_CHANNELS || !txcal_is_valid(channel)){return false;}
+
+    *p_sdm_offset    =    m_txcal_offsets[channel] >> 4;
+    *p_zgn_offset    =    m_txcal_offsets[channel] & 0x0F;
+
+    return true;
+}
+
+void rfidr_txcal_export(uint8_t * p_offsets, uint8_t * p_valid)
+{
+    memcpy(p_offsets,m_txcal_offsets,sizeof(m_txcal_offsets));
+    memcpy(p_valid,m_txcal_valid,sizeof(m_txcal_valid));
+}
+
+void rfidr_txcal_import(const uint8_t * p_offsets, const uint8_t * p_valid)
+{
+    memcpy(m_txcal_offsets,p_offsets,sizeof(m_txcal_offsets));
+    memcpy(m_txcal_valid,p_valid,sizeof(m_txcal_valid));
+}
+
+rfidr_error_t rfidr_txcal_run(uint8_t channel, rfidr_txcal_measure_t measure, rfidr_txcal_result_t * p_result)
+{
+    rfidr_error_t      error_code    =    RFIDR_SUCCESS;
+    txcal_search_t     search;
+    uint8_t            seed          =    TXCAL_NO_CHANNEL;
+    uint8_t            loop_sdm      =    0;
+    uint8_t            loop_zgn      =    0;
+
+    if(channel >= RFIDR_CHPLAN_MAX_CHANNELS){return RFIDR_ERROR_GENERAL;}
+
+    memset(&search,0,sizeof(search));
+    search.power    =    0xFFFF;
+
+    seed=txcal_is_valid(channel) ? channel : txcal_nearest_channel(channel);
+
+    if(seed == TXCAL_NO_CHANNEL)
+    {
+        for(loop_sdm=TXCAL_COARSE_STEP/2;loop_sdm < RFIDR_TXCAL_NUM_OFFSETS;loop_sdm+=TXCAL_COARSE_STEP)
+        {
+            for(loop_zgn=TXCAL_COARSE_STEP/2;loop_zgn < RFIDR_TXCAL_NUM_OFFSETS;loop_zgn+=TXCAL_COARSE_STEP)
+            {
+                error_code=txcal_try(&search,measure,(int8_t)loop_sdm,(int8_t)loop_zgn);
+                if(error_code != RFIDR_SUCCESS){return error_code;}
+            }
+        }
+    }
+    else
+    {
+        error_code=txcal_try(&search,measure,(int8_t)(m_txcal_offsets[seed] >> 4),(int8_t)(m_txcal_offsets[seed] & 0x0F));
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+    }
+
+    //A channel's own cached offsets should already be within a step of one of the minimum.
+    if(seed != channel)
+    {
+        error_code=txcal_pattern_search(&search,measure,2);
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+    }
+    error_code=txcal_pattern_search(&search,measure,1);
+    if(error_code != RFIDR_SUCCESS){return error_code;}
+
+    m_txcal_offsets[channel]        =    (uint8_t)((search.sdm_offset << 4) | search.zgn_offset);
+    m_txcal_valid[channel >> 3]    |=    (uint8_t)(1 << (channel & 7));
+
+    p_result->sdm_offset    =    search.sdm_offset;
+    p_result->zgn_offset    =    search.zgn_offset;
+    p_result->power         =    search.power;
+    p_result->num_points    =    search.num_points;
+
+    return RFIDR_SUCCESS;
+}
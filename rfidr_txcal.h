@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware TX Offset Calibration                                //
+//                                                                              //
+// Filename: rfidr_txcal.h                                                      //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the prototypes for the search which finds the SDM and  //
+//    zero-gen offsets giving the least TX carrier leakage on a logic "0", and  //
+//    for the per-channel cache of the offsets it has found.                    //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+//RFIDR TX offset calibration functions
+//This file provides a coarse-to-fine offset search and remembers its result for each channel of the active plan
+
+#ifndef RFIDR_TXCAL_H__
+#define RFIDR_TXCAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfidr_chplan.h"
+#include "rfidr_error.h"
+
+#define RFIDR_TXCAL_NUM_OFFSETS    16       //The SDM and zero-gen offsets are each 4 bits wide.
+#define RFIDR_TXCAL_VALID_BYTES    ((RFIDR_CHPLAN_MAX_CHANNELS+7)/8)
+
+//Type for the function which sets both offsets, takes a power detector reading with the PA on and leaves the PA off again.
+
+typedef rfidr_error_t (*rfidr_txcal_measure_t) (uint8_t sdm_offset, uint8_t zgn_offset, uint16_t * p_power);
+
+typedef struct
+{
+    uint8_t        sdm_offset;
+    uint8_t        zgn_offset;
+    uint16_t       power;                               //Power detector reading at the chosen offsets.
+    uint8_t        num_points;                          //How many offset pairs the search measured.
+} rfidr_txcal_result_t;
+
+//function for forgetting every channel's offsets, e.g. when the channel plan changes
+
+void rfidr_txcal_reset(void);
+
+//function for looking up the offsets found for a channel
+//returns true if the channel has been calibrated since the last reset
+
+bool rfidr_txcal_lookup(uint8_t channel, uint8_t * p_sdm_offset, uint8_t * p_zgn_offset);
+
+//function for finding the best offsets on the channel the SX1257 is tuned to, and caching them for that channel
+//A calibrated channel only has the offsets next to its cached ones re-measured. An uncalibrated one starts from the nearest calibrated
+//channel with a two step search, and if there is none, from a coarse 4x4 grid over all offsets.
+//returns RFIDR_SUCCESS, or the first error from the measurement function
+
+rfidr_error_t rfidr_txcal_run(uint8_t channel, rfidr_txcal_measure_t measure, rfidr_txcal_result_t * p_result);
+
+//function for copying out the cache, e.g. to keep it in flash
+//p_offsets takes RFIDR_CHPLAN_MAX_CHANNELS bytes, each the SDM offset in the high nibble and zero-gen offset in the low nibble,
+//and p_valid takes RFIDR_TXCAL_VALID_BYTES bytes, a bitmap of which channels have been calibrated.
+
+void rfidr_txcal_export(uint8_t * p_offsets, uint8_t * p_valid);
+
+//function for loading the cache from a copy made by rfidr_txcal_export
+
+void rfidr_txcal_import(const uint8_t * p_offsets, const uint8_t * p_valid);
+
+#endif
@@ -38,6 +38,7 @@
 #include "nordic_common.h"
 #include "ble_rfidrs.h"
 #include "nrf_error.h"
+#include "rfidr_crc.h"
 #include "rfidr_error.h"
 #include "rfidr_spi.h"
 #include "rfidr_txradio.h"
@@ -98,6 +99,92 @@ static    uint8_t    m_kill_passwd[4];                                  //Holds
 static    uint8_t    m_length_app_specd_target_epc;                     //We need to hold the length of the app specd target EPC as a state variable.
 static    uint8_t    m_length_fmw_specd_target_epc;                     //We need to hold the length of the software specd target EPC as a state variable.
 
+//The MCU keeps a shadow copy of the FPGA TX RAM so that packet builders which regenerate an unchanged packet (e.g. the query and
+//select packets on every tracking loop) do not push the same bytes over SPI again. The shadow is laid out exactly like the TX RAM,
+//so section n of the shadow starts at TX_RAM_ADDR_OFFSET_xxx << 4. A byte is only trusted once it has been written and verified.
+#define    TX_RAM_SIZE_IN_BYTES    512    //32 sections of 16 bytes.
+
+static    uint8_t    m_tx_ram_shadow[TX_RAM_SIZE_IN_BYTES];             //Last verified contents of each TX RAM address.
+static    uint8_t    m_tx_ram_shadow_valid[TX_RAM_SIZE_IN_BYTES/8];     //One bit per TX RAM address, set when the shadow byte matches the FPGA.
+static    uint32_t   m_tx_ram_bytes_written;                            //TX RAM bytes actually sent over SPI since the stats were last cleared.
+static    uint32_t   m_tx_ram_bytes_skipped;                            //TX RAM bytes left alone because the shadow already matched.
+
+//The packet compiler. Each compile_xxx_image function below emits the complete opcode byte stream of one packet into a tx_image_t,
+//in the order the bytes sit in TX RAM. The matching load_xxx function then writes the whole image with one call to
+//tx_ram_shadow_write, which sends it over SPI as a single burst (and skips whatever the shadow says is already there).
+//The largest image is a select packet with a 96-bit EPC, which is 65 bytes.
+#define    TX_IMAGE_MAX_LENGTH        66
+
+typedef struct
+{
+    uint8_t    length;                            //Number of opcode bytes emitted so far.
+    uint8_t    bytes[TX_IMAGE_MAX_LENGTH];        //Opcode bytes, each already merged from two nibbles.
+} tx_image_t;
+
+//The select and query images only depend on the EPC source, the EPC length and the raw select/query fields, and the state machine
+//asks for the same few of them (APP_SPECD_EPC, LAST_INV_EPC, DUMMYTAG_EPC, ZERO_EPC) over and over again. So we keep a small cache
+//of compiled images keyed on exactly those values. The EPC bytes themselves are not part of the key: instead, the entries for an
+//EPC source are dropped whenever the EPC held for that source is changed (see tx_image_cache_drop_epc).
+//The same select image serves both select packet slots, since only the TX RAM address differs between them.
+//Query images are not kept in this cache but in the Q variant table below, since the state machine mostly changes Q alone.
+//No other packet is cached. The lock, read and short fixed packets never change, so recompiling them costs a few hundred cycles and
+//the shadow already keeps them off the SPI bus. Write packets carry a different EPC word each time and are only sent while programming.
+#define    TX_IMAGE_CACHE_ENTRIES     4
+
+#define    TX_IMAGE_KIND_SELECT       1
+#define    TX_IMAGE_KIND_QUERY        2
+
+typedef struct
+{
+    uint8_t    kind;                              //TX_IMAGE_KIND_SELECT, or TX_IMAGE_KIND_QUERY for the Q variant table. 0 marks an empty entry.
+    uint8_t    epc_type;                          //EPC source of a select image.
+    uint8_t    epc_length;                        //EPC length in bytes of a select image.
+    uint8_t    params[8];                         //The raw select or query fields, in struct order.
+} tx_image_key_t;
+
+typedef struct
+{
+    tx_image_key_t    key;
+    tx_image_t        image;
+} tx_image_cache_entry_t;
+
+static    tx_image_cache_entry_t    m_tx_image_cache[TX_IMAGE_CACHE_ENTRIES];
+static    uint8_t                   m_tx_image_cache_next;       //Entry to be replaced on the next cache miss (round robin).
+
+//The query packet under the current query settings. The image bytes ahead of the session bits (0-6) and the final byte only depend on
+//settings that stay fixed between rounds, so they are kept. The session byte (7) and the A/B flag, Q and CRC5 bytes (8-12) are
+//rebuilt from the command bits on each load, which is only a 17-bit CRC5 and six bytes of opcodes. A flag swap or a change of Q then
+//only rewrites whichever of bytes 8-12 differ in TX RAM.
+#define    QUERY_IMAGE_SESSION_BYTE      7    //Image byte holding the two session bits.
+#define    QUERY_IMAGE_FLAGSWAP_START    8    //Image byte holding the first of the A/B, Q and CRC5 bits rewritten by a flag swap.
+#define    QUERY_IMAGE_FLAGSWAP_LENGTH   5
+#define    QUERY_IMAGE_LENGTH            14
+
+static    uint8_t           m_query_head[QUERY_IMAGE_SESSION_BYTE];     //Query image bytes ahead of the session bits.
+static    uint8_t           m_query_end;                                //The final TXCW0/END_PACKET byte of the query image.
+static    uint32_t          m_query_fixed_bits;                         //Command, DR, M, TRext and Sel bits of the 17 bits ahead of CRC5.
+static    tx_image_key_t    m_query_key;                                //Query settings the head was computed for. Kind 0 means none.
+
+//Empty the whole packet image cache.
+static void tx_image_cache_clear(void)
+{
+    memset(m_tx_image_cache,0,sizeof(m_tx_image_cache));
+    m_tx_image_cache_next    =    0;
+    memset(&m_query_key,0,sizeof(m_query_key));
+}
+
+//Drop every cached select image which was compiled from the given EPC source, since the EPC it holds has changed.
+static void tx_image_cache_drop_epc(rfidr_select_epc_type_t epc_type)
+{
+    uint8_t    loop_entry    =    0;
+
+    for(loop_entry=0; loop_entry<TX_IMAGE_CACHE_ENTRIES; loop_entry++)
+    {
+        if(m_tx_image_cache[loop_entry].key.kind == TX_IMAGE_KIND_SELECT && m_tx_image_cache[loop_entry].key.epc_type == (uint8_t)epc_type)
+            memset(&m_tx_image_cache[loop_entry],0,sizeof(tx_image_cache_entry_t));
+    }
+}
+
 uint32_t     rfidr_txradio_init(void)
 {
     //Initialize the state variables used with this file with default values so that a major error does not occur if
@@ -184,6 +271,11 @@ uint32_t     rfidr_txradio_init(void)
 
     m_query_rep_session       = SESSION_S2;
 
+    //This is called right after the FPGA is reset, so nothing in the shadow can be trusted any more.
+    //The EPCs and raw select/query fields have just been reset too, so the compiled packet images go as well.
+    invalidate_tx_ram_shadow();
+    tx_image_cache_clear();
+
     return err_code;
 
 }
@@ -206,6 +298,8 @@ rfidr_error_t    set_app_specd_target_epc(ble_rfidrs_t * p_rfidrs, const uint8_t
             m_app_specd_target_epc[loop_i]    =    0;
     }
 
+    tx_image_cache_drop_epc(APP_SPECD_EPC);
+
     //Send the sanitized epc back to the reader.
     ble_rfidrs_target_epc_send(p_rfidrs,m_app_specd_target_epc,(uint16_t)m_length_app_specd_target_epc);
 
@@ -253,6 +347,8 @@ rfidr_error_t set_fmw_specd_target_epc(char * epc)
     m_length_fmw_specd_target_epc = ((temp_2x_length+1) >> 1); 
     //How far we've counted before we got to the end of the loop is how long the EPC is. Round up, obviously.
 
+    tx_image_cache_drop_epc(FMW_SPECD_EPC);
+
     return error_code;
 
 }
@@ -285,6 +381,7 @@ rfidr_error_t    set_last_inv_epc(const uint8_t * p_last_inv_epc)
     {
         m_last_inv_epc[loop_i] = p_last_inv_epc[loop_i];
     }
+    tx_image_cache_drop_epc(LAST_INV_EPC);
     return    RFIDR_SUCCESS;
 }
 
@@ -397,7 +494,60 @@ static uint8_t merge_code_nibbles(uint8_t codeMSB, uint8_t codeLSB)
     return ((codeMSB << 4) & msb_mask) | (codeLSB & lsb_mask);
 }
 
+static bool tx_ram_shadow_matches(uint16_t radio_sram_addr, uint8_t radio_sram_wdata)
+{
+    return ((m_tx_ram_shadow_valid[radio_sram_addr >> 3] >> (radio_sram_addr & 7)) & 1) && (m_tx_ram_shadow[radio_sram_addr] == radio_sram_wdata);
+}
+
+static void tx_ram_shadow_set_valid(uint16_t radio_sram_addr, bool valid)
+{
+    if(valid)
+        m_tx_ram_shadow_valid[radio_sram_addr >> 3]    |=    (uint8_t)(1 << (radio_sram_addr & 7));
+    else
+        m_tx_ram_shadow_valid[radio_sram_addr >> 3]    &=    (uint8_t)(~(1 << (radio_sram_addr & 7)));
+}
+
+//Diff a run of TX RAM bytes against the shadow and write only the sub-runs which differ, each with one robust burst write.
+//The shadow is updated for every sub-run which verifies. A sub-run which fails is marked invalid, since it may have been partially written.
+static rfidr_error_t tx_ram_shadow_write(uint16_t radio_sram_addr, uint16_t length, const uint8_t * p_data)
+{
+    rfidr_error_t      error_code            =    RFIDR_SUCCESS;
+    uint16_t           loop_byte             =    0;
+    uint16_t           dirty_start           =    0;
+    uint16_t           dirty_length          =    0;
+
+    if((uint32_t)radio_sram_addr+length > TX_RAM_SIZE_IN_BYTES){return RFIDR_ERROR_SPI_WRITE_TX;}
+
+    while(loop_byte < length)
+    {
+        if(tx_ram_shadow_matches(radio_sram_addr+loop_byte,p_data[loop_byte]))
+        {
+            m_tx_ram_bytes_skipped++;
+            loop_byte++;
+            continue;
+        }
+
+        dirty_start    =    loop_byte;
+        while(loop_byte < length && !tx_ram_shadow_matches(radio_sram_addr+loop_byte,p_data[loop_byte])){loop_byte++;}
+        dirty_length   =    loop_byte-dirty_start;
+
+        error_code     =    spi_cntrlr_write_burst_robust(RFIDR_RDIO_MEM,RFIDR_SPI_TXRAM,radio_sram_addr+dirty_start,dirty_length,&p_data[dirty_start]);
+        m_tx_ram_bytes_written    +=    dirty_length;
+
+        for(;dirty_start < loop_byte;dirty_start++)
+        {
+            m_tx_ram_shadow[radio_sram_addr+dirty_start]    =    p_data[dirty_start];
+            tx_ram_shadow_set_valid(radio_sram_addr+dirty_start,error_code == RFIDR_SUCCESS);
+        }
+
+        if(error_code != RFIDR_SUCCESS){return error_code;}
+    }
+
+    return RFIDR_SUCCESS;
+}
+
 //Combine merge_code_nibbles and the spi_cntrlr_tx_robust function since we use them together all the time.
+//The write goes through the TX RAM shadow, so it is skipped if the byte is already there.
 
 static rfidr_error_t merge_and_write_tx_ram(uint8_t codeMSB, uint8_t codeLSB, uint16_t radio_sram_addr)
 {
@@ -405,34 +555,93 @@ static rfidr_error_t merge_and_write_tx_ram(uint8_t codeMSB, uint8_t codeLSB, ui
     rfidr_error_t      error_code            =    RFIDR_SUCCESS;
     
     radio_sram_wdata    =    merge_code_nibbles(codeMSB,codeLSB);
-    error_code          =    spi_cntrlr_write_tx_robust(RFIDR_RDIO_MEM,RFIDR_SPI_TXRAM,radio_sram_addr,radio_sram_wdata);
+    error_code          =    tx_ram_shadow_write(radio_sram_addr,1,&radio_sram_wdata);
     if(error_code != RFIDR_SUCCESS){return error_code;}
 
     return RFIDR_SUCCESS;
 }
 
-//Bitwise-construct a select packet with an EPC and load it into the 'select' section of the TX RAM.
-//This function can load into either of the two select packet addresses in the FPGA and
-//draws from many different EPC sources.
+//Forget everything in the TX RAM shadow so that the next packet load writes every byte. Call this whenever the FPGA is reset.
+void invalidate_tx_ram_shadow(void)
+{
+    memset(m_tx_ram_shadow_valid,0,sizeof(m_tx_ram_shadow_valid));
+}
+
+rfidr_error_t read_tx_ram_shadow_stats(uint32_t * p_bytes_written, uint32_t * p_bytes_skipped)
+{
+    *p_bytes_written    =    m_tx_ram_bytes_written;
+    *p_bytes_skipped    =    m_tx_ram_bytes_skipped;
+
+    return RFIDR_SUCCESS;
+}
+
+void clear_tx_ram_shadow_stats(void)
+{
+    m_tx_ram_bytes_written    =    0;
+    m_tx_ram_bytes_skipped    =    0;
+}
+
+//Append one TX RAM byte, made from two opcode nibbles, to a packet image.
+static void tx_image_emit(tx_image_t * p_image, uint8_t codeMSB, uint8_t codeLSB)
+{
+    if(p_image->length < TX_IMAGE_MAX_LENGTH)
+        p_image->bytes[p_image->length++]    =    merge_code_nibbles(codeMSB,codeLSB);
+}
+
+//Convert a single bit of a command vector into its SINGLE_ONE or SINGLE_ZERO opcode.
+static uint8_t tx_bit_code(uint32_t vector, uint8_t shift)
+{
+    return ((vector >> shift) & 1) ? SINGLE_ONE : SINGLE_ZERO;
+}
+
+//Look up a packet image by key.
+//Returns a pointer to the cached image, or NULL if there is none.
+static tx_image_t * tx_image_cache_find(const tx_image_key_t * p_key)
+{
+    uint8_t    loop_entry    =    0;
+
+    for(loop_entry=0; loop_entry<TX_IMAGE_CACHE_ENTRIES; loop_entry++)
+    {
+        if(memcmp(&m_tx_image_cache[loop_entry].key,p_key,sizeof(tx_image_key_t)) == 0)
+            return &m_tx_image_cache[loop_entry].image;
+    }
+
+    return NULL;
+}
+
+//Claim a cache entry for a new key, replacing the oldest one.
+//Returns a pointer to the (empty) image of the claimed entry, ready to be compiled into.
+static tx_image_t * tx_image_cache_claim(const tx_image_key_t * p_key)
+{
+    tx_image_cache_entry_t *    p_entry    =    &m_tx_image_cache[m_tx_image_cache_next];
+
+    m_tx_image_cache_next    =    (m_tx_image_cache_next+1) % TX_IMAGE_CACHE_ENTRIES;
+
+    p_entry->key             =    *p_key;
+    p_entry->image.length    =    0;
+
+    return &p_entry->image;
+}
+
+//Compile a select packet with an EPC into a packet image. The image is the same whichever of the two select slots it is loaded into.
+//This function draws from many different EPC sources.
 
 //061020 - Now that we are accepting EPCs with less than MAX_EPC_LENGTH_IN_BYTES through the app and software,
 //we need to ensure that we don't load such EPCs to the select packet during search and program.
 //We'll leave that to the functions in rfidr_state.c to ensure when this function is called,
 //the epc_length_in_bytes argument is set to MAX_EPC_LENGTH_IN_BYTES
 
-rfidr_error_t load_select_packet_only(rfidr_select_epc_type_t epc_type, uint8_t epc_length_in_bytes, rfidr_select_packet_type_t packet_type)
+static void compile_select_image(rfidr_select_epc_type_t epc_type, uint8_t epc_length_in_bytes, tx_image_t * p_image)
 {
     uint8_t         temp_epc[MAX_EPC_LENGTH_IN_BYTES];    //We'll use this to store the pointer to the array to be utilized.
     uint32_t        select_vector_begin    =    0;        //This variable stores the beginning of the select packet, prior to the EPC and truncation-bit.
     uint64_t        select_vector[2]       =    {0};      //This variable stores the complete select packet, including the EPC but not the truncation-bit.
     uint8_t         loop_sram              =    0;        //A loop variable.
-    uint16_t        radio_sram_addr        =    0;        //The address in the FPGA radio SRAM to which data will be written.
     uint8_t         index_msb              =    0;        //A variable to hold the select vector index to be used when extracting bit-wise data from the select vector.
     uint8_t         shift_msb              =    0;        //A variable to index the select vector to extract the bit-wise data from the vector.
     uint8_t         index_lsb              =    0;        //A variable to hold the select vector index to be used when extracting bit-wise data from the select vector.
     uint8_t         shift_lsb              =    0;        //A variable to index the select vector to extract the bit-wise data from the vector.
     uint8_t         loop_load              =    0;
-    rfidr_error_t   error_code             =    RFIDR_SUCCESS;
 
     //Select which EPC source to be utilized
     for(loop_load=0; loop_load<epc_length_in_bytes; loop_load++)
@@ -503,19 +712,10 @@ rfidr_error_t load_select_packet_only(rfidr_select_epc_type_t epc_type, uint8_t
             //We will put this zero in manually later on.
     }
 
-    //Set the radio SRAM starting address to write data to. 
-    if(packet_type==SEL_PACKET_NO_2)
-        radio_sram_addr     =    TX_RAM_ADDR_OFFSET_SEL_2 << 4;    //For a second select packet.
-    else
-        radio_sram_addr     =    TX_RAM_ADDR_OFFSET_SELECT << 4; //For the first select packet.
-
-    //Load the opcodes into TX RAM. Convert single bits into opcodes where necessary.
-    error_code    =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_SELECT,radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
+    //Emit the opcodes. Convert single bits into opcodes where necessary.
+    tx_image_emit(p_image,DUMMY_ZERO,BEGIN_SELECT);
     //59 is the bit index of the first bit of the select_vector_begin section
-    error_code    =    merge_and_write_tx_ram(((select_vector[1] >> 59) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL,radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
-    
+    tx_image_emit(p_image,((select_vector[1] >> 59) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL);
 
     for(loop_sram=0;loop_sram < ((7+(epc_length_in_bytes << 1)) << 1)-1;loop_sram++) //(7+2*epc_length)*2 is the number of 2-bit pairs we need to add to the tx ram. For the last of these, need to add a SINGLE_ZERO for "no epc truncation"
     {
@@ -524,8 +724,7 @@ rfidr_error_t load_select_packet_only(rfidr_select_epc_type_t epc_type, uint8_t
         index_lsb    =    ((122-(loop_sram<<1)) >> 6) & 1;    //For loop_sram=0, will be 1. Will remain 1 until all of the bits from select_vector[1] are sent out.
         shift_lsb    =    (122-(loop_sram<<1)) % 64;            //For loop_sram=0, starts at bit 58, the second bit of the select_vector_begin section.
 
-        error_code    =    merge_and_write_tx_ram(((select_vector[index_msb] >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((select_vector[index_lsb] >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-                if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(p_image,((select_vector[index_msb] >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((select_vector[index_lsb] >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
     }
     
     //Take care of the final bit and the "no EPC truncation" zero entry required in the select packet.
@@ -535,12 +734,46 @@ rfidr_error_t load_select_packet_only(rfidr_select_epc_type_t epc_type, uint8_t
     index_lsb    =    ((122-(loop_sram<<1)) >> 6) & 1;
     shift_lsb    =    (122-(loop_sram<<1)) % 64;
 
-    error_code    =    merge_and_write_tx_ram(SINGLE_ZERO,((select_vector[index_lsb] >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code    =    merge_and_write_tx_ram(END_PACKET,INSERT_CRC16,radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
-    
-    return RFIDR_SUCCESS;
+    tx_image_emit(p_image,SINGLE_ZERO,((select_vector[index_lsb] >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
+    tx_image_emit(p_image,END_PACKET,INSERT_CRC16);
+}
+
+//Load a select packet with an EPC into the 'select' section of the TX RAM.
+//This function can load into either of the two select packet addresses in the FPGA and
+//draws from many different EPC sources. The packet is compiled once and then served from the image cache.
+
+rfidr_error_t load_select_packet_only(rfidr_select_epc_type_t epc_type, uint8_t epc_length_in_bytes, rfidr_select_packet_type_t packet_type)
+{
+    tx_image_key_t    key;
+    tx_image_t *      p_image            =    NULL;
+    uint16_t          radio_sram_addr    =    0;        //The address in the FPGA radio SRAM to which data will be written.
+
+    epc_length_in_bytes    =    MIN(epc_length_in_bytes,MAX_EPC_LENGTH_IN_BYTES);
+
+    memset(&key,0,sizeof(key));
+    key.kind          =    TX_IMAGE_KIND_SELECT;
+    key.epc_type      =    (uint8_t)epc_type;
+    key.epc_length    =    epc_length_in_bytes;
+    key.params[0]     =    m_select_raw.command;
+    key.params[1]     =    (uint8_t)m_select_raw.target;
+    key.params[2]     =    (uint8_t)m_select_raw.action;
+    key.params[3]     =    m_select_raw.membank;
+    key.params[4]     =    m_select_raw.pointer;
+
+    p_image    =    tx_image_cache_find(&key);
+    if(p_image == NULL)
+    {
+        p_image    =    tx_image_cache_claim(&key);
+        compile_select_image(epc_type,epc_length_in_bytes,p_image);
+    }
+
+    //Set the radio SRAM starting address to write data to. 
+    if(packet_type==SEL_PACKET_NO_2)
+        radio_sram_addr     =    TX_RAM_ADDR_OFFSET_SEL_2 << 4;    //For a second select packet.
+    else
+        radio_sram_addr     =    TX_RAM_ADDR_OFFSET_SELECT << 4; //For the first select packet.
+
+    return tx_ram_shadow_write(radio_sram_addr,p_image->length,p_image->bytes);
 }
 
 //Bitwise-construct a dummy select packet and load it into the 'select' section of the TX RAM.
@@ -556,72 +789,43 @@ rfidr_error_t load_dummy_select_packet_only()
     return error_code;
 }
 
-//This file computes the 5-bit CRC to be appended to the Query command.
-//The function has to be run during load-time of the Query section of the TX RAM.
-static uint8_t compute_query_crc5(uint32_t query_vector_begin)
+//Command, DR, M, TRext and Sel bits of the 17 bits of a Query ahead of its CRC5.
+//These stay fixed between rounds.
+static uint32_t query_fixed_bits(void)
 {
-    uint8_t    state       =    9;        //This is what Sec F.1 of the RFID specification tells us to start out with
-    uint8_t    state_new   =    0;
-    uint8_t    mask        =    31;        //5-bit LSB mask
-    uint8_t    length      =    17;        //The length of the query vector prior to adding the 5 CRC bits
-    uint8_t    loop_crc    =    0;
-    uint8_t    xor_bit     =    0;
-
-    for(loop_crc=0; loop_crc<length; loop_crc++)
-    {
-        xor_bit       =  ((query_vector_begin >> (length-1-loop_crc)) & 1) ^ ((state >> 4) & 1);
-        state_new     =  0;
-        state_new    |=  (((state >> 3) & 1) << 4);
-        state_new    |=  ((((state >> 2) & 1) ^ xor_bit ) << 3);
-        state_new    |=  (((state >> 1) & 1) << 2);
-        state_new    |=  (((state >> 0) & 1) << 1);
-        state_new    |=  xor_bit;
-        state         =   state_new & mask;
-    }
-
-return state;
-}
-
-//Bitwise-construct a Query command with an EPC and load it into the 'select' section of the TX RAM.
-//We modify this function to also support fast writes of the query packet when all we want to do is
-//flip the tag to be queried. This is the case when we want to rapidly track a single tag by
-//repeated fast EPC writes. The tag-tracking feature came about through discussions with the Sample
-//Group at the University of Michigan in early 2020.
-
-rfidr_error_t load_query_packet_only(rfidr_query_flagswap_t flagswap)
-{
-    uint32_t         query_vector_begin    =    0;
-    uint32_t         query_vector          =    0;
-    uint8_t          crc5                  =    0;
-    uint8_t          loop_sram             =    0;
-    uint16_t         radio_sram_addr       =    0;
-    uint8_t          shift_msb             =    0;
-    uint8_t          shift_lsb             =    0;
-    rfidr_error_t    error_code            =    RFIDR_SUCCESS;
-
-    //Convert the query_raw struct into a 28-bit bit string
+    uint32_t         bits                  =    0;
 
     //4-bit command
-    query_vector_begin |= ((m_query_raw.command & 15) << 13);
+    bits |= ((m_query_raw.command & 15) << 13);
 
     //1-bit dr
-    query_vector_begin |= ((m_query_raw.dr & 1) << 12);
+    bits |= ((m_query_raw.dr & 1) << 12);
 
     //2-bit mod_index
-    query_vector_begin |= ((m_query_raw.mod_index & 3) << 10);
+    bits |= ((m_query_raw.mod_index & 3) << 10);
 
     //1-bit trext
-    query_vector_begin |= ((m_query_raw.trext & 1) << 9);
+    bits |= ((m_query_raw.trext & 1) << 9);
 
     //2 bit sel
     switch(m_query_raw.sel)
     {
-        case SEL_ALL: query_vector_begin |= (0 << 7); break;
-        case SEL_NSL: query_vector_begin |= (2 << 7); break;
-        case SEL_PSL: query_vector_begin |= (3 << 7); break;
-        default:  query_vector_begin |= (0 << 7); break;
+        case SEL_ALL: bits |= (0 << 7); break;
+        case SEL_NSL: bits |= (2 << 7); break;
+        case SEL_PSL: bits |= (3 << 7); break;
+        default:  bits |= (0 << 7); break;
     }
 
+    return bits;
+}
+
+//Complete the 17 bits of a Query from its fixed bits and the current session, target and Q, and append the CRC5.
+//returns the 22-bit Query command
+static uint32_t query_vector_from(uint32_t fixed_bits)
+{
+    uint32_t         query_vector_begin    =    fixed_bits;
+    uint8_t          crc5                  =    0;
+
     //2 bit session
     switch(m_query_raw.session)
     {
@@ -632,7 +836,7 @@ rfidr_error_t load_query_packet_only(rfidr_query_flagswap_t flagswap)
         default: query_vector_begin |= (2 << 5); break;
     }
 
-    //1 bit session
+    //1 bit target
     switch(m_query_raw.target)
     {
         case TARGET_A: query_vector_begin |= (0 << 4); break;
@@ -643,45 +847,99 @@ rfidr_error_t load_query_packet_only(rfidr_query_flagswap_t flagswap)
     //4 bit Q
     query_vector_begin |= ((m_query_raw.query_q & 15) << 0);
 
-    //Compute the 5-bit CRC
-    crc5            =    compute_query_crc5(query_vector_begin);
+    //Compute the 5-bit CRC over the 17 bits ahead of it (Sec F.1 of the RFID specification).
+    crc5    =    rfidr_crc5_compute(query_vector_begin,17);
     //Assemble the final string of binary bits that make up the Query command.
-    query_vector    =    ((query_vector_begin << 5) | (uint32_t)crc5) & (uint32_t)((1 << 22)-1);
+    return ((query_vector_begin << 5) | (uint32_t)crc5) & (uint32_t)((1 << 22)-1);
+}
 
-    //Load opcodes into the TX RAM, converting binary 1's and 0's into opcodes where necessary.
-    radio_sram_addr     =    TX_RAM_ADDR_OFFSET_QUERY << 4;
-    if(flagswap==FLAGSWAP_NO)
-    {
-        error_code      =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_REGULAR,radio_sram_addr++);       if(error_code != RFIDR_SUCCESS){return error_code;}
-        error_code      =    merge_and_write_tx_ram(TRCAL,RTCAL,radio_sram_addr++);                    if(error_code != RFIDR_SUCCESS){return error_code;}
-    }
-    else
+//Convert num_bytes bytes of a query image, starting at image byte first_byte, from the Query command bits.
+//Image bytes 2-12 each carry two command bits, MSB first.
+static void query_image_bytes(uint32_t query_vector, uint8_t first_byte, uint8_t num_bytes, uint8_t * p_bytes)
+{
+    uint8_t          loop_byte             =    0;
+    uint8_t          shift                 =    0;
+
+    for(loop_byte=0;loop_byte<num_bytes;loop_byte++)
     {
-        radio_sram_addr+=2;
+        shift                 =    20-((first_byte+loop_byte-2) << 1);
+        p_bytes[loop_byte]    =    merge_code_nibbles(tx_bit_code(query_vector,shift),tx_bit_code(query_vector,shift+1));
     }
+}
 
-    for(loop_sram=0;loop_sram<=10;loop_sram++)
-    {
-        shift_msb       =    20-(loop_sram<<1);
-        shift_lsb       =    21-(loop_sram<<1);
+//Compile a complete Query command into a packet image.
+//The image is 14 bytes: the 2-byte preamble, 11 bytes of command bits and CRC5, then the TXCW0/END_PACKET byte.
 
-        if(flagswap==FLAGSWAP_NO || loop_sram >= 6)    //For flagswap yes, overwrite A/B, Q, CRC5
-        {
-            error_code    =    merge_and_write_tx_ram(((query_vector >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((query_vector >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-            if(error_code != RFIDR_SUCCESS){return error_code;}
-        }
-        else
-        {
-            radio_sram_addr++;
-        }
-    }
-    
-    if(flagswap==FLAGSWAP_NO)
+static void compile_query_image(tx_image_t * p_image)
+{
+    //Emit opcodes, converting binary 1's and 0's into opcodes where necessary.
+    tx_image_emit(p_image,DUMMY_ZERO,BEGIN_REGULAR);
+    tx_image_emit(p_image,TRCAL,RTCAL);
+    query_image_bytes(query_vector_from(query_fixed_bits()),2,11,&p_image->bytes[p_image->length]);
+    p_image->length    +=    11;
+    tx_image_emit(p_image,TXCW0,END_PACKET);
+}
+
+//Build the key of the query settings which stay fixed between rounds.
+//Session, target and Q are left out: the flag swaps of tag tracking and the switches between search and tracking must not force a rebuild.
+static void query_key(tx_image_key_t * p_key)
+{
+    memset(p_key,0,sizeof(tx_image_key_t));
+    p_key->kind         =    TX_IMAGE_KIND_QUERY;
+    p_key->params[0]    =    m_query_raw.command;
+    p_key->params[1]    =    m_query_raw.dr;
+    p_key->params[2]    =    m_query_raw.mod_index;
+    p_key->params[3]    =    m_query_raw.trext;
+    p_key->params[4]    =    (uint8_t)m_query_raw.sel;
+}
+
+//Compile the query image once under the current settings and keep what does not depend on session, target or Q.
+rfidr_error_t prepare_query_packet(void)
+{
+    tx_image_t    image;
+
+    image.length          =    0;
+    compile_query_image(&image);
+    memcpy(m_query_head,image.bytes,QUERY_IMAGE_SESSION_BYTE);
+    m_query_end           =    image.bytes[QUERY_IMAGE_LENGTH-1];
+    m_query_fixed_bits    =    query_fixed_bits();
+    query_key(&m_query_key);
+
+    return RFIDR_SUCCESS;
+}
+
+//Load a Query command into the 'query' section of the TX RAM.
+//We modify this function to also support fast writes of the query packet when all we want to do is
+//flip the tag to be queried. This is the case when we want to rapidly track a single tag by
+//repeated fast EPC writes. The tag-tracking feature came about through discussions with the Sample
+//Group at the University of Michigan in early 2020.
+//The head of the packet is recomputed first only if the settings which stay fixed between rounds have changed.
+//Since the write goes through the TX RAM shadow, a change of Q or target alone only sends the bytes which differ.
+
+rfidr_error_t load_query_packet_only(rfidr_query_flagswap_t flagswap)
+{
+    tx_image_key_t    key;
+    uint8_t           image[QUERY_IMAGE_LENGTH];
+    uint32_t          query_vector       =    0;
+    uint16_t          radio_sram_addr    =    TX_RAM_ADDR_OFFSET_QUERY << 4;
+
+    query_key(&key);
+    if(memcmp(&key,&m_query_key,sizeof(tx_image_key_t)) != 0)
+        prepare_query_packet();
+
+    query_vector    =    query_vector_from(m_query_fixed_bits);
+
+    if(flagswap==FLAGSWAP_YES)    //For flagswap yes, overwrite A/B, Q, CRC5 only
     {
-        error_code    =    merge_and_write_tx_ram(TXCW0,END_PACKET,radio_sram_addr++); if(error_code != RFIDR_SUCCESS){return error_code;}
+        query_image_bytes(query_vector,QUERY_IMAGE_FLAGSWAP_START,QUERY_IMAGE_FLAGSWAP_LENGTH,image);
+        return tx_ram_shadow_write(radio_sram_addr+QUERY_IMAGE_FLAGSWAP_START,QUERY_IMAGE_FLAGSWAP_LENGTH,image);
     }
 
-    return RFIDR_SUCCESS;
+    memcpy(image,m_query_head,QUERY_IMAGE_SESSION_BYTE);
+    query_image_bytes(query_vector,QUERY_IMAGE_SESSION_BYTE,QUERY_IMAGE_LENGTH-1-QUERY_IMAGE_SESSION_BYTE,&image[QUERY_IMAGE_SESSION_BYTE]);
+    image[QUERY_IMAGE_LENGTH-1]    =    m_query_end;
+
+    return tx_ram_shadow_write(radio_sram_addr,QUERY_IMAGE_LENGTH,image);
 }
 
 //Bitwise-construct a Write-16 bits command and load it into the TX RAM 
@@ -700,7 +958,7 @@ static rfidr_error_t load_write_packet_16b(rfidr_write_offset_t write_offset, rf
     uint8_t          shift_msb           =    0;
     uint8_t          shift_lsb           =    0;
     uint8_t          write_byte          =    0;
-    rfidr_error_t    error_code          =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     //Build the components of a write-16b command into a 18-bit bit string
     
@@ -725,43 +983,42 @@ static rfidr_error_t load_write_packet_16b(rfidr_write_offset_t write_offset, rf
         default:                 radio_sram_addr     =    (TX_RAM_ADDR_OFFSET_WRITE0 << 4) + (0 << 3);    break;
     }
 
-    //Write opcodes to TX RAM, converting binary 1's and 0's to opcodes where necessary.
+    //Compile the opcodes into a packet image, converting binary 1's and 0's to opcodes where necessary.
     //Both the kill packet and the write packet start off in the same fashion
     
-    error_code            =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_REGULAR,radio_sram_addr++); if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length          =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_REGULAR);
     
     //Next, finish writing the command bits no matter which mode we are in.
 
     if(write_mode==KILL_WRITE_MODE)
     {
         //Note that since the command vector is shorter for the kill packet, we must have the first bits out operate differently
-        error_code            =    merge_and_write_tx_ram(((write_16b_vector >> 7) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL,radio_sram_addr++); if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,((write_16b_vector >> 7) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL);
         
         for(loop_sram=0;loop_sram <3;loop_sram++)
         {
             shift_msb         =    5-(loop_sram<<1);
             shift_lsb         =    6-(loop_sram<<1);
 
-            error_code        =    merge_and_write_tx_ram(((write_16b_vector >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_16b_vector >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-            if(error_code != RFIDR_SUCCESS){return error_code;}
+            tx_image_emit(&image,((write_16b_vector >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_16b_vector >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
         }    
     } 
     else //For a regular WRITE here.
     {
-        error_code            =    merge_and_write_tx_ram(((write_16b_vector >> 17) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL,radio_sram_addr++); if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,((write_16b_vector >> 17) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),RTCAL);
         
         for(loop_sram=0;loop_sram < 8;loop_sram++)
         {
             shift_msb         =    15-(loop_sram<<1);
             shift_lsb         =    16-(loop_sram<<1);
 
-            error_code        =    merge_and_write_tx_ram(((write_16b_vector >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_16b_vector >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-            if(error_code != RFIDR_SUCCESS){return error_code;}
+            tx_image_emit(&image,((write_16b_vector >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_16b_vector >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
         }
     }
     
     //Both a kill and a write are finished off in the same fashion, with the last bit of the control vector and the XOR_NEXT_16B.
-    error_code            =    merge_and_write_tx_ram((XOR_NEXT_16B),((write_16b_vector >> 0) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++); if(error_code != RFIDR_SUCCESS){return error_code;}
+    tx_image_emit(&image,(XOR_NEXT_16B),((write_16b_vector >> 0) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
     
     //For both kill and a write, we have two bytes of payload data to transmit. 
     for(loop_byte=0;loop_byte < 2;loop_byte++)
@@ -776,9 +1033,7 @@ static rfidr_error_t load_write_packet_16b(rfidr_write_offset_t write_offset, rf
             shift_msb        =    6-(loop_sram<<1);
             shift_lsb        =    7-(loop_sram<<1);
 
-            error_code       =    merge_and_write_tx_ram(((write_byte >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_byte >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),radio_sram_addr++);
-            
-            if(error_code != RFIDR_SUCCESS){return error_code;}
+            tx_image_emit(&image,((write_byte >> shift_msb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO),((write_byte >> shift_lsb) & 1) ? (SINGLE_ONE) : (SINGLE_ZERO));
         }
     }
     
@@ -787,16 +1042,16 @@ static rfidr_error_t load_write_packet_16b(rfidr_write_offset_t write_offset, rf
     
     if(write_mode==KILL_WRITE_MODE)
     {
-        error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);                                            if(error_code != RFIDR_SUCCESS){return error_code;}
-        error_code          =    merge_and_write_tx_ram(INSERT_HANDLE, SINGLE_ZERO,radio_sram_addr++);                                        if(error_code != RFIDR_SUCCESS){return error_code;}
-        error_code          =    merge_and_write_tx_ram(is_last_write==LAST_WRITE_YES ? LAST_WRITE : END_PACKET, INSERT_CRC16,radio_sram_addr++);             if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+        tx_image_emit(&image,INSERT_HANDLE, SINGLE_ZERO);
+        tx_image_emit(&image,is_last_write==LAST_WRITE_YES ? LAST_WRITE : END_PACKET, INSERT_CRC16);
     } 
     else //If write_mode is a regular write
     {
-        error_code          =    merge_and_write_tx_ram(INSERT_CRC16,INSERT_HANDLE,radio_sram_addr++);                                         if(error_code != RFIDR_SUCCESS){return error_code;}
-        error_code          =    merge_and_write_tx_ram(TXCW0,is_last_write==LAST_WRITE_YES ? LAST_WRITE : END_PACKET,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}    
+        tx_image_emit(&image,INSERT_CRC16,INSERT_HANDLE);
+        tx_image_emit(&image,TXCW0,is_last_write==LAST_WRITE_YES ? LAST_WRITE : END_PACKET);    
     }
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //This is the wrapper for writing the 96-bit new EPC to TX RAM.
@@ -860,7 +1115,7 @@ static rfidr_error_t load_txcw0_packet(void)
 rfidr_error_t load_query_rep_packet(void)
 {
     uint16_t         radio_sram_addr               =    0;
-    rfidr_error_t    error_code                    =    0;
+    tx_image_t       image;
     uint8_t          session_code_1                =    SINGLE_ONE;
     uint8_t          session_code_0                =    SINGLE_ZERO;
     uint8_t          loop_sram                     =    0;
@@ -874,21 +1129,22 @@ rfidr_error_t load_query_rep_packet(void)
         default:            session_code_1    =    SINGLE_ONE; session_code_0     =    SINGLE_ZERO; break;
     }
 
-    //Write opcodes to TX RAM, converting bits to opcodes where necessary
+    //Compile the opcodes into a packet image, converting bits to opcodes where necessary
     radio_sram_addr       =    TX_RAM_ADDR_OFFSET_QRY_REP << 4;
-    error_code            =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);       if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(SINGLE_ZERO,RTCAL,radio_sram_addr++);            if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(session_code_1,SINGLE_ZERO,radio_sram_addr++);   if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(END_PACKET,session_code_0,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length          =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ZERO,RTCAL);
+    tx_image_emit(&image,session_code_1,SINGLE_ZERO);
+    tx_image_emit(&image,END_PACKET,session_code_0);
     
     
     for(loop_sram=0; loop_sram < 3; loop_sram++)
     {
         //Overwrite data that could be overwritten by QueryAdjust with the opcode that translates to 4'b0000.
-        error_code        =    merge_and_write_tx_ram(TXCW0,TXCW0,radio_sram_addr++);                  if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,TXCW0,TXCW0);
     }
 
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a Query Adjust command and load it into the TX RAM .
@@ -898,7 +1154,7 @@ rfidr_error_t load_query_rep_packet(void)
 rfidr_error_t load_query_adj_packet(bool up_downb)
 {
     uint16_t         radio_sram_addr              =    0;
-    rfidr_error_t    error_code                   =    0;
+    tx_image_t       image;
     uint8_t          session_code_1               =    SINGLE_ONE;
     uint8_t          session_code_0               =    SINGLE_ZERO;
     uint8_t          updown_code_2                =    SINGLE_ONE;
@@ -929,17 +1185,18 @@ rfidr_error_t load_query_adj_packet(bool up_downb)
     //Then after the next pass of control back to the MCU, the regular Query Rep packet will be loaded into this RAM slot.
     //This is just for demonstration purposes - it's difficult to envision at the moment when QueryAdjust would be advantageously used.
     
-    //Write opcodes to TX RAM, converting bits to opcodes where necessary
+    //Compile the opcodes into a packet image, converting bits to opcodes where necessary
     radio_sram_addr     =    TX_RAM_ADDR_OFFSET_QRY_REP << 4;
-    error_code          =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);            if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ONE,RTCAL,radio_sram_addr++);                  if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);           if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(session_code_1,SINGLE_ONE,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(updown_code_2,session_code_0,radio_sram_addr++);      if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(updown_code_0,updown_code_1,radio_sram_addr++);       if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(TXCW0,END_PACKET,radio_sram_addr++);                  if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length        =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ONE,RTCAL);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,session_code_1,SINGLE_ONE);
+    tx_image_emit(&image,updown_code_2,session_code_0);
+    tx_image_emit(&image,updown_code_0,updown_code_1);
+    tx_image_emit(&image,TXCW0,END_PACKET);
     
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 
 }
 
@@ -948,83 +1205,88 @@ rfidr_error_t load_query_adj_packet(bool up_downb)
 static rfidr_error_t load_ack_handle_packet(void)
 {
     uint16_t         radio_sram_addr               =    0;
-    rfidr_error_t    error_code                    =    0;
+    tx_image_t       image;
 
     radio_sram_addr    =    TX_RAM_ADDR_OFFSET_ACK_HDL << 4;
-    error_code         =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);           if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code         =    merge_and_write_tx_ram(SINGLE_ZERO,RTCAL,radio_sram_addr++);                if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code         =    merge_and_write_tx_ram(INSERT_HANDLE,SINGLE_ONE,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code         =    merge_and_write_tx_ram(TXCW0,END_PACKET,radio_sram_addr++);                 if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length       =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ZERO,RTCAL);
+    tx_image_emit(&image,INSERT_HANDLE,SINGLE_ONE);
+    tx_image_emit(&image,TXCW0,END_PACKET);
 
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct an ACK (with RN16) command and load it into the TX RAM.
 static rfidr_error_t load_ack_rn16_packet(void)
 {
     uint16_t         radio_sram_addr              =    0;
-    rfidr_error_t    error_code                   =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     radio_sram_addr     =    TX_RAM_ADDR_OFFSET_ACK_RN16 << 4;
-    error_code          =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,RTCAL,radio_sram_addr++);               if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(INSERT_RN16,SINGLE_ONE,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(TXCW0,END_PACKET,radio_sram_addr++);                if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length        =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ZERO,RTCAL);
+    tx_image_emit(&image,INSERT_RN16,SINGLE_ONE);
+    tx_image_emit(&image,TXCW0,END_PACKET);
 
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a NAK command and load it into the TX RAM.
 static rfidr_error_t load_nak_packet(void)
 {
     uint16_t         radio_sram_addr               =    0;
-    rfidr_error_t    error_code                    =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     radio_sram_addr     =    TX_RAM_ADDR_OFFSET_NAK << 4;
-    error_code          =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ONE,RTCAL,radio_sram_addr++);                if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ONE,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(NAK_END,SINGLE_ZERO,radio_sram_addr++);             if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(TXCW0,END_PACKET,radio_sram_addr++);                if(error_code != RFIDR_SUCCESS){return error_code;}
-
-    return    RFIDR_SUCCESS;
+    image.length        =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ONE,RTCAL);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ONE);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,NAK_END,SINGLE_ZERO);
+    tx_image_emit(&image,TXCW0,END_PACKET);
+
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a Request Handle command and load it into the TX RAM.
 static rfidr_error_t load_reqhdl_packet(void)
 {
     uint16_t         radio_sram_addr               =    0;
-    rfidr_error_t    error_code                    =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     radio_sram_addr     =    TX_RAM_ADDR_OFFSET_REQHDL << 4;
-    error_code          =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ONE,RTCAL,radio_sram_addr++);                if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ONE,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(INSERT_RN16,SINGLE_ONE,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(END_PACKET,INSERT_CRC16,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-
-    return RFIDR_SUCCESS;
+    image.length        =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ONE,RTCAL);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ONE);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,INSERT_RN16,SINGLE_ONE);
+    tx_image_emit(&image,END_PACKET,INSERT_CRC16);
+
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a Request RN16 command and load it into the TX RAM.
 static rfidr_error_t load_reqrn16_packet(void)
 {
     uint16_t         radio_sram_addr               =    TX_RAM_ADDR_OFFSET_REQRN16 << 4;;
-    rfidr_error_t    error_code                    =    RFIDR_SUCCESS;
-
-    error_code          =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_IMMED,radio_sram_addr++);           if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ONE,RTCAL,radio_sram_addr++);                 if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ONE,radio_sram_addr++);           if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(SINGLE_ZERO,SINGLE_ZERO,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(INSERT_HANDLE,SINGLE_ONE,radio_sram_addr++);         if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code          =    merge_and_write_tx_ram(END_PACKET,INSERT_CRC16,radio_sram_addr++);          if(error_code != RFIDR_SUCCESS){return error_code;}
-
-    return RFIDR_SUCCESS;
+    tx_image_t       image;
+
+    image.length        =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_IMMED);
+    tx_image_emit(&image,SINGLE_ONE,RTCAL);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ONE);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,SINGLE_ZERO,SINGLE_ZERO);
+    tx_image_emit(&image,INSERT_HANDLE,SINGLE_ONE);
+    tx_image_emit(&image,END_PACKET,INSERT_CRC16);
+
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a LOCK command and load it into the TX RAM.
@@ -1037,7 +1299,7 @@ static rfidr_error_t load_lock_packet(void)
     uint16_t         radio_sram_addr              =    0;
     uint8_t          shift_msb                    =    0;
     uint8_t          shift_lsb                    =    0;
-    rfidr_error_t    error_code                   =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     //Build the components of a lock command into a 28-bit bit string
 
@@ -1045,24 +1307,24 @@ static rfidr_error_t load_lock_packet(void)
     lock_vector |= ((32 & 1023) << 10);    //Don't do anything for the time being. Use 32 for temp. lock of epc.
     lock_vector |= ((0 & 1023) << 0);      //Don't do anything for the time being. Use 32 for temp. lock of epc, 0 to unlock.
 
-    //Write opcodes to TX RAM, converting 1's and 0's to opcodes where necessary.
+    //Compile the opcodes into a packet image, converting 1's and 0's to opcodes where necessary.
     radio_sram_addr       =    TX_RAM_ADDR_OFFSET_LOCK << 4;
-    error_code            =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_REGULAR,radio_sram_addr++);                                      if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(((lock_vector >> 27) & 1) ? SINGLE_ONE : SINGLE_ZERO,RTCAL,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length          =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_REGULAR);
+    tx_image_emit(&image,((lock_vector >> 27) & 1) ? SINGLE_ONE : SINGLE_ZERO,RTCAL);
 
     for(loop_sram=0;loop_sram < 13;loop_sram++)
     {
         shift_msb            =    25-(loop_sram<<1);
         shift_lsb            =    26-(loop_sram<<1);
 
-        error_code           =    merge_and_write_tx_ram(((lock_vector >> shift_msb) & 1) ? SINGLE_ONE : SINGLE_ZERO,((lock_vector >> shift_lsb) & 1) ? SINGLE_ONE : SINGLE_ZERO,radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,((lock_vector >> shift_msb) & 1) ? SINGLE_ONE : SINGLE_ZERO,((lock_vector >> shift_lsb) & 1) ? SINGLE_ONE : SINGLE_ZERO);
     }
 
-    error_code            =    merge_and_write_tx_ram(INSERT_HANDLE,((lock_vector >> 0) & 1) ? SINGLE_ONE : SINGLE_ZERO,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(END_PACKET,INSERT_CRC16,radio_sram_addr++);                                              if(error_code != RFIDR_SUCCESS){return error_code;}
+    tx_image_emit(&image,INSERT_HANDLE,((lock_vector >> 0) & 1) ? SINGLE_ONE : SINGLE_ZERO);
+    tx_image_emit(&image,END_PACKET,INSERT_CRC16);
 
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Bitwise-construct a READ command and load it into the TX RAM.
@@ -1074,7 +1336,7 @@ static rfidr_error_t load_read_packet(void)
     uint16_t        radio_sram_addr              =    0;
     uint8_t         shift_msb                    =    0;
     uint8_t          shift_lsb                   =    0;
-    rfidr_error_t    error_code                  =    RFIDR_SUCCESS;
+    tx_image_t       image;
 
     //Build the components of a read command into a 24-bit bit string
 
@@ -1083,24 +1345,24 @@ static rfidr_error_t load_read_packet(void)
     read_vector |= ((2 & 255) << 8);       //Strictly target EPC word pointer #2
     read_vector |= ((6 & 255) << 0);       //Read 6 16-bit words (96 bit epc).
 
-    //Write opcodes to TX RAM, converting 1's and 0's to opcodes where necessary.
+    //Compile the opcodes into a packet image, converting 1's and 0's to opcodes where necessary.
     radio_sram_addr       =    TX_RAM_ADDR_OFFSET_READ << 4;
-    error_code            =    merge_and_write_tx_ram(DUMMY_ZERO,BEGIN_REGULAR,radio_sram_addr++);                                      if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(((read_vector >> 25) & 1) ? SINGLE_ONE : SINGLE_ZERO,RTCAL,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
+    image.length          =    0;
+    tx_image_emit(&image,DUMMY_ZERO,BEGIN_REGULAR);
+    tx_image_emit(&image,((read_vector >> 25) & 1) ? SINGLE_ONE : SINGLE_ZERO,RTCAL);
 
     for(loop_sram=0;loop_sram < 12;loop_sram++)
     {
         shift_msb         =    23-(loop_sram<<1);
         shift_lsb         =    24-(loop_sram<<1);
 
-        error_code        =    merge_and_write_tx_ram(((read_vector >> shift_msb) & 1) ? SINGLE_ONE : SINGLE_ZERO,((read_vector >> shift_lsb) & 1) ? SINGLE_ONE : SINGLE_ZERO,radio_sram_addr++);
-        if(error_code != RFIDR_SUCCESS){return error_code;}
+        tx_image_emit(&image,((read_vector >> shift_msb) & 1) ? SINGLE_ONE : SINGLE_ZERO,((read_vector >> shift_lsb) & 1) ? SINGLE_ONE : SINGLE_ZERO);
     }
 
-    error_code            =    merge_and_write_tx_ram(INSERT_HANDLE,((read_vector >> 0) & 1) ? SINGLE_ONE : SINGLE_ZERO,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
-    error_code            =    merge_and_write_tx_ram(END_PACKET,INSERT_CRC16,radio_sram_addr++);    if(error_code != RFIDR_SUCCESS){return error_code;}
+    tx_image_emit(&image,INSERT_HANDLE,((read_vector >> 0) & 1) ? SINGLE_ONE : SINGLE_ZERO);
+    tx_image_emit(&image,END_PACKET,INSERT_CRC16);
 
-    return RFIDR_SUCCESS;
+    return tx_ram_shadow_write(radio_sram_addr,image.length,image.bytes);
 }
 
 //Quickly load up the FPGA TX RAM with a set of default commands so that if
@@ -284,6 +284,12 @@ rfidr_error_t load_dummy_select_packet_only(void);
 
 rfidr_error_t load_query_packet_only(rfidr_query_flagswap_t flagswap);
 
+//function for precomputing the part of the query packet which only depends on the command, DR, M, TRext and Sel settings
+//call this at the start of an inventory round so that later changes of Q, session or target only patch the bytes that differ
+//returns RFIDR_SUCCESS on successful field buffer set
+
+rfidr_error_t prepare_query_packet(void);
+
 //function for loading just the query rep packet
 //returns RFIDR_SUCCESS on successful field buffer set
 
@@ -315,4 +321,18 @@ rfidr_error_t load_write_packet_only_kill_command(void);
 
 rfidr_error_t load_rfidr_txram_default(void);
 
+//function for discarding the MCU-side shadow of the TX RAM, e.g. after the FPGA has been reset
+//the next load of each packet will then write every byte to TX RAM
+
+void invalidate_tx_ram_shadow(void);
+
+//function for reading how many TX RAM bytes were written over SPI and how many were skipped because the shadow already matched
+//returns RFIDR_SUCCESS on successful read
+
+rfidr_error_t read_tx_ram_shadow_stats(uint32_t * p_bytes_written, uint32_t * p_bytes_skipped);
+
+//function for zeroing the TX RAM written/skipped byte counters
+
+void clear_tx_ram_shadow_stats(void);
+
 #endif
@@ -45,6 +45,7 @@
 #include "rfidr_error.h"
 #include "rfidr_gpio.h"
 #include "rfidr_spi.h"
+#include "rfidr_sx1257.h"
 #include "rfidr_txradio.h"
 #include "rfidr_user.h"
 
@@ -278,6 +279,7 @@ rfidr_error_t    set_go_radio_oneshot(void)
     spi_cntrlr_read_rx(&recovery_byte);
     recovery_byte    &=    (uint8_t)252;        //Retain all information except for clock status signals (2LSB).
     recovery_byte    |=    (uint8_t)(1 << 0);
+    invalidate_sx1257_lna_gain_shadow();    //The FPGA gain loop may move the LNA gain during the run.
     //Write the register with the old data and the new one-shot bit added in.
     spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)0, recovery_byte);
     spi_cntrlr_send_recv();
@@ -764,3 +766,26 @@ rfidr_error_t    set_tx_zgn_offset(uint8_t offset)
     }
     return RFIDR_SUCCESS;
 }
+
+//This function sets both TX offsets at once. They make up the whole register, so there is no need to read it first.
+rfidr_error_t    set_tx_offsets(uint8_t sdm_offset, uint8_t zgn_offset)
+{
+    uint8_t    write_byte       =    ((sdm_offset << 4) & (uint8_t)0xF0) | (zgn_offset & (uint8_t)0x0F);
+    uint8_t    recovery_byte    =    0;
+
+    //Write to the register
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, (uint16_t)7, write_byte);
+    spi_cntrlr_send_recv();
+    //Read back from the register to ensure that the correct data was written.
+    spi_cntrlr_set_tx(RFIDR_USER_MEM, RFIDR_SPI_READ, RFIDR_SPI_TXRAM, (uint16_t)7, 0);
+    spi_cntrlr_send_recv();
+    spi_cntrlr_read_rx(&recovery_byte);
+    if(recovery_byte == write_byte)
+    {
+        return RFIDR_SUCCESS;
+    }
+    else
+    {
+        return RFIDR_ERROR_USER_MEM;
+    }
+}
@@ -79,5 +79,6 @@ rfidr_error_t    set_sx1257_pll_chk_mode(void);
 rfidr_error_t    unset_sx1257_pll_chk_mode(void);
 rfidr_error_t    set_tx_sdm_offset(uint8_t offset);
 rfidr_error_t    set_tx_zgn_offset(uint8_t offset);
+rfidr_error_t    set_tx_offsets(uint8_t sdm_offset, uint8_t zgn_offset);
 
 #endif
\ No newline at end of file
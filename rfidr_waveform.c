@@ -61,46 +61,26 @@ rfidr_error_t     rfidr_push_waveform_data_over_ble(ble_rfidrs_t * p_rfidrs)
     uint16_t        loop_bytes                                        =    0;
     uint8_t            counter                                            =    0;
     uint8_t            message_buffer[BLE_RFIDRS_WAVFM_DATA_CHAR_LEN]    =    {0};
-    uint8_t            recovery_byte                                    =    0;
     uint32_t        error_code                                        =    NRF_SUCCESS;
 
-    for(loop_bytes=0;loop_bytes < WAVEFORM_MEMORY_DEPTH_IN_BYTES;loop_bytes++)
+    //Read the waveform memory one BTLE packet's worth (20 bytes as of 6/19/2019) at a time, using a burst read for each packet.
+    //The final packet is shorter since 8192 is not a multiple of the packet length.
+    for(loop_bytes=0;loop_bytes < WAVEFORM_MEMORY_DEPTH_IN_BYTES;loop_bytes+=counter)
     {
+        counter    =    (WAVEFORM_MEMORY_DEPTH_IN_BYTES-loop_bytes > BLE_RFIDRS_WAVFM_DATA_CHAR_LEN) ? BLE_RFIDRS_WAVFM_DATA_CHAR_LEN : (uint8_t)(WAVEFORM_MEMORY_DEPTH_IN_BYTES-loop_bytes);
+
         //Read bytes out of FPGA waveform memory.
-        spi_cntrlr_set_tx(RFIDR_WVFM_MEM, RFIDR_SPI_READ, RFIDR_SPI_RXRAM, loop_bytes, 0);
-        spi_cntrlr_send_recv();
-        spi_cntrlr_read_rx(&recovery_byte);
-        message_buffer[counter]    =    recovery_byte;
+        spi_cntrlr_read_burst(RFIDR_WVFM_MEM, RFIDR_SPI_RXRAM, loop_bytes, counter, message_buffer);
 
-        counter++;
-        //If we're done reading the memory, send off a BTLE packet back to the iDevice.
-        if(loop_bytes >= WAVEFORM_MEMORY_DEPTH_IN_BYTES-1)
+        //Send off a BTLE packet back to the iDevice.
+        do
         {
-            do
-            {
-                error_code=ble_rfidrs_wavfm_data_send(p_rfidrs, message_buffer, counter);
-            }while(error_code == BLE_ERROR_NO_TX_BUFFERS);
+            error_code=ble_rfidrs_wavfm_data_send(p_rfidrs, message_buffer, counter);
+        }while(error_code == BLE_ERROR_NO_TX_BUFFERS);
 
-            if (error_code != NRF_ERROR_INVALID_STATE)
-            {
-                APP_ERROR_CHECK(error_code);
-            }
-            counter=0;
-        }
-        //If we've added as much data to the message buffer as will fit in a BTLE packet (20 bytes as of 6/19/2019),
-        //send a BTLE packet to the iDevice.
-        else if(counter>=BLE_RFIDRS_WAVFM_DATA_CHAR_LEN)
+        if (error_code != NRF_ERROR_INVALID_STATE)
         {
-            do
-            {
-                error_code=ble_rfidrs_wavfm_data_send(p_rfidrs, message_buffer, BLE_RFIDRS_WAVFM_DATA_CHAR_LEN);
-            }while(error_code == BLE_ERROR_NO_TX_BUFFERS);
-
-            if (error_code != NRF_ERROR_INVALID_STATE)
-            {
-                APP_ERROR_CHECK(error_code);
-            }
-            counter=0;
+            APP_ERROR_CHECK(error_code);
         }
     }
 
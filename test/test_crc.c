@@ -0,0 +1,188 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Gen2 CRC Host Test                                   //
+//                                                                              //
+// Filename: test_crc.c                                                         //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file checks the table-driven CRC-5 and CRC-16 in rfidr_crc.c against //
+//    bit-serial versions of the Annex F shift registers over random frames,    //
+//    checks the CRC-16 residue on frames with their CRC appended, and times    //
+//    the table-driven and bit-serial versions against each other.              //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "rfidr_crc.h"
+#include "test_util.h"
+
+//Bit-serial CRC-5 straight from Annex F: register preset to 01001b, polynomial x^5+x^3+1, bits shifted in MSB first.
+static uint8_t serial_crc5(uint32_t bits, uint8_t num_bits)
+{
+    uint8_t    state       =    RFIDR_CRC5_PRESET;
+    uint8_t    loop_bit    =    0;
+    uint8_t    xor_bit     =    0;
+
+    for(loop_bit=0;loop_bit < num_bits;loop_bit++)
+    {
+        xor_bit    =    (uint8_t)(((bits >> (num_bits-1-loop_bit)) ^ (state >> 4)) & 1);
+        state      =    (uint8_t)(((state << 1) ^ (xor_bit ? 0x09 : 0x00)) & 31);
+    }
+
+    return state;
+}
+
+//Bit-serial CRC-16 register from Annex F: preset to all ones, polynomial x^16+x^12+x^5+1, bits shifted in MSB first.
+static uint16_t serial_crc16_run(const uint8_t * p_data, uint16_t num_bits)
+{
+    uint16_t   state       =    RFIDR_CRC16_PRESET;
+    uint16_t   loop_bit    =    0;
+    uint16_t   xor_bit     =    0;
+
+    for(loop_bit=0;loop_bit < num_bits;loop_bit++)
+    {
+        xor_bit    =    (uint16_t)(((p_data[loop_bit >> 3] >> (7-(loop_bit & 7))) ^ (state >> 15)) & 1);
+        state      =    (uint16_t)((state << 1) ^ (xor_bit ? 0x1021 : 0x0000));
+    }
+
+    return state;
+}
+
+//Write num_bits bits of value, MSB first, into a packed bit buffer starting at bit_offset.
+static void put_bits(uint8_t * p_data, uint16_t bit_offset, uint32_t value, uint8_t num_bits)
+{
+    uint8_t     loop_bit    =    0;
+    uint16_t    bit_index   =    0;
+
+    for(loop_bit=0;loop_bit < num_bits;loop_bit++)
+    {
+        bit_index    =    bit_offset+loop_bit;
+        if((value >> (num_bits-1-loop_bit)) & 1)
+            p_data[bit_index >> 3]    |=    (uint8_t)(0x80 >> (bit_index & 7));
+        else
+            p_data[bit_index >> 3]    &=    (uint8_t)~(0x80 >> (bit_index & 7));
+    }
+}
+
+ // Longest random frame, in bits. An EPC Read reply with a 96-bit EPC is 1+16*6+16+16 = 129 bits, so this covers the longest reply and then some.
+#define TEST_MAX_FRAME_BITS    512
+ // Number of random frames in each check.
+#define TEST_NUM_FRAMES        20000
+
+static uint8_t m_frame[TEST_MAX_FRAME_BITS/8+4];
+
+static void test_crc5_matches_serial(void)
+{
+    uint32_t    loop_frames    =    0;
+    uint32_t    bits           =    0;
+    uint8_t     num_bits       =    0;
+
+    for(loop_frames=0;loop_frames < TEST_NUM_FRAMES;loop_frames++)
+    {
+        num_bits    =    (uint8_t)(test_rand() % 33);
+        bits        =    test_rand() & (num_bits == 32 ? 0xFFFFFFFF : ((1UL << num_bits)-1));
+        TEST_CHECK(rfidr_crc5_compute(bits,num_bits) == serial_crc5(bits,num_bits));
+    }
+
+    //A Query is 17 bits followed by its CRC-5. Running the register over the whole 22 bits must leave it at zero.
+    for(loop_frames=0;loop_frames < TEST_NUM_FRAMES;loop_frames++)
+    {
+        bits        =    test_rand() & ((1UL << 17)-1);
+        TEST_CHECK(serial_crc5((bits << 5) | rfidr_crc5_compute(bits,17),22) == 0);
+    }
+}
+
+static void test_crc16_matches_serial(void)
+{
+    uint32_t    loop_frames    =    0;
+    uint16_t    loop_byte      =    0;
+    uint16_t    num_bits       =    0;
+
+    for(loop_frames=0;loop_frames < TEST_NUM_FRAMES;loop_frames++)
+    {
+        num_bits    =    (uint16_t)(test_rand() % (TEST_MAX_FRAME_BITS+1));
+        for(loop_byte=0;loop_byte < sizeof(m_frame);loop_byte++){m_frame[loop_byte] = (uint8_t)test_rand();}
+
+        TEST_CHECK(rfidr_crc16_compute(m_frame,num_bits) == (uint16_t)~serial_crc16_run(m_frame,num_bits));
+    }
+}
+
+//Append the CRC-16 to random frames of every length and alignment: the check must pass, and must fail once any single bit is flipped.
+static void test_crc16_residue(void)
+{
+    uint32_t    loop_frames    =    0;
+    uint16_t    loop_byte      =    0;
+    uint16_t    num_bits       =    0;
+    uint16_t    flip_bit       =    0;
+    uint16_t    crc16          =    0;
+
+    for(loop_frames=0;loop_frames < TEST_NUM_FRAMES;loop_frames++)
+    {
+        num_bits    =    (uint16_t)(test_rand() % (TEST_MAX_FRAME_BITS-15));
+        for(loop_byte=0;loop_byte < sizeof(m_frame);loop_byte++){m_frame[loop_byte] = (uint8_t)test_rand();}
+
+        crc16       =    rfidr_crc16_compute(m_frame,num_bits);
+        put_bits(m_frame,num_bits,crc16,16);
+        TEST_CHECK(serial_crc16_run(m_frame,num_bits+16) == RFIDR_CRC16_RESIDUE);
+        TEST_CHECK(rfidr_crc16_check(m_frame,num_bits+16));
+
+        flip_bit    =    (uint16_t)(test_rand() % (num_bits+16));
+        m_frame[flip_bit >> 3]    ^=    (uint8_t)(0x80 >> (flip_bit & 7));
+        TEST_CHECK(!rfidr_crc16_check(m_frame,num_bits+16));
+    }
+
+    TEST_CHECK(!rfidr_crc16_check(m_frame,15));
+}
+
+//Catalogue check values: CRC-16/GENIBUS of "123456789" is 0xD64E, and its residue is 0x1D0F.
+static void test_crc16_genibus(void)
+{
+    static const uint8_t    check_string[]    =    "123456789";
+    uint16_t                crc16             =    rfidr_crc16_compute(check_string,72);
+
+    TEST_CHECK(crc16 == 0xD64E);
+
+    memcpy(m_frame,check_string,9);
+    m_frame[9]     =    (uint8_t)(crc16 >> 8);
+    m_frame[10]    =    (uint8_t)crc16;
+    TEST_CHECK(rfidr_crc16_check(m_frame,88));
+}
+
+static void test_crc_benchmark(void)
+{
+    uint16_t    loop_byte    =    0;
+
+    for(loop_byte=0;loop_byte < sizeof(m_frame);loop_byte++){m_frame[loop_byte] = (uint8_t)test_rand();}
+
+    TEST_BENCH("CRC-5 of a 17-bit Query, bit-serial", 4096, m_test_sink += serial_crc5(loop_calls & 0x1FFFF,17));
+    TEST_BENCH("CRC-5 of a 17-bit Query, table", 4096, m_test_sink += rfidr_crc5_compute(loop_calls & 0x1FFFF,17));
+    TEST_BENCH("CRC-16 check of a 129-bit reply, bit-serial", 4096, m_frame[0] = (uint8_t)loop_calls; m_test_sink += serial_crc16_run(m_frame,129));
+    TEST_BENCH("CRC-16 check of a 129-bit reply, table", 4096, m_frame[0] = (uint8_t)loop_calls; m_test_sink += rfidr_crc16_check(m_frame,129));
+}
+
+int main(void)
+{
+    test_crc5_matches_serial();
+    test_crc16_matches_serial();
+    test_crc16_residue();
+    test_crc16_genibus();
+    test_crc_benchmark();
+    return test_finish("test_crc");
+}
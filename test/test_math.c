@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Fixed-Point Math Host Test                           //
+//                                                                              //
+// Filename: test_math.c                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file checks the CORDIC vectoring, log2 and dB kernels in rfidr_math.c//
+//    against the host C library in double precision over random inputs of every//
+//    magnitude, and times each kernel next to its libm counterpart. The libm   //
+//    lines use the host FPU, which the Cortex-M0 does not have, so they are    //
+//    only there to put the fixed-point timings in scale.                       //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include "rfidr_math.h"
+#include "test_util.h"
+
+ // Number of random inputs in each check.
+#define TEST_NUM_INPUTS        100000
+ // Largest allowed errors. The phase limit covers the rounding of the 16 atan table entries; the dB limit is the one promised in rfidr_math.h.
+#define TEST_MAX_MAG_REL_ERR   2e-4
+#define TEST_MAX_PHASE_ERR     8.0
+#define TEST_MAX_LOG2_ERR      (2.0/(1 << RFIDR_MATH_LOG2_FRAC_BITS))
+#define TEST_MAX_DB20_ERR      0.01
+
+//Random value with a random number of significant bits and a random sign, so that every normalization shift is exercised.
+static int32_t test_rand_scaled(void)
+{
+    uint8_t    num_bits    =    (uint8_t)(test_rand() % 32);
+    int32_t    value       =    (int32_t)(test_rand() & ((1UL << num_bits)-1));
+
+    return (test_rand() & 1) ? -value : value;
+}
+
+//Distance between a phase in 65536ths of a circle and the expected one, the short way round.
+static double phase_error(uint16_t phase, double expected)
+{
+    double    error    =    fmod((double)phase-expected+2*65536.0,65536.0);
+
+    return (error > 32768.0) ? 65536.0-error : error;
+}
+
+static void check_cordic(int32_t x, int32_t y)
+{
+    uint32_t    magnitude    =    0;
+    uint16_t    phase        =    0;
+    double      expected     =    hypot((double)x,(double)y);
+
+    rfidr_math_cordic_vector(x,y,&magnitude,&phase);
+
+    if(x == 0 && y == 0)
+    {
+        TEST_CHECK(magnitude == 0 && phase == 0);
+        return;
+    }
+
+    TEST_CHECK(fabs((double)magnitude-expected) <= expected*TEST_MAX_MAG_REL_ERR+1.0);
+    TEST_CHECK(phase_error(phase,atan2((double)y,(double)x)*65536.0/(2*M_PI)) <= TEST_MAX_PHASE_ERR);
+}
+
+static void test_cordic(void)
+{
+    uint32_t    loop_inputs    =    0;
+
+    for(loop_inputs=0;loop_inputs < TEST_NUM_INPUTS;loop_inputs++)
+    {
+        check_cordic(test_rand_scaled(),test_rand_scaled());
+    }
+
+    //The axes, the diagonals and the ends of the input range.
+    check_cordic(0,0);
+    check_cordic(1,0);
+    check_cordic(0,1);
+    check_cordic(-1,0);
+    check_cordic(0,-1);
+    check_cordic(1000,1000);
+    check_cordic(-1000,1000);
+    check_cordic(INT32_MAX,INT32_MAX);
+    check_cordic(INT32_MIN+1,INT32_MIN+1);
+    check_cordic(INT32_MIN+1,INT32_MAX);
+}
+
+static void test_log2_db20(void)
+{
+    uint32_t    loop_inputs    =    0;
+    uint32_t    value          =    0;
+
+    TEST_CHECK(rfidr_math_log2(0) == 0);
+    TEST_CHECK(rfidr_math_db20(0) == 0);
+    TEST_CHECK(rfidr_math_log2(1) == 0);
+    TEST_CHECK(rfidr_math_log2(0x80000000UL) == (31UL << RFIDR_MATH_LOG2_FRAC_BITS));
+
+    for(loop_inputs=0;loop_inputs < TEST_NUM_INPUTS;loop_inputs++)
+    {
+        value    =    (test_rand() >> (test_rand() % 32)) | 1;
+        TEST_CHECK(fabs(rfidr_math_log2(value)/(double)(1 << RFIDR_MATH_LOG2_FRAC_BITS)-log2(value)) <= TEST_MAX_LOG2_ERR);
+        TEST_CHECK(fabs(rfidr_math_db20(value)/256.0-20.0*log10(value)) <= TEST_MAX_DB20_ERR);
+    }
+
+    TEST_CHECK(fabs(rfidr_math_db20(0xFFFFFFFFUL)/256.0-20.0*log10(4294967295.0)) <= TEST_MAX_DB20_ERR);
+}
+
+ // Inputs for the benchmarks, drawn up front so that the random generator stays out of the timed loops.
+#define TEST_BENCH_INPUTS      1024
+
+static int32_t     m_bench_x[TEST_BENCH_INPUTS];
+static int32_t     m_bench_y[TEST_BENCH_INPUTS];
+static uint32_t    m_bench_value[TEST_BENCH_INPUTS];
+
+static void test_math_benchmark(void)
+{
+    uint32_t    loop_inputs    =    0;
+    uint32_t    magnitude      =    0;
+    uint16_t    phase          =    0;
+
+    for(loop_inputs=0;loop_inputs < TEST_BENCH_INPUTS;loop_inputs++)
+    {
+        m_bench_x[loop_inputs]        =    test_rand_scaled();
+        m_bench_y[loop_inputs]        =    test_rand_scaled();
+        m_bench_value[loop_inputs]    =    (test_rand() >> (test_rand() % 32)) | 1;
+    }
+
+    TEST_BENCH("CORDIC magnitude and phase", TEST_BENCH_INPUTS, rfidr_math_cordic_vector(m_bench_x[loop_calls],m_bench_y[loop_calls],&magnitude,&phase); m_test_sink += magnitude+phase);
+    TEST_BENCH("hypot and atan2 (libm, host FPU)", TEST_BENCH_INPUTS, m_test_sink += (uint32_t)hypot(m_bench_x[loop_calls],m_bench_y[loop_calls])+(uint32_t)(atan2(m_bench_y[loop_calls],m_bench_x[loop_calls])*10430.0+32768.0));
+    TEST_BENCH("log2, Q5.12", TEST_BENCH_INPUTS, m_test_sink += rfidr_math_log2(m_bench_value[loop_calls]));
+    TEST_BENCH("log2 (libm, host FPU)", TEST_BENCH_INPUTS, m_test_sink += (uint32_t)(log2(m_bench_value[loop_calls])*4096.0));
+    TEST_BENCH("20*log10, Q8.8", TEST_BENCH_INPUTS, m_test_sink += rfidr_math_db20(m_bench_value[loop_calls]));
+    TEST_BENCH("20*log10 (libm, host FPU)", TEST_BENCH_INPUTS, m_test_sink += (uint32_t)(20.0*log10(m_bench_value[loop_calls])*256.0));
+}
+
+int main(void)
+{
+    test_cordic();
+    test_log2_db20();
+    test_math_benchmark();
+    return test_finish("test_math");
+}
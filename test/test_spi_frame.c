@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware SPI Frame Encoding Host Test                         //
+//                                                                              //
+// Filename: test_spi_frame.c                                                   //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file checks the table-driven SPI frame encoding in rfidr_spi.c       //
+//    against the original switch-based encoder, over every FPGA memory,        //
+//    read/write and RX/TX RAM combination, and times both of them.             //
+//    rfidr_spi.c is included directly so that its static encoders can be       //
+//    reached; the few SDK calls it makes are stubbed out below.                //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#include "nrf.h"
+
+//The SPI burst wait sleeps with __WFE when the SoftDevice is disabled. There is nothing to wait for on the host.
+//The burst also reads IPSR to tell thread mode from an interrupt. The tests always run in thread mode.
+
+#define __WFE()        test_wfe()
+#define __get_IPSR()   test_get_ipsr()
+
+static void test_wfe(void)
+{
+}
+
+static uint32_t test_get_ipsr(void)
+{
+    return 0;
+}
+
+#include "../rfidr_spi.c"
+#include "test_util.h"
+
+//Stubs for the SDK and SPI driver calls made by rfidr_spi.c. The SPI loops the transmitted frame straight back.
+
+uint32_t * spi_cntrlr_init_fast(SPI_module_number_t spi_num, SPI_config_t * spi_config)
+{
+    return NULL;
+}
+
+void spi_cntrlr_set_frequency(SPI_module_number_t spi_num, SPI_frequency_t frequency)
+{
+}
+
+bool spi_cntrlr_tx_rx(SPI_module_number_t spi_num, uint16_t transfer_size, const uint8_t *tx_data, uint8_t *rx_data)
+{
+    memcpy(rx_data, tx_data, transfer_size);
+    return true;
+}
+
+bool spi_cntrlr_tx_rx_frames(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data)
+{
+    memcpy(rx_data, tx_data, frame_size*num_frames);
+    return true;
+}
+
+bool spi_cntrlr_tx_rx_frames_async(SPI_module_number_t spi_num, uint16_t frame_size, uint16_t num_frames, const uint8_t *tx_data, uint8_t *rx_data,
+                                   spi_cntrlr_frames_handler_t handler, void *p_context)
+{
+    memcpy(rx_data, tx_data, frame_size*num_frames);
+    if(handler != NULL){handler(p_context);}
+    return true;
+}
+
+uint32_t sd_softdevice_is_enabled(uint8_t * p_softdevice_enabled)
+{
+    *p_softdevice_enabled    =    0;
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_app_evt_wait(void)
+{
+    return NRF_SUCCESS;
+}
+
+void app_error_handler(uint32_t error_code, uint32_t line_num, const uint8_t * p_file_name)
+{
+}
+
+//The frame encoder as it was before the header table, kept here as the reference.
+static uint8_t m_legacy_frame[TX_RX_MSG_LENGTH];
+
+static void legacy_set_tx(spi_mem_t spi_mem, spi_wr_t wr, spi_rxntx_ram_t rxntx, uint16_t addr, uint8_t data)
+{
+    uint32_t temp         =    0;
+    uint32_t addr_mask    =     (1<<3) -1;
+    uint32_t byte_mask    =    (1<<8)  -1;
+
+    switch(spi_mem){
+        case RFIDR_WVFM_MEM:
+            addr_mask    =     (1<<13) -1;
+            temp         = temp | (1 << 21);
+            temp         = temp | ((addr & addr_mask) << 8);
+            break;
+        case RFIDR_RDIO_MEM:
+            addr_mask    =     (1<<9) -1;
+            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22);
+            temp         = temp | (1 << 20);
+            temp         = temp | ((rxntx == RFIDR_SPI_RXRAM) << 17);
+            temp         = temp | ((addr & addr_mask) << 8);
+            break;
+        case RFIDR_TXCN_MEM:
+            addr_mask    =     (1<<10) -1;
+            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22);
+            temp         = temp | (1 << 19);
+            temp         = temp | ((addr & addr_mask) << 8);
+            break;
+        default:
+            addr_mask    =     (1<<3) -1;
+            temp         = temp | ((wr == RFIDR_SPI_WRITE) << 22);
+            temp         = temp | (1 << 18);
+            temp         = temp | ((addr & addr_mask) << 8);
+            break;
+    }
+
+    temp                 = temp | (byte_mask & data);
+    temp                 = temp << 9;
+
+    m_legacy_frame[0]    =    (temp >> 24) & byte_mask;
+    m_legacy_frame[1]    =    (temp >> 16) & byte_mask;
+    m_legacy_frame[2]    =    (temp >> 8) & byte_mask;
+    m_legacy_frame[3]    =    (temp >> 0) & byte_mask;
+}
+
+ // Number of frames encoded in each timed loop.
+#define TEST_NUM_FRAMES    4096
+
+static uint16_t m_test_addr[TEST_NUM_FRAMES];
+static uint8_t  m_test_data[TEST_NUM_FRAMES];
+
+//Every memory, read/write and RX/TX half, with every address up to the widest mask and a spread of data bytes.
+static void test_frames_match(void)
+{
+    uint8_t     loop_mem     =    0;
+    uint8_t     loop_wr      =    0;
+    uint8_t     loop_rxntx   =    0;
+    uint32_t    loop_addr    =    0;
+    uint8_t     data         =    0;
+    uint8_t     frame[TX_RX_MSG_LENGTH];
+
+    for(loop_mem=0;loop_mem <= RFIDR_USER_MEM+1;loop_mem++)
+    {
+        for(loop_wr=0;loop_wr < 2;loop_wr++)
+        {
+            for(loop_rxntx=0;loop_rxntx < 2;loop_rxntx++)
+            {
+                for(loop_addr=0;loop_addr < (1<<14);loop_addr++)
+                {
+                    data    =    (uint8_t)test_rand();
+
+                    legacy_set_tx((spi_mem_t)loop_mem, (spi_wr_t)loop_wr, (spi_rxntx_ram_t)loop_rxntx, (uint16_t)loop_addr, data);
+                    spi_cntrlr_set_tx((spi_mem_t)loop_mem, (spi_wr_t)loop_wr, (spi_rxntx_ram_t)loop_rxntx, (uint16_t)loop_addr, data);
+                    TEST_CHECK(memcmp(m_tx_data_spi, m_legacy_frame, TX_RX_MSG_LENGTH) == 0);
+
+                    //The burst path takes the header and mask once per burst, which is only done for the radio and waveform memories.
+                    if(loop_mem == RFIDR_WVFM_MEM || loop_mem == RFIDR_RDIO_MEM)
+                    {
+                        spi_cntrlr_encode_frame_fast(spi_cntrlr_frame_header((spi_mem_t)loop_mem, (spi_wr_t)loop_wr, (spi_rxntx_ram_t)loop_rxntx),
+                                                     m_spi_frame_addr_mask[loop_mem], (uint16_t)loop_addr, data, frame);
+                        TEST_CHECK(memcmp(frame, m_legacy_frame, TX_RX_MSG_LENGTH) == 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//Each encoded frame is folded into the sink so that none of the encodes can be dropped by the optimizer.
+static void test_frames_benchmark(void)
+{
+    uint32_t    loop_frames    =    0;
+    uint32_t    header         =    spi_cntrlr_frame_header(RFIDR_RDIO_MEM, RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM);
+    uint8_t     frame[TX_RX_MSG_LENGTH];
+
+    for(loop_frames=0;loop_frames < TEST_NUM_FRAMES;loop_frames++)
+    {
+        m_test_addr[loop_frames]    =    (uint16_t)test_rand();
+        m_test_data[loop_frames]    =    (uint8_t)test_rand();
+    }
+
+    TEST_BENCH("switch encoder (before)", TEST_NUM_FRAMES,
+               legacy_set_tx((spi_mem_t)(loop_calls & 3), RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, m_test_addr[loop_calls], m_test_data[loop_calls]);
+               m_test_sink    +=    m_legacy_frame[1]);
+
+    TEST_BENCH("spi_cntrlr_set_tx (header table)", TEST_NUM_FRAMES,
+               spi_cntrlr_set_tx((spi_mem_t)(loop_calls & 3), RFIDR_SPI_WRITE, RFIDR_SPI_TXRAM, m_test_addr[loop_calls], m_test_data[loop_calls]);
+               m_test_sink    +=    m_tx_data_spi[1]);
+
+    TEST_BENCH("spi_cntrlr_encode_frame_fast (burst)", TEST_NUM_FRAMES,
+               spi_cntrlr_encode_frame_fast(header, m_spi_frame_addr_mask[RFIDR_RDIO_MEM], m_test_addr[loop_calls], m_test_data[loop_calls], frame);
+               m_test_sink    +=    frame[1]);
+}
+
+int main(void)
+{
+    test_frames_match();
+    test_frames_benchmark();
+    return test_finish("test_spi_frame");
+}
@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////////
+//                                                                              //
+// Module : RFIDr Firmware Host Test Helpers                                    //
+//                                                                              //
+// Filename: test_util.h                                                        //
+// Creation Date: 10/16/2026                                                    //
+// Author: S.U.R.F.E.R. firmware contributors                                   //
+//                                                                              //
+//    Copyright 2026 S.U.R.F.E.R. firmware contributors                         //
+//                                                                              //
+//    Licensed under the Apache License, Version 2.0 (the "License");           //
+//    you may not use this file except in compliance with the License.          //
+//    You may obtain a copy of the License at                                   //
+//                                                                              //
+//       http://www.apache.org/licenses/LICENSE-2.0                             //
+//                                                                              //
+//    Unless required by applicable law or agreed to in writing, software       //
+//    distributed under the License is distributed on an "AS IS" BASIS,         //
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  //
+//    See the License for the specific language governing permissions and       //
+//    limitations under the License.                                            //
+//                                                                              //
+// Description:                                                                 //
+//                                                                              //
+//    This file contains the check and timing helpers shared by the host-built  //
+//    unit tests and benchmarks in this directory.                              //
+//    Timings are taken with the host cycle counter where there is one, so they //
+//    are only good for comparing two versions of the same code. They are not   //
+//    Cortex-M0 cycle counts.                                                   //
+//                                                                              //
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEST_UTIL_H__
+#define TEST_UTIL_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+//Number of failed checks in this test program. main() returns it so that make stops on a failure.
+
+static unsigned int m_test_failures = 0;
+
+#define TEST_CHECK(cond)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if(!(cond))                                                                         \
+        {                                                                                   \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                 \
+            m_test_failures++;                                                              \
+        }                                                                                   \
+    } while(0)
+
+//Free running host time stamp: the time stamp counter on x86, otherwise the monotonic clock in ns.
+
+static inline uint64_t test_time_stamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec    now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000000ULL+(uint64_t)now.tv_nsec;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEST_TIME_UNIT    "cycles"
+#else
+#define TEST_TIME_UNIT    "ns"
+#endif
+
+//Small xorshift generator so that the random test vectors are the same on every host.
+
+static uint32_t m_test_rand_state = 0x2545F491;
+
+static inline uint32_t test_rand(void)
+{
+    m_test_rand_state    ^=    m_test_rand_state << 13;
+    m_test_rand_state    ^=    m_test_rand_state >> 17;
+    m_test_rand_state    ^=    m_test_rand_state << 5;
+    return m_test_rand_state;
+}
+
+//Print one benchmark line: the time per call of a loop of num_calls calls that took elapsed time stamp ticks.
+
+static inline void test_report(const char * p_name, uint64_t elapsed, uint32_t num_calls)
+{
+    printf("  %-44s %8.1f %s/call\n", p_name, (double)elapsed/(double)num_calls, TEST_TIME_UNIT);
+}
+
+ // Number of times each benchmark loop is run. The fastest run is reported, which filters out interrupts and cache warm up.
+#define TEST_BENCH_RUNS    16
+
+//Time a loop of num_calls calls, where body makes call number loop_calls.
+//Results that would otherwise be thrown away should be folded into m_test_sink so that the compiler has to keep the calls.
+
+static volatile uint32_t m_test_sink;
+
+#define TEST_BENCH(p_name, num_calls, body)                                                 \
+    do                                                                                      \
+    {                                                                                       \
+        uint32_t    loop_runs     =    0;                                                   \
+        uint32_t    loop_calls    =    0;                                                   \
+        uint64_t    start         =    0;                                                   \
+        uint64_t    best          =    UINT64_MAX;                                          \
+                                                                                            \
+        for(loop_runs=0;loop_runs < TEST_BENCH_RUNS;loop_runs++)                            \
+        {                                                                                   \
+            start    =    test_time_stamp();                                                \
+            for(loop_calls=0;loop_calls < (num_calls);loop_calls++)                         \
+            {                                                                               \
+                body;                                                                       \
+            }                                                                               \
+            if(test_time_stamp()-start < best){best = test_time_stamp()-start;}             \
+        }                                                                                   \
+        test_report(p_name, best, (num_calls));                                             \
+    } while(0)
+
+//Print the test program result and turn it into an exit code.
+
+static inline int test_finish(const char * p_name)
+{
+    printf("%s: %s (%u failed checks)\n", p_name, m_test_failures ? "FAIL" : "PASS", m_test_failures);
+    return m_test_failures ? 1 : 0;
+}
+
+#endif